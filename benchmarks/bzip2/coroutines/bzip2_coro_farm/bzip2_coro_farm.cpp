@@ -0,0 +1,175 @@
+#include <bzip2.hpp>
+#include <queue>
+#include <algorithm>
+#include "Coro_Pipeline.hpp"
+
+/* Number of in-flight batches per channel */
+#define QUEUESIZE 1
+
+struct compare_item{
+	bool operator()(spb::Item * i1, spb::Item * i2){
+		return (i1->batch_index > i2->batch_index);
+	}
+};
+
+/* Worker replicas are coroutines, so they can outnumber the pool threads (-u <replicas>) */
+int replicas(){
+	if(spb::SPBench::userArgs.empty())
+		return spb::nthreads;
+	return std::max(1, atoi(spb::SPBench::getArg(0).c_str()));
+}
+
+coro::task comp_emitter(coro::executor & exec, coro::event & slot_freed, coro::channel<spb::Item*> & out){
+	while(1){
+		// frequency control and the tuning gate suspend the emitter instead of blocking its thread
+		unsigned long delay;
+		while((delay = spb::SPBench::item_frequency_delay(spb::Source::source_item_timestamp)) > 0)
+			co_await exec.sleep_for(std::chrono::microseconds(delay));
+		while(!spb::SPBench::in_flight_try_control())
+			co_await slot_freed.wait();
+
+		spb::Item * item = spb::item_pool.acquire();
+		if(!spb::Source::op(*item)){
+			spb::SPBench::in_flight_cancel();
+			spb::item_pool.release(item);
+			break;
+		}
+		co_await out.push(item);
+	}
+	out.producer_done();
+}
+
+coro::task comp_worker(coro::channel<spb::Item*> & in, coro::channel<spb::Item*> & out){
+	while(1){
+		std::optional<spb::Item*> item = co_await in.pop();
+		if(!item) break;
+		spb::Compress::op(**item);
+		co_await out.push(*item);
+	}
+	out.producer_done();
+}
+
+coro::task comp_collector(coro::channel<spb::Item*> & in){
+	std::priority_queue<spb::Item*, std::vector<spb::Item*>, compare_item> reorder_buffer;
+	int next_index = 0;
+	while(1){
+		std::optional<spb::Item*> item = co_await in.pop();
+		if(!item) break;
+		reorder_buffer.push(*item);
+		while(!reorder_buffer.empty() && reorder_buffer.top()->batch_index == next_index){
+			spb::Item * ready = reorder_buffer.top();
+			reorder_buffer.pop();
+			spb::Sink::op(*ready);
+			spb::item_pool.release(ready);
+			next_index++;
+		}
+	}
+}
+
+void compress(){
+
+	spb::Metrics::init();
+
+	int nworkers = replicas();
+	{
+		coro::executor executor(spb::nthreads);
+		coro::event slot_freed(executor); // a batch left the pipeline (tuning gate)
+		spb::SPBench::setInFlightNotify([&](){ slot_freed.set(); });
+		coro::channel<spb::Item*> queue1(executor, spb::SPBench::getQueueCapacity(QUEUESIZE*nworkers), 1);
+		coro::channel<spb::Item*> queue2(executor, spb::SPBench::getQueueCapacity(QUEUESIZE*nworkers), nworkers);
+		// batches held by the emitter, the channels and the workers, and as many
+		// again for the reorder buffer of the collector
+		spb::item_pool.reserve(2 * (queue1.get_capacity() + queue2.get_capacity() + nworkers) + 1);
+
+		executor.spawn(comp_emitter(executor, slot_freed, queue1));
+		for(int i = 0; i < nworkers; i++)
+			executor.spawn(comp_worker(queue1, queue2));
+		executor.spawn(comp_collector(queue2));
+
+		executor.wait();
+		spb::SPBench::setInFlightNotify(nullptr);
+
+		spb::Metrics::stop();
+		executor.print_stats();
+	}
+}
+
+coro::task decomp_emitter(coro::executor & exec, coro::event & slot_freed, coro::channel<spb::Item*> & out){
+	while(1){
+		// frequency control and the tuning gate suspend the emitter instead of blocking its thread
+		unsigned long delay;
+		while((delay = spb::SPBench::item_frequency_delay(spb::Source_d::source_item_timestamp)) > 0)
+			co_await exec.sleep_for(std::chrono::microseconds(delay));
+		while(!spb::SPBench::in_flight_try_control())
+			co_await slot_freed.wait();
+
+		spb::Item * item = spb::item_pool.acquire();
+		if(!spb::Source_d::op(*item)){
+			spb::SPBench::in_flight_cancel();
+			spb::item_pool.release(item);
+			break;
+		}
+		co_await out.push(item);
+	}
+	out.producer_done();
+}
+
+coro::task decomp_worker(coro::channel<spb::Item*> & in, coro::channel<spb::Item*> & out){
+	while(1){
+		std::optional<spb::Item*> item = co_await in.pop();
+		if(!item) break;
+		spb::Decompress::op(**item);
+		co_await out.push(*item);
+	}
+	out.producer_done();
+}
+
+coro::task decomp_collector(coro::channel<spb::Item*> & in){
+	std::priority_queue<spb::Item*, std::vector<spb::Item*>, compare_item> reorder_buffer;
+	int next_index = 0;
+	while(1){
+		std::optional<spb::Item*> item = co_await in.pop();
+		if(!item) break;
+		reorder_buffer.push(*item);
+		while(!reorder_buffer.empty() && reorder_buffer.top()->batch_index == next_index){
+			spb::Item * ready = reorder_buffer.top();
+			reorder_buffer.pop();
+			spb::Sink_d::op(*ready);
+			spb::item_pool.release(ready);
+			next_index++;
+		}
+	}
+}
+
+void decompress(){
+
+	spb::Metrics::init();
+
+	int nworkers = replicas();
+	{
+		coro::executor executor(spb::nthreads);
+		coro::event slot_freed(executor); // a batch left the pipeline (tuning gate)
+		spb::SPBench::setInFlightNotify([&](){ slot_freed.set(); });
+		coro::channel<spb::Item*> queue1(executor, spb::SPBench::getQueueCapacity(QUEUESIZE*nworkers), 1);
+		coro::channel<spb::Item*> queue2(executor, spb::SPBench::getQueueCapacity(QUEUESIZE*nworkers), nworkers);
+		// batches held by the emitter, the channels and the workers, and as many
+		// again for the reorder buffer of the collector
+		spb::item_pool.reserve(2 * (queue1.get_capacity() + queue2.get_capacity() + nworkers) + 1);
+
+		executor.spawn(decomp_emitter(executor, slot_freed, queue1));
+		for(int i = 0; i < nworkers; i++)
+			executor.spawn(decomp_worker(queue1, queue2));
+		executor.spawn(decomp_collector(queue2));
+
+		executor.wait();
+		spb::SPBench::setInFlightNotify(nullptr);
+
+		spb::Metrics::stop();
+		executor.print_stats();
+	}
+}
+
+int main (int argc, char* argv[]){
+	spb::bzip2_main(argc, argv);
+	return 0;
+}
@@ -1,10 +1,11 @@
 #include <bzip2.hpp>
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Emitter_comp: ff::ff_node_t<spb::Item>{
 	spb::Item * svc(spb::Item * task){
 		while (1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source::op(*item)) break;
 		    ff_send_out(item);
 		}
@@ -22,7 +23,7 @@ struct Worker_comp: ff::ff_node_t<spb::Item>{
 struct Collector_comp: ff::ff_node_t<spb::Item>{
 	spb::Item * svc(spb::Item * item){
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return GO_ON;
 	}
 }Collector_comp;
@@ -39,12 +40,12 @@ void compress(){
 	for(int i=0; i<spb::nthreads; i++){
 		workers.push_back(ff::make_unique<Worker_comp>());
 	}
-	ff::ff_OFarm<spb::Item> farm(move(workers));
+	ff::ff_Farm<spb::Item> farm(move(workers));
 	Emitter_comp E;
 	farm.add_emitter(E);
 	farm.add_collector(Collector_comp);
 
-	farm.set_scheduling_ondemand();
+	spb::ff_farm_options(farm, true, true); // ordered, on-demand
 
 	if(farm.run_and_wait_end()<0){
 		std::cout << "error running pipe";
@@ -58,7 +59,7 @@ void compress(){
 struct Emitter_decomp: ff::ff_node_t<spb::Item>{
 	spb::Item * svc(spb::Item * task){
 		while (1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source_d::op(*item)) break;
 		    ff_send_out(item);
 		}
@@ -76,6 +77,7 @@ struct Worker_decomp: ff::ff_node_t<spb::Item>{
 struct Collector_decomp: ff::ff_node_t<spb::Item>{
 	spb::Item * svc(spb::Item * item){
 		spb::Sink_d::op(*item);
+		spb::item_pool.release(item);
 		return GO_ON;
 	}
 }Collector_decomp;
@@ -92,13 +94,13 @@ void decompress(){
 		workers.push_back(ff::make_unique<Worker_decomp>());
 	}
 
-	ff::ff_OFarm<spb::Item> farm(move(workers));
+	ff::ff_Farm<spb::Item> farm(move(workers));
 
 	Emitter_decomp E;
 	farm.add_emitter(E);
 	farm.add_collector(Collector_decomp);
 
-	farm.set_scheduling_ondemand();
+	spb::ff_farm_options(farm, true, true); // ordered, on-demand
 
 	if(farm.run_and_wait_end()<0){
 		std::cout << "error running pipe";
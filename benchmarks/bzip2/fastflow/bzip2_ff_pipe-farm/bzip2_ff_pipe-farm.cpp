@@ -0,0 +1,149 @@
+#include <bzip2.hpp>
+#include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
+
+/* Pipeline of ordered farms: split -> read farm (pread) -> compress farm -> write.
+ * The write stage stays serial since block sizes are only known after compression.
+ */
+
+struct Emitter_comp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * task){
+		while (1){
+			spb::Item * item = spb::item_pool.acquire();
+			if (!spb::Source::op(*item)) break;
+		    ff_send_out(item);
+		}
+		return EOS;
+	}
+};
+
+struct Reader_comp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Read::op(*item);
+		return item;
+	}
+};
+
+struct Worker_comp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Compress::op(*item);
+		return item;
+	}
+};
+
+struct Collector_comp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Sink::op(*item);
+		spb::item_pool.release(item);
+		return GO_ON;
+	}
+}Collector_comp;
+
+
+void compress(){
+
+	spb::Metrics::init();
+
+	/*--------FastFlow region-------*/
+
+	std::vector<std::unique_ptr<ff::ff_node>> readers;
+	std::vector<std::unique_ptr<ff::ff_node>> workers;
+
+	for(int i=0; i<spb::nthreads; i++){
+		readers.push_back(ff::make_unique<Reader_comp>());
+		workers.push_back(ff::make_unique<Worker_comp>());
+	}
+
+	ff::ff_Farm<spb::Item> read_farm(move(readers));
+	Emitter_comp E;
+	read_farm.add_emitter(E);
+	spb::ff_farm_options(read_farm, true, true); // ordered, on-demand
+
+	ff::ff_Farm<spb::Item> farm(move(workers));
+	farm.add_collector(Collector_comp);
+	spb::ff_farm_options(farm, true, true);
+
+	ff::ff_Pipe<> pipe(read_farm, farm);
+	spb::ff_runtime_options(pipe);
+
+	if(pipe.run_and_wait_end()<0){
+		std::cout << "error running pipe";
+	}
+
+	/*------------------------------*/
+
+	spb::Metrics::stop();
+}
+
+struct Emitter_decomp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * task){
+		while (1){
+			spb::Item * item = spb::item_pool.acquire();
+			if (!spb::Source_d::op(*item)) break;
+		    ff_send_out(item);
+		}
+		return EOS;
+	}
+};
+
+struct Reader_decomp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Read::op(*item);
+		return item;
+	}
+};
+
+struct Worker_decomp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Decompress::op(*item);
+		return item;
+	}
+};
+
+struct Collector_decomp: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Sink_d::op(*item);
+		spb::item_pool.release(item);
+		return GO_ON;
+	}
+}Collector_decomp;
+
+void decompress(){
+
+	spb::Metrics::init();
+
+	/*--------FastFlow region-------*/
+
+	std::vector<std::unique_ptr<ff::ff_node>> readers;
+	std::vector<std::unique_ptr<ff::ff_node>> workers;
+
+	for(int i=0; i<spb::nthreads; i++){
+		readers.push_back(ff::make_unique<Reader_decomp>());
+		workers.push_back(ff::make_unique<Worker_decomp>());
+	}
+
+	ff::ff_Farm<spb::Item> read_farm(move(readers));
+	Emitter_decomp E;
+	read_farm.add_emitter(E);
+	spb::ff_farm_options(read_farm, true, true); // ordered, on-demand
+
+	ff::ff_Farm<spb::Item> farm(move(workers));
+	farm.add_collector(Collector_decomp);
+	spb::ff_farm_options(farm, true, true);
+
+	ff::ff_Pipe<> pipe(read_farm, farm);
+	spb::ff_runtime_options(pipe);
+
+	if(pipe.run_and_wait_end()<0){
+		std::cout << "error running pipe";
+	}
+
+	/*------------------------------*/
+	spb::Metrics::stop();
+}
+
+int main (int argc, char* argv[]){
+	spb::deferred_read = true; // blocks are read by the Read stage
+	spb::bzip2_main(argc, argv);
+	return 0;
+}
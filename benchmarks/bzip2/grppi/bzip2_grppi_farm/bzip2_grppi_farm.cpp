@@ -8,39 +8,41 @@ using namespace experimental;
 void run_compress(grppi::dynamic_execution & ex) {
 	tbb::task_scheduler_init init(spb::nthreads);
 	grppi::pipeline(ex,
-		[]() mutable -> optional<spb::Item> {
-			spb::Item item;
-			if(!spb::Source::op(item)) {
+		[]() mutable -> optional<spb::Item*> {
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source::op(*item)) {
+					spb::item_pool.release(item);
 					return {};
 			}
 			return item;
 		},
 		grppi::farm(spb::nthreads,
-			[](spb::Item item) {
-				spb::Compress::op(item);                 
+			[](spb::Item * item) {
+				spb::Compress::op(*item);                 
 				return item;
 		}),
-		[](spb::Item item) {spb::Sink::op(item); }
+		[](spb::Item * item) { spb::Sink::op(*item); spb::item_pool.release(item); }
 	);
 }
 
 void run_decompress(grppi::dynamic_execution & ex) {
 	tbb::task_scheduler_init init(spb::nthreads);
 	grppi::pipeline(ex,
-		[]() mutable -> optional<spb::Item> {
-			spb::Item item;
-			if(!spb::Source_d::op(item)) {
+		[]() mutable -> optional<spb::Item*> {
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source_d::op(*item)) {
+					spb::item_pool.release(item);
 					return {};
 			} else {
 					return item;
 			}
 		},
 		grppi::farm(spb::nthreads,
-			[](spb::Item item) {
-				spb::Decompress::op(item);                 
+			[](spb::Item * item) {
+				spb::Decompress::op(*item);                 
 				return item;
 		}),
-		[](spb::Item item) {spb::Sink_d::op(item); }
+		[](spb::Item * item) { spb::Sink_d::op(*item); spb::item_pool.release(item); }
 	);
 }
 
@@ -48,7 +50,7 @@ grppi::dynamic_execution execution_mode(){
 	string backend = spb::SPBench::getArg(0);
 	if(backend == "tbb"){
 		auto ex = grppi::parallel_execution_tbb(spb::nthreads, true);
-		ex.set_queue_attributes(1, grppi::queue_mode::blocking, spb::nthreads*10);
+		ex.set_queue_attributes(1, grppi::queue_mode::blocking, spb::SPBench::getQueueCapacity(spb::nthreads*10));
 		return ex;
 	} else if (backend == "ff"){
 		auto ex = grppi::parallel_execution_ff(spb::nthreads, true);
@@ -0,0 +1,50 @@
+#ifndef BZIP2_H
+#define BZIP2_H
+
+#include <bzip2_utils.hpp>
+
+namespace spb{
+class Read;
+class Compress;
+class Decompress;
+
+class Read{
+private:
+	static inline void read_op(spb::item_data &item);
+public:
+	static void op(spb::Item &item);
+	Read(spb::Item &item){
+		op(item);
+	}
+    Read(){};
+
+	virtual ~Read(){}
+};
+
+class Compress{
+private:
+	static inline void compress_op(spb::item_data &item);
+public:
+	static void op(spb::Item &item);
+	Compress(spb::Item &item){
+		op(item);
+	}
+    Compress(){};
+
+	virtual ~Compress(){}
+};
+
+class Decompress{
+private:
+	static inline void decompress_op(spb::item_data &item);
+public:
+	static void op(spb::Item &item);
+	Decompress(spb::Item &item){
+		op(item);
+	}
+    Decompress(){};
+	virtual ~Decompress(){}
+};
+
+} // end of namespace spb
+#endif
@@ -101,8 +101,8 @@ void compress(){
 
 	spb::Metrics::init();
 
-	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,1);
-	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
 
 	omp_set_num_threads(spb::nthreads+2);
 	#pragma omp parallel shared(queue1,queue2)
@@ -194,8 +194,8 @@ void decomp_collector(SParSharedQueue<struct data> * queue2){
 void decompress(){
 	spb::Metrics::init();
 
-	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,1);
-	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
 
 	omp_set_num_threads(spb::nthreads+2);
 	#pragma omp parallel shared(queue1,queue2)
@@ -0,0 +1,126 @@
+#include <bzip2.hpp>
+#include <vector>
+#include <omp.h>
+
+/* Farm expressed with OpenMP task dependences instead of queues.
+ * The source runs in the thread generating the tasks. Each batch gets a
+ * worker task depending only on the batch itself, and a sink task that also
+ * depends on a sequence token, so sink tasks run one at a time in stream order.
+ * Batches of the operators are split with taskloop (see operators/include).
+ */
+
+/* Batches in flight allowed per worker thread */
+#define WINDOWSIZE 2
+
+/* Tuning (-A) wait of the source: a task scheduling point on the oldest batch
+ * in flight, so the thread creating the tasks keeps running them meanwhile */
+void wait_oldest_batch(std::vector<char> & window, int window_size, long batch, long & oldest){
+	oldest = std::max(oldest, batch - window_size);
+	if(oldest < batch){
+		#pragma omp taskwait depend(in: window.data()[oldest % window_size])
+		oldest++;
+	}
+}
+
+void compress(){
+
+	spb::Metrics::init();
+
+	int window_size = spb::SPBench::getQueueCapacity(WINDOWSIZE*spb::nthreads);
+
+	// one dependence slot per in-flight batch, reused every window_size batches,
+	// and the sequence token of the serial stage in the last position
+	std::vector<char> window(window_size + 1);
+	// the batches of the window and the one being read by the source
+	spb::item_pool.reserve(window_size + 1);
+
+	omp_set_num_threads(spb::nthreads+1);
+	#pragma omp parallel
+	#pragma omp single
+	{
+		long batch = 0, oldest = 0;
+		// with tuning (-A) the source must not block on the in-flight limit
+		spb::SPBench::setInFlightWait([&](){ wait_oldest_batch(window, window_size, batch, oldest); });
+		while(1){
+			if(batch >= window_size){
+				// wait for the sink of the batch that used this slot
+				#pragma omp taskwait depend(in: window.data()[batch % window_size])
+			}
+
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source::op(*item)){
+				spb::item_pool.release(item);
+				break;
+			}
+
+			#pragma omp task firstprivate(item) depend(out: item[0])
+			{
+				spb::Compress::op(*item);
+			}
+
+			#pragma omp task firstprivate(item) depend(in: item[0]) depend(inout: window.data()[window_size]) depend(out: window.data()[batch % window_size])
+			{
+				spb::Sink::op(*item);
+				spb::item_pool.release(item);
+			}
+			batch++;
+		}
+	} // implicit barrier: every task is done here
+	spb::SPBench::setInFlightWait(nullptr);
+
+	spb::Metrics::stop();
+}
+
+void decompress(){
+
+	spb::Metrics::init();
+
+	int window_size = spb::SPBench::getQueueCapacity(WINDOWSIZE*spb::nthreads);
+
+	// one dependence slot per in-flight batch, reused every window_size batches,
+	// and the sequence token of the serial stage in the last position
+	std::vector<char> window(window_size + 1);
+	// the batches of the window and the one being read by the source
+	spb::item_pool.reserve(window_size + 1);
+
+	omp_set_num_threads(spb::nthreads+1);
+	#pragma omp parallel
+	#pragma omp single
+	{
+		long batch = 0, oldest = 0;
+		// with tuning (-A) the source must not block on the in-flight limit
+		spb::SPBench::setInFlightWait([&](){ wait_oldest_batch(window, window_size, batch, oldest); });
+		while(1){
+			if(batch >= window_size){
+				// wait for the sink of the batch that used this slot
+				#pragma omp taskwait depend(in: window.data()[batch % window_size])
+			}
+
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source_d::op(*item)){
+				spb::item_pool.release(item);
+				break;
+			}
+
+			#pragma omp task firstprivate(item) depend(out: item[0])
+			{
+				spb::Decompress::op(*item);
+			}
+
+			#pragma omp task firstprivate(item) depend(in: item[0]) depend(inout: window.data()[window_size]) depend(out: window.data()[batch % window_size])
+			{
+				spb::Sink_d::op(*item);
+				spb::item_pool.release(item);
+			}
+			batch++;
+		}
+	} // implicit barrier: every task is done here
+	spb::SPBench::setInFlightWait(nullptr);
+
+	spb::Metrics::stop();
+}
+
+int main (int argc, char* argv[]){
+	spb::bzip2_main(argc, argv);
+	return 0;
+}
@@ -0,0 +1,28 @@
+#include <bzip2.hpp>
+
+namespace spb{
+
+// replayed in isolation with --replay=<file>
+static bool replay_registered = register_replay_operator("Compress", &Compress::op);
+
+void Compress::op(Item &item){	Metrics metrics;
+	static AllocOperator alloc_operator("Compress");
+	AllocScope alloc_scope(alloc_operator);
+	if(capture_file) capture_batch("Compress", item);
+	volatile unsigned long latency_op;
+	if(metrics.operator_latency_is_enabled(item)){
+		latency_op = current_time_usecs();
+	}
+	// items of a batch are independent, each one becomes a task of the team
+	#pragma omp taskloop grainsize(1) shared(item)
+	for(int num_item = 0; num_item < item.batch_size; num_item++){ //batch loop
+
+		compress_op(item.item_batch[num_item]);
+	}
+	
+	if(metrics.operator_latency_is_enabled(item)){
+		item.latency_op.push_back(current_time_usecs() - latency_op);
+	}
+}
+
+}
\ No newline at end of file
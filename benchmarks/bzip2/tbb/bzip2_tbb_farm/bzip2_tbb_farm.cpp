@@ -7,7 +7,7 @@ public:
 	stage1_comp() : tbb::filter(tbb::filter::serial_in_order) {}
 	void* operator() (void*){
 		while(1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if(!spb::Source::op(*item)) break;
 			return item;
 		}
@@ -31,7 +31,7 @@ public:
 	void* operator() (void* new_item){
 		spb::Item * item = static_cast <spb::Item*> (new_item);
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return NULL;
 	}
 };
@@ -53,7 +53,7 @@ void compress(){
 	stage3_comp write;
 	pipeline.add_filter(write);
 
-	pipeline.run(spb::nthreads*10);
+	pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
 
 	/*------------------------------*/
 	spb::Metrics::stop();
@@ -64,7 +64,7 @@ public:
 	stage1_decomp() : tbb::filter(tbb::filter::serial_in_order) {}
 	void* operator() (void*){
 		while(1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if(!spb::Source_d::op(*item)) break;
 			return item;
 		}
@@ -88,6 +88,7 @@ public:
 	void* operator() (void* new_item){
 		spb::Item * item = static_cast <spb::Item*> (new_item);
 		spb::Sink_d::op(*item);
+		spb::item_pool.release(item);
 		return NULL;
 	}
 };
@@ -109,7 +110,7 @@ void decompress(){
 	stage3_decomp write;
 	pipeline.add_filter(write);
 
-	pipeline.run(spb::nthreads*10);
+	pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
 
 	/*------------------------------*/
 	spb::Metrics::stop();
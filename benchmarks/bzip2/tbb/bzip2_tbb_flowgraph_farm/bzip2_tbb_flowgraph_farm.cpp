@@ -0,0 +1,134 @@
+#include <bzip2.hpp>
+#include <tbb/flow_graph.h>
+#include <tbb/global_control.h>
+
+/* oneTBB flow graph version of bzip2_tbb_farm:
+ * source -> limiter -> worker (nthreads) -> sequencer -> sink -> limiter.decrementer()
+ */
+
+typedef tbb::flow::input_node<spb::Item*> source_node_t;
+typedef tbb::flow::limiter_node<spb::Item*> limiter_node_t;
+typedef tbb::flow::function_node<spb::Item*, spb::Item*> worker_node_t;
+typedef tbb::flow::sequencer_node<spb::Item*> sequencer_node_t;
+typedef tbb::flow::function_node<spb::Item*, tbb::flow::continue_msg> sink_node_t;
+
+// batches leave the source numbered from zero
+struct sequence{
+	size_t operator()(spb::Item * item) const {
+		return item->batch_index;
+	}
+};
+
+/* A source waiting on the tuning gate (-A) holds a thread, so keep one more for the other nodes */
+int max_parallelism(){
+	return spb::nthreads + (spb::SPBench::tuning_is_enabled() ? 1 : 0);
+}
+
+void compress(){
+
+	spb::Metrics::init();
+
+	/*----------TBB region----------*/
+
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, max_parallelism());
+
+	tbb::flow::graph g;
+
+	source_node_t source(g, [](tbb::flow_control & fc) -> spb::Item* {
+		spb::Item * item = spb::item_pool.acquire();
+		if(!spb::Source::op(*item)){
+			spb::item_pool.release(item);
+			fc.stop();
+			return NULL;
+		}
+		return item;
+	});
+
+	// backpressure: bounds the number of batches between source and sink
+	int capacity = spb::SPBench::getQueueCapacity(spb::nthreads*10);
+	limiter_node_t limiter(g, capacity);
+	// the input node fetches one batch ahead of the limiter
+	spb::item_pool.reserve(capacity + 1);
+
+	worker_node_t worker(g, spb::nthreads, [](spb::Item * item) -> spb::Item* {
+		spb::Compress::op(*item);
+		return item;
+	});
+
+	sequencer_node_t sequencer(g, sequence());
+
+	sink_node_t sink(g, tbb::flow::serial, [](spb::Item * item) -> tbb::flow::continue_msg {
+		spb::Sink::op(*item);
+		spb::item_pool.release(item);
+		return tbb::flow::continue_msg();
+	});
+
+	tbb::flow::make_edge(source, limiter);
+	tbb::flow::make_edge(limiter, worker);
+	tbb::flow::make_edge(worker, sequencer);
+	tbb::flow::make_edge(sequencer, sink);
+	tbb::flow::make_edge(sink, limiter.decrementer());
+
+	source.activate();
+	g.wait_for_all();
+
+	/*------------------------------*/
+	spb::Metrics::stop();
+}
+
+void decompress(){
+
+	spb::Metrics::init();
+
+	/*----------TBB region----------*/
+
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, max_parallelism());
+
+	tbb::flow::graph g;
+
+	source_node_t source(g, [](tbb::flow_control & fc) -> spb::Item* {
+		spb::Item * item = spb::item_pool.acquire();
+		if(!spb::Source_d::op(*item)){
+			spb::item_pool.release(item);
+			fc.stop();
+			return NULL;
+		}
+		return item;
+	});
+
+	// backpressure: bounds the number of batches between source and sink
+	int capacity = spb::SPBench::getQueueCapacity(spb::nthreads*10);
+	limiter_node_t limiter(g, capacity);
+	// the input node fetches one batch ahead of the limiter
+	spb::item_pool.reserve(capacity + 1);
+
+	worker_node_t worker(g, spb::nthreads, [](spb::Item * item) -> spb::Item* {
+		spb::Decompress::op(*item);
+		return item;
+	});
+
+	sequencer_node_t sequencer(g, sequence());
+
+	sink_node_t sink(g, tbb::flow::serial, [](spb::Item * item) -> tbb::flow::continue_msg {
+		spb::Sink_d::op(*item);
+		spb::item_pool.release(item);
+		return tbb::flow::continue_msg();
+	});
+
+	tbb::flow::make_edge(source, limiter);
+	tbb::flow::make_edge(limiter, worker);
+	tbb::flow::make_edge(worker, sequencer);
+	tbb::flow::make_edge(sequencer, sink);
+	tbb::flow::make_edge(sink, limiter.decrementer());
+
+	source.activate();
+	g.wait_for_all();
+
+	/*------------------------------*/
+	spb::Metrics::stop();
+}
+
+int main (int argc, char* argv[]){
+	spb::bzip2_main(argc, argv);
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include <bzip2.hpp>
+#include <tbb/parallel_pipeline.h>
+#include <tbb/global_control.h>
+
+/* oneTBB version of bzip2_tbb_farm, using parallel_pipeline instead of the legacy tbb::pipeline */
+
+void compress(){
+
+	spb::Metrics::init();
+
+	/*----------TBB region----------*/
+
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, spb::nthreads);
+
+	tbb::parallel_pipeline(spb::SPBench::getQueueCapacity(spb::nthreads*10),
+		tbb::make_filter<void, spb::Item*>(tbb::filter_mode::serial_in_order,
+			[](tbb::flow_control & fc) -> spb::Item* {
+				spb::Item * item = spb::item_pool.acquire();
+				if(!spb::Source::op(*item)){
+					spb::item_pool.release(item);
+					fc.stop();
+					return NULL;
+				}
+				return item;
+			}) &
+		tbb::make_filter<spb::Item*, spb::Item*>(tbb::filter_mode::parallel,
+			[](spb::Item * item) -> spb::Item* {
+				spb::Compress::op(*item);
+				return item;
+			}) &
+		tbb::make_filter<spb::Item*, void>(tbb::filter_mode::serial_in_order,
+			[](spb::Item * item){
+				spb::Sink::op(*item);
+				spb::item_pool.release(item);
+			})
+	);
+
+	/*------------------------------*/
+	spb::Metrics::stop();
+}
+
+void decompress(){
+
+	spb::Metrics::init();
+
+	/*----------TBB region----------*/
+
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, spb::nthreads);
+
+	tbb::parallel_pipeline(spb::SPBench::getQueueCapacity(spb::nthreads*10),
+		tbb::make_filter<void, spb::Item*>(tbb::filter_mode::serial_in_order,
+			[](tbb::flow_control & fc) -> spb::Item* {
+				spb::Item * item = spb::item_pool.acquire();
+				if(!spb::Source_d::op(*item)){
+					spb::item_pool.release(item);
+					fc.stop();
+					return NULL;
+				}
+				return item;
+			}) &
+		tbb::make_filter<spb::Item*, spb::Item*>(tbb::filter_mode::parallel,
+			[](spb::Item * item) -> spb::Item* {
+				spb::Decompress::op(*item);
+				return item;
+			}) &
+		tbb::make_filter<spb::Item*, void>(tbb::filter_mode::serial_in_order,
+			[](spb::Item * item){
+				spb::Sink_d::op(*item);
+				spb::item_pool.release(item);
+			})
+	);
+
+	/*------------------------------*/
+	spb::Metrics::stop();
+}
+
+int main (int argc, char* argv[]){
+	spb::bzip2_main(argc, argv);
+	return 0;
+}
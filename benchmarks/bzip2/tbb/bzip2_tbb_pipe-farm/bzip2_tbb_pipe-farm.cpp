@@ -0,0 +1,151 @@
+#include <bzip2.hpp>
+#include <tbb/pipeline.h>
+#include "tbb/task_scheduler_init.h"
+
+/* Pipeline of farms: split -> read (parallel, pread) -> compress (parallel) -> write (serial, in order).
+ * The write stage stays serial since block sizes are only known after compression.
+ */
+
+class stage1_comp : public tbb::filter{
+public:
+	stage1_comp() : tbb::filter(tbb::filter::serial_in_order) {}
+	void* operator() (void*){
+		while(1){
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source::op(*item)) break;
+			return item;
+		}
+		return NULL;
+	}
+};
+
+class stage2_comp : public tbb::filter{
+public:
+	stage2_comp() : tbb::filter(tbb::filter::parallel) {}
+	void* operator() (void* new_item){
+		spb::Item * item = static_cast <spb::Item*> (new_item);
+		spb::Read::op(*item);
+		return item;
+	}
+};
+
+class stage3_comp : public tbb::filter{
+public:
+	stage3_comp() : tbb::filter(tbb::filter::parallel) {}
+	void* operator() (void* new_item){
+		spb::Item * item = static_cast <spb::Item*> (new_item);
+		spb::Compress::op(*item);
+		return item;
+	}
+};
+
+class stage4_comp : public tbb::filter{
+public:
+	stage4_comp() : tbb::filter(tbb::filter::serial_in_order) {}
+	void* operator() (void* new_item){
+		spb::Item * item = static_cast <spb::Item*> (new_item);
+		spb::Sink::op(*item);
+		spb::item_pool.release(item);
+		return NULL;
+	}
+};
+
+void compress(){
+
+	spb::Metrics::init();
+
+	/*----------TBB region----------*/
+
+	tbb::task_scheduler_init init_parallel(spb::nthreads);
+
+	tbb::pipeline pipeline;
+
+	stage1_comp split;
+	pipeline.add_filter(split);
+	stage2_comp read;
+	pipeline.add_filter(read);
+	stage3_comp compress;
+	pipeline.add_filter(compress);
+	stage4_comp write;
+	pipeline.add_filter(write);
+
+	pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
+
+	/*------------------------------*/
+	spb::Metrics::stop();
+}
+
+class stage1_decomp : public tbb::filter{
+public:
+	stage1_decomp() : tbb::filter(tbb::filter::serial_in_order) {}
+	void* operator() (void*){
+		while(1){
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source_d::op(*item)) break;
+			return item;
+		}
+		return NULL;
+	}
+};
+
+class stage2_decomp : public tbb::filter{
+public:
+	stage2_decomp() : tbb::filter(tbb::filter::parallel) {}
+	void* operator() (void* new_item){
+		spb::Item * item = static_cast <spb::Item*> (new_item);
+		spb::Read::op(*item);
+		return item;
+	}
+};
+
+class stage3_decomp : public tbb::filter{
+public:
+	stage3_decomp() : tbb::filter(tbb::filter::parallel) {}
+	void* operator() (void* new_item){
+		spb::Item * item = static_cast <spb::Item*> (new_item);
+		spb::Decompress::op(*item);
+		return item;
+	}
+};
+
+class stage4_decomp : public tbb::filter{
+public:
+	stage4_decomp() : tbb::filter(tbb::filter::serial_in_order) {}
+	void* operator() (void* new_item){
+		spb::Item * item = static_cast <spb::Item*> (new_item);
+		spb::Sink_d::op(*item);
+		spb::item_pool.release(item);
+		return NULL;
+	}
+};
+
+void decompress(){
+
+	spb::Metrics::init();
+
+	/*----------TBB region----------*/
+
+	tbb::task_scheduler_init init_parallel(spb::nthreads);
+
+	tbb::pipeline pipeline;
+
+	stage1_decomp split;
+	pipeline.add_filter(split);
+	stage2_decomp read;
+	pipeline.add_filter(read);
+	stage3_decomp decompress;
+	pipeline.add_filter(decompress);
+	stage4_decomp write;
+	pipeline.add_filter(write);
+
+	pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
+
+	/*------------------------------*/
+	spb::Metrics::stop();
+}
+
+int main (int argc, char* argv[]){
+	spb::deferred_read = true; // blocks are read by the Read stage
+	spb::bzip2_main(argc, argv);
+	return 0;
+}
\ No newline at end of file
@@ -101,8 +101,8 @@ void compress(){
 
 	spb::Metrics::init();
 
-	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,1);
-	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
 
 	// Stage 1
 	std::thread stage1(comp_emitter,queue1);
@@ -185,8 +185,8 @@ void decomp_collector(SParSharedQueue<struct data> * queue2){
 void decompress(){
 	spb::Metrics::init();
 
-	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,1);
-	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
 
 	// Stage 1
 	std::thread stage1(decomp_emitter,queue1);
@@ -0,0 +1,254 @@
+/*
+Author: Renato Hoffmann
+Email: <renato.hoffmann@edu.pucrs.br>
+December 2022
+
+Although validated, there are no guarantees that this code will work. 
+In case of questions, please contact via email.
+*/
+
+/* Pipeline of farms: the source only splits the input into blocks, which are
+ * then read (pread) by a farm of readers and compressed by a second farm.
+ * The sink stays serial and ordered, since block sizes are only known after
+ * compression and the output is written sequentially.
+ */
+
+#include <bzip2.hpp>
+#include <queue>
+#include "SPar_Shared_Queue.hpp"
+
+#ifdef ONDEMAND
+    #define QUEUESIZE 1
+#else
+    #define QUEUESIZE 512
+#endif
+
+
+struct data{
+	spb::Item item;
+	bool omp_spar_eos;
+	int order_id;
+};
+
+struct compare_task_data{
+	bool operator()(struct data * t1, struct data * t2){
+		return (t1->order_id > t2->order_id);
+	}
+	bool operator()(const struct data & t1, const struct data & t2){
+		return (t1.order_id > t2.order_id);
+	}
+	bool operator()(struct data && t1, struct data && t2){
+		return (t1.order_id > t2.order_id);
+	}
+};
+
+void comp_emitter(SParSharedQueue<struct data> * queue1){
+	struct data * local;
+	int curr_id = 0;
+	while(1){
+		spb::Item item;
+		if(!spb::Source::op(item)) {
+			queue1->NotifyEOS();
+			break;
+		}
+		local = new struct data();
+		local->omp_spar_eos = false;
+		local->item = item;
+		local->order_id = curr_id;
+		queue1->Add(local);
+		curr_id++;
+	}
+}
+
+void comp_reader(SParSharedQueue<struct data> * queue1, SParSharedQueue<struct data> * queue2){
+	struct data * local;
+	while(1){
+		local = queue1->Remove();
+		if(local->omp_spar_eos){
+			queue2->NotifyEOS();
+			break;
+		}
+		spb::Read::op(local->item);
+		queue2->Add(local);
+	}
+}
+
+void comp_worker(SParSharedQueue<struct data> * queue2, SParSharedQueue<struct data> * queue3){
+	struct data * local;
+	while(1){
+		local = queue2->Remove();
+		if(local->omp_spar_eos){
+			queue3->NotifyEOS();
+			break;
+		}
+		spb::Compress::op(local->item);
+		queue3->Add(local);
+	}
+}
+
+void comp_collector(SParSharedQueue<struct data> * queue3){
+	struct data * local;
+	std::priority_queue<struct data*,std::deque<struct data*>,compare_task_data> pqueue_buffer;
+	int local_id = 0;
+	while(1){
+		local = queue3->Remove();
+		if(local->omp_spar_eos){
+			break;
+		}
+		
+		while(1){
+			if(local->order_id!=local_id){
+				pqueue_buffer.push(local);
+				break;
+			}
+			spb::Sink::op(local->item);
+			local_id++;
+			delete local;
+			if(pqueue_buffer.empty() 
+				|| (local_id < pqueue_buffer.top()->order_id) )
+				break; 
+
+			local = pqueue_buffer.top();
+			pqueue_buffer.pop();
+
+		}
+
+	}
+}
+
+void compress(){
+
+	spb::Metrics::init();
+
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+	SParSharedQueue<struct data> * queue3 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+
+	// Stage 1
+	std::thread stage1(comp_emitter,queue1);
+	// Stage 2 and 3
+	std::vector<std::thread> stage2, stage3;
+	for(int i=0;i < spb::nthreads; i++){
+		stage2.push_back(std::thread(comp_reader,queue1,queue2));
+		stage3.push_back(std::thread(comp_worker,queue2,queue3));
+	}
+	// Stage 4
+	std::thread stage4(comp_collector,queue3);
+
+	stage1.join();
+ 	for (auto& t : stage2)
+    	t.join();
+ 	for (auto& t : stage3)
+    	t.join();
+	stage4.join();
+
+	spb::Metrics::stop();
+}
+
+void decomp_emitter(SParSharedQueue<struct data> * queue1){
+	struct data * local;
+	int curr_id = 0;
+	while(1){
+		spb::Item item;
+		if(!spb::Source_d::op(item)) {
+			queue1->NotifyEOS();
+			break;
+		}
+		local = new struct data();
+		local->omp_spar_eos = false;
+		local->item = item;
+		local->order_id = curr_id;
+		queue1->Add(local);
+		curr_id++;
+	}
+}
+
+void decomp_reader(SParSharedQueue<struct data> * queue1, SParSharedQueue<struct data> * queue2){
+	struct data * local;
+	while(1){
+		local = queue1->Remove();
+		if(local->omp_spar_eos){
+			queue2->NotifyEOS();
+			break;
+		}
+		spb::Read::op(local->item);
+		queue2->Add(local);
+	}
+}
+
+void decomp_worker(SParSharedQueue<struct data> * queue2, SParSharedQueue<struct data> * queue3){
+	struct data * local;
+	while(1){
+		local = queue2->Remove();
+		if(local->omp_spar_eos){
+			queue3->NotifyEOS();
+			break;
+		}
+		spb::Decompress::op(local->item);
+		queue3->Add(local);
+	}
+}
+
+void decomp_collector(SParSharedQueue<struct data> * queue3){
+	struct data * local;
+	int local_id = 0;
+	std::priority_queue<struct data*,std::deque<struct data*>,compare_task_data> pqueue_buffer;
+	while(1){
+		local = queue3->Remove();
+		if(local->omp_spar_eos){
+			break;
+		}
+		
+		while(1){
+			if(local->order_id!=local_id){
+				pqueue_buffer.push(local);
+				break;
+			}
+			spb::Sink_d::op(local->item);
+			local_id++;
+			delete local;
+			if(pqueue_buffer.empty() 
+				|| (local_id < pqueue_buffer.top()->order_id) )
+				break; 
+
+			local = pqueue_buffer.top();
+			pqueue_buffer.pop();
+
+		}
+
+	}
+}
+
+void decompress(){
+	spb::Metrics::init();
+
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+	SParSharedQueue<struct data> * queue3 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+
+	// Stage 1
+	std::thread stage1(decomp_emitter,queue1);
+	// Stage 2 and 3
+	std::vector<std::thread> stage2, stage3;
+	for(int i=0;i < spb::nthreads; i++){
+		stage2.push_back(std::thread(decomp_reader,queue1,queue2));
+		stage3.push_back(std::thread(decomp_worker,queue2,queue3));
+	}
+	// Stage 4
+	std::thread stage4(decomp_collector,queue3);
+
+	stage1.join();
+ 	for (auto& t : stage2)
+    	t.join();
+ 	for (auto& t : stage3)
+    	t.join();
+	stage4.join();
+
+	spb::Metrics::stop();
+}
+
+int main (int argc, char* argv[]){
+	spb::deferred_read = true; // blocks are read by the Read stage
+	spb::bzip2_main(argc, argv);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#include <../include/read_op.hpp>
+
+inline void spb::Read::read_op(spb::item_data &item){
+
+    // load the block listed by the source (no-op for in-memory input)
+    spb::read_block(item);
+
+}
\ No newline at end of file
@@ -12,12 +12,13 @@ Although validated, there are no guarantees that this code will work. In case of
 #include <ferret.hpp>
 
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Source: ff::ff_monode_t<spb::Item> { 
     Source(){}
     spb::Item *svc(spb::Item*) {
         while (1){
-            spb::Item * item = new spb::Item();
+            spb::Item * item = spb::item_pool.acquire();
             if (!spb::Source::op(*item)) break;
             ff_send_out(item);
         }
@@ -61,7 +62,7 @@ struct Sink: ff::ff_minode_t<spb::Item>{
     Sink(){}
     spb::Item * svc(spb::Item * item){
         spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
         return GO_ON;
     }
 };
@@ -105,6 +106,7 @@ int main(int argc, char** argv) {
     Sink *sink = new Sink();
 
     ff::ff_Pipe<> pipe(source, a2a_internal_1a, a2a_internal_1b, sink);
+    spb::ff_runtime_options(pipe);
 
     printf("The total number of threads from the inner composition + the source and Sink is: %d\n", pipe.cardinality());
 
@@ -9,12 +9,13 @@ In case of questions, please contact via email.
 
 #include <ferret.hpp>
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Source: ff::ff_node_t<spb::Item>{
 	Source(){}
 	spb::Item * svc(spb::Item * task){
 		while (1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source::op(*item)) break;
 			ff_send_out(item);
 		}
@@ -58,7 +59,7 @@ struct Sink: ff::ff_minode_t<spb::Item>{
 	Sink(){}
 	spb::Item * svc(spb::Item * item){
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return GO_ON;
 	}
 };
@@ -86,6 +87,7 @@ int main(int argc, char *argv[]) {
 	farm.add_workers(w);
 
 	farm.cleanup_workers();
+	spb::ff_farm_options(farm, false, false); // unordered, round-robin
 
 	printf("The total number of threads from the inner composition + the source and Sink is: %d\n", farm.cardinality());
 
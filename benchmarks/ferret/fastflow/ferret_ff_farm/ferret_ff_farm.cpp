@@ -1,12 +1,13 @@
 #include <ferret.hpp>
 
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Emitter: ff::ff_node_t<spb::Item>{
 
     spb::Item * svc(spb::Item * task){
         while (1){
-            spb::Item * item = new spb::Item();
+            spb::Item * item = spb::item_pool.acquire();
             if (!spb::Source::op(*item)) break;
             ff_send_out(item);
         }
@@ -27,7 +28,7 @@ struct Worker: ff::ff_node_t<spb::Item>{
 struct Collector: ff::ff_node_t<spb::Item>{
     spb::Item * svc(spb::Item * item){
         spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
         return GO_ON;
     }
 }Collector;
@@ -49,7 +50,7 @@ int main(int argc, char *argv[]) {
     farm.add_emitter(E);
     farm.add_collector(Collector);
 
-    farm.set_scheduling_ondemand();
+    spb::ff_farm_options(farm, false, true); // unordered, on-demand
 
     if(farm.run_and_wait_end()<0){
         std::cout << "error running pipe";
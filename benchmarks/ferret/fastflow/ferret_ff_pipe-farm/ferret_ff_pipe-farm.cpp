@@ -11,12 +11,13 @@ Although validated, there are no guarantees that this code will work. In case of
 
 #include <ferret.hpp>
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Source: ff::ff_node_t<spb::Item>{
 	Source(){}
 	spb::Item * svc(spb::Item * task){
 		while (1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source::op(*item)) break;
 			ff_send_out(item);
 		}
@@ -60,7 +61,7 @@ struct Sink: ff::ff_minode_t<spb::Item>{
 	Sink(){}
 	spb::Item * svc(spb::Item * item){
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return GO_ON;
 	}
 };
@@ -77,6 +78,7 @@ int main(int argc, char *argv[]) {
 		segWorkers.push_back(new Segmentation());
 	}
 	farmSeg.add_workers(segWorkers);
+	spb::ff_farm_options(farmSeg, false, false); // unordered, round-robin
 	Source *source = new Source();
 	farmSeg.add_emitter(source);
 	pipeSeg->add_stage(&farmSeg);
@@ -93,6 +95,7 @@ int main(int argc, char *argv[]) {
 		extWorkers.push_back(new Extract());
 	}
 	farmExt.add_workers(extWorkers);
+	spb::ff_farm_options(farmExt, false, false);
 	pipeExt->add_stage(&farmExt);
 
 #if defined(DEBUG)
@@ -107,6 +110,7 @@ int main(int argc, char *argv[]) {
 		vecWorkers.push_back(new Vectorization());
 	}
 	farmVec.add_workers(vecWorkers);
+	spb::ff_farm_options(farmVec, false, false);
 	pipeVec->add_stage(&farmVec);
 
 #if defined(DEBUG)
@@ -121,6 +125,7 @@ int main(int argc, char *argv[]) {
 		rankWorkers.push_back(new Rank());
 	}
 	farmRank.add_workers(rankWorkers);
+	spb::ff_farm_options(farmRank, false, false);
 	pipeRank->add_stage(&farmRank);
 
 #if defined(DEBUG)
@@ -135,6 +140,7 @@ int main(int argc, char *argv[]) {
 	pipe.add_stage(pipeVec); 
 	pipe.add_stage(pipeRank);
 	pipe.add_stage(sink);
+	spb::ff_runtime_options(pipe);
 
 	printf("The total number of threads from the inner composition + the source and Sink is: %d\n", pipe.cardinality());
 	fflush(stdout);
@@ -1,11 +1,12 @@
 #include <ferret.hpp>
 
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Source: ff::ff_node_t<spb::Item>{
     spb::Item * svc(spb::Item * task){
         while (1){
-            spb::Item * item = new spb::Item();
+            spb::Item * item = spb::item_pool.acquire();
             if (!spb::Source::op(*item)) break;
             ff_send_out(item);
         }
@@ -44,7 +45,7 @@ struct Rank: ff::ff_node_t<spb::Item>{
 struct Sink: ff::ff_node_t<spb::Item>{
     spb::Item * svc(spb::Item * item){
         spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
         return GO_ON;
     }
 };
@@ -61,6 +62,7 @@ int main(int argc, char *argv[]) {
         new Vectorization(),
         new Rank(),
         new Sink());
+    spb::ff_runtime_options(pipe);
 
     if (pipe.run_and_wait_end()<0) ff::error("running pipe");
 
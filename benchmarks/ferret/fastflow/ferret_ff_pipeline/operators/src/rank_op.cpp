@@ -24,14 +24,12 @@ inline void spb::Rank::rank_op(spb::item_data &item){
 			(cass_dataset_t *)query_table->__private,
 			0);
 	query.candidate = candidate;
+	// the queries of the batch run together in rank_batch_query(),
+	// which releases the candidates and the query datasets
+	item.first.rank.query = query;
 
-	cass_result_alloc_list(&item.first.rank.result,
+	result_alloc_list(item, &item.first.rank.result,
 			0, top_K);
-	cass_table_query(query_table, &query,
-			&item.first.rank.result);
 
-	cass_result_free(&item.second.vec.result);
-	cass_result_free(candidate);
-	free(candidate);
-	cass_dataset_release(item.second.vec.ds);
+	result_free(item, &item.second.vec.result);
 }
\ No newline at end of file
@@ -9,22 +9,24 @@ using namespace experimental;
 void run(grppi::dynamic_execution & ex) {
 	tbb::task_scheduler_init init(spb::nthreads);
 	grppi::pipeline(ex,
-			[]() mutable -> optional<spb::Item> {
-				spb::Item item;
-				if(!spb::Source::op(item)) {
+			[]() mutable -> optional<spb::Item*> {
+				spb::Item * item = spb::item_pool.acquire();
+				if(!spb::Source::op(*item)) {
+					spb::item_pool.release(item);
 					return {};
 				} else { return item; }
 			},
 			grppi::farm(spb::nthreads,
-				[](spb::Item item) {
-				spb::Segmentation::op(item);
-				spb::Extract::op(item);
-				spb::Vectorization::op(item);
-				spb::Rank::op(item);
+				[](spb::Item * item) {
+				spb::Segmentation::op(*item);
+				spb::Extract::op(*item);
+				spb::Vectorization::op(*item);
+				spb::Rank::op(*item);
 				return item;
 				}),
-			[](spb::Item item) {
-				spb::Sink::op(item);
+			[](spb::Item * item) {
+				spb::Sink::op(*item);
+				spb::item_pool.release(item);
 			}
 	);
 }
@@ -32,18 +34,18 @@ void run(grppi::dynamic_execution & ex) {
 grppi::dynamic_execution execution_mode(){
 	string backend = spb::SPBench::getArg(0);
 	if(backend == "tbb"){
-		auto ex = grppi::parallel_execution_tbb(spb::nthreads, false);
-		ex.set_queue_attributes(1, grppi::queue_mode::blocking, spb::nthreads*10);
+		auto ex = grppi::parallel_execution_tbb(spb::nthreads, spb::SPBench::isOrdered(false));
+		ex.set_queue_attributes(1, grppi::queue_mode::blocking, spb::SPBench::getQueueCapacity(spb::nthreads*10));
 		return ex;
 	} else if (backend == "ff"){
-		auto ex = grppi::parallel_execution_ff(spb::nthreads, false);
+		auto ex = grppi::parallel_execution_ff(spb::nthreads, spb::SPBench::isOrdered(false));
 		return ex;
 	} else if (backend == "omp"){
-		auto ex = grppi::parallel_execution_omp(spb::nthreads, false);
+		auto ex = grppi::parallel_execution_omp(spb::nthreads, spb::SPBench::isOrdered(false));
 		ex.set_queue_attributes(1, grppi::queue_mode::blocking);
 		return ex;
 	} else if (backend == "thr"){
-		auto ex = grppi::parallel_execution_native(spb::nthreads, false);
+		auto ex = grppi::parallel_execution_native(spb::nthreads, spb::SPBench::isOrdered(false));
 		ex.set_queue_attributes(1, grppi::queue_mode::blocking);
 		return ex;
 	} else {
@@ -106,11 +106,11 @@ int main(int argc, char *argv[]) {
     spb::init_bench(argc, argv);
 	spb::Metrics::init();
 
-	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,1);
-	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
-	SParSharedQueue<struct data> * queue3 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
-	SParSharedQueue<struct data> * queue4 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
-	SParSharedQueue<struct data> * queue5 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+	SParSharedQueue<struct data> * queue3 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+	SParSharedQueue<struct data> * queue4 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+	SParSharedQueue<struct data> * queue5 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
 
 	omp_set_num_threads((spb::nthreads * 4) + 2);
 	#pragma omp parallel shared(queue1,queue2)
@@ -0,0 +1,91 @@
+#include <ferret.hpp>
+#include <vector>
+#include <omp.h>
+
+/* Pipeline of farms expressed with OpenMP task dependences instead of queues.
+ * The source runs in the thread generating the tasks. Each middle stage is a
+ * task depending only on its batch, so different batches run them in parallel
+ * while one batch goes through them in order. Sink tasks run one at a time in
+ * a critical section as their batches complete, so, as in ferret_omp_pipe-farm,
+ * the output is unordered.
+ * Batches of the operators are split with taskloop (see operators/include).
+ */
+
+/* Batches in flight allowed per worker thread */
+#define WINDOWSIZE 2
+
+/* Tuning (-A) wait of the source: a task scheduling point on the oldest batch
+ * in flight, so the thread creating the tasks keeps running them meanwhile */
+void wait_oldest_batch(std::vector<char> & window, int window_size, long batch, long & oldest){
+	oldest = std::max(oldest, batch - window_size);
+	if(oldest < batch){
+		#pragma omp taskwait depend(in: window.data()[oldest % window_size])
+		oldest++;
+	}
+}
+
+int main(int argc, char *argv[]) {
+
+    spb::init_bench(argc, argv);
+	spb::Metrics::init();
+
+	int window_size = spb::SPBench::getQueueCapacity(WINDOWSIZE*spb::nthreads);
+
+	// one dependence slot per in-flight batch, reused every window_size batches
+	std::vector<char> window(window_size);
+	// the batches of the window and the one being read by the source
+	spb::item_pool.reserve(window_size + 1);
+
+	omp_set_num_threads(spb::nthreads+1);
+	#pragma omp parallel
+	#pragma omp single
+	{
+		long batch = 0, oldest = 0;
+		// with tuning (-A) the source must not block on the in-flight limit
+		spb::SPBench::setInFlightWait([&](){ wait_oldest_batch(window, window_size, batch, oldest); });
+		while(1){
+			if(batch >= window_size){
+				// wait for the sink of the batch that used this slot
+				#pragma omp taskwait depend(in: window.data()[batch % window_size])
+			}
+
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source::op(*item)){
+				spb::item_pool.release(item);
+				break;
+			}
+
+			#pragma omp task firstprivate(item) depend(out: item[0])
+			{
+				spb::Segmentation::op(*item);
+			}
+			#pragma omp task firstprivate(item) depend(inout: item[0])
+			{
+				spb::Extract::op(*item);
+			}
+			#pragma omp task firstprivate(item) depend(inout: item[0])
+			{
+				spb::Vectorization::op(*item);
+			}
+			#pragma omp task firstprivate(item) depend(inout: item[0])
+			{
+				spb::Rank::op(*item);
+			}
+
+			#pragma omp task firstprivate(item) depend(in: item[0]) depend(out: window.data()[batch % window_size])
+			{
+				#pragma omp critical (sink)
+				{
+					spb::Sink::op(*item);
+					spb::item_pool.release(item);
+				}
+			}
+			batch++;
+		}
+	} // implicit barrier: every task is done here
+	spb::SPBench::setInFlightWait(nullptr);
+
+    spb::Metrics::stop();
+	spb::end_bench();
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include <ferret.hpp>
+
+namespace spb{
+
+void Extract::op(Item &item){
+	Metrics metrics;
+	static AllocOperator alloc_operator("Extract");
+	AllocScope alloc_scope(alloc_operator);
+	volatile unsigned long latency_op;
+	if(metrics.operator_latency_is_enabled(item)){
+		latency_op = current_time_usecs();
+	}
+	// items of a batch are independent, each one becomes a task of the team
+	#pragma omp taskloop grainsize(1) shared(item)
+	for(int num_item = 0; num_item < item.batch_size; num_item++){ //batch loop
+
+		extract_op(*item.item_batch[num_item]);
+	}
+	
+	if(metrics.operator_latency_is_enabled(item)){
+		item.latency_op.push_back(current_time_usecs() - latency_op);
+	}
+}
+
+}
+
+
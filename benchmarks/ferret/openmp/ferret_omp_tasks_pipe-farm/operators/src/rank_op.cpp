@@ -0,0 +1,35 @@
+#include <../include/rank_op.hpp>
+
+inline void spb::Rank::rank_op(spb::item_data &item){
+	cass_query_t query;
+	query = item.first.rank.query;
+
+	cass_result_t *candidate;
+
+	item.first.rank.name = item.second.vec.name;
+
+	query.flags = CASS_RESULT_LIST | CASS_RESULT_USERMEM | CASS_RESULT_SORT;
+	query.dataset = item.second.vec.ds;
+	query.vecset_id = 0;
+
+	query.vec_dist_id = vec_dist_id;
+
+	query.vecset_dist_id = vecset_dist_id;
+
+	query.topk = top_K;
+
+	query.extra_params = NULL;
+
+	candidate = cass_result_merge_lists(&item.second.vec.result,
+			(cass_dataset_t *)query_table->__private,
+			0);
+	query.candidate = candidate;
+	// the queries of the batch run together in rank_batch_query(),
+	// which releases the candidates and the query datasets
+	item.first.rank.query = query;
+
+	result_alloc_list(item, &item.first.rank.result,
+			0, top_K);
+
+	result_free(item, &item.second.vec.result);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include <../include/vectorization_op.hpp>
+
+inline void spb::Vectorization::vectorization_op(spb::item_data &item){
+
+	cass_query_t query;
+	query = item.second.vec.query;
+
+	item.second.vec.name = item.extract.name;
+
+	memset(&query, 0, sizeof query);
+	query.flags = CASS_RESULT_LISTS | CASS_RESULT_USERMEM;
+
+	item.second.vec.ds = query.dataset = &item.extract.ds;
+	query.vecset_id = 0;
+
+	query.vec_dist_id = vec_dist_id;
+
+	query.vecset_dist_id = vecset_dist_id;
+
+	query.topk = 2*top_K;
+
+	query.extra_params = extra_params;
+
+	result_alloc_list(item, &item.second.vec.result,
+			item.second.vec.ds->vecset[0].num_regions,
+			query.topk);
+
+	cass_table_query(table, &query, &item.second.vec.result);
+	
+	item.second.vec.query = query;
+}
\ No newline at end of file
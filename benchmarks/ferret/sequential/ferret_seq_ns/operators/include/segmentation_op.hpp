@@ -7,8 +7,10 @@ void Segmentation::op(Item &item){
 		return;
 		
 	Metrics metrics;
+	static AllocOperator alloc_operator("Segmentation");
+	AllocScope alloc_scope(alloc_operator);
 	volatile unsigned long latency_op;
-	if(metrics.latency_is_enabled()){
+	if(metrics.operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}
 	unsigned int num_item = 0;
@@ -20,7 +22,7 @@ void Segmentation::op(Item &item){
 		num_item++;
 	}
 	
-	if(metrics.latency_is_enabled()){
+	if(metrics.operator_latency_is_enabled(item)){
 		item.latency_op.push_back(current_time_usecs() - latency_op);
 	}
 }
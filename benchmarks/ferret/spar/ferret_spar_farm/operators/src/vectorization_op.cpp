@@ -23,7 +23,7 @@ inline void Vectorization::vectorization_op(item_data &item){
 
 	query.extra_params = extra_params;
 
-	cass_result_alloc_list(&item.second.vec.result,
+	result_alloc_list(item, &item.second.vec.result,
 			item.second.vec.ds->vecset[0].num_regions,
 			query.topk);
 
@@ -4,10 +4,10 @@
 
 class Source : public tbb::filter{
 public:
-    Source() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Source() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void*){
         while(1){
-            spb::Item * item = new spb::Item();
+            spb::Item * item = spb::item_pool.acquire();
             if (!spb::Source::op(*item)) break;
             return item;
         }
@@ -30,11 +30,11 @@ public:
 
 class Sink : public tbb::filter{
 public:
-    Sink() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Sink() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void* new_item){
         spb::Item * item = static_cast <spb::Item*> (new_item);
         spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
         return NULL;
     }
 };
@@ -56,7 +56,7 @@ int main(int argc, char *argv[]) {
     Sink sink;
     pipeline.add_filter(sink);
 
-    pipeline.run(spb::nthreads*10);
+    pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
 
     //END
 
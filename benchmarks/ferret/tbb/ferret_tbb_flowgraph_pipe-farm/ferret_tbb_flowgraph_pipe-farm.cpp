@@ -0,0 +1,78 @@
+#include <ferret.hpp>
+#include <tbb/flow_graph.h>
+#include <tbb/global_control.h>
+
+/* oneTBB flow graph version of ferret_tbb_pipe-farm:
+ * source -> limiter -> segmentation -> extract -> vectorization -> rank -> sink -> limiter.decrementer()
+ * Every middle node runs up to nthreads bodies at once. As in the legacy version, the output is unordered.
+ */
+
+typedef tbb::flow::function_node<spb::Item*, spb::Item*> stage_node_t;
+
+int main(int argc, char *argv[]) {
+
+    spb::init_bench(argc, argv);
+
+    //TBB code
+    // a source waiting on the tuning gate (-A) holds a thread, so keep one more for the other nodes
+    tbb::global_control control(tbb::global_control::max_allowed_parallelism, spb::nthreads + (spb::SPBench::tuning_is_enabled() ? 1 : 0));
+
+    tbb::flow::graph g;
+
+    tbb::flow::input_node<spb::Item*> source(g, [](tbb::flow_control & fc) -> spb::Item* {
+        spb::Item * item = spb::item_pool.acquire();
+        if (!spb::Source::op(*item)){
+            spb::item_pool.release(item);
+            fc.stop();
+            return NULL;
+        }
+        return item;
+    });
+
+    // backpressure: bounds the number of batches between source and sink
+    int capacity = spb::SPBench::getQueueCapacity(spb::nthreads*10);
+    tbb::flow::limiter_node<spb::Item*> limiter(g, capacity);
+    // the input node fetches one batch ahead of the limiter
+    spb::item_pool.reserve(capacity + 1);
+
+    stage_node_t seg(g, spb::nthreads, [](spb::Item * item) -> spb::Item* {
+        spb::Segmentation::op(*item);
+        return item;
+    });
+    stage_node_t ext(g, spb::nthreads, [](spb::Item * item) -> spb::Item* {
+        spb::Extract::op(*item);
+        return item;
+    });
+    stage_node_t vec(g, spb::nthreads, [](spb::Item * item) -> spb::Item* {
+        spb::Vectorization::op(*item);
+        return item;
+    });
+    stage_node_t rank(g, spb::nthreads, [](spb::Item * item) -> spb::Item* {
+        spb::Rank::op(*item);
+        return item;
+    });
+
+    tbb::flow::function_node<spb::Item*, tbb::flow::continue_msg> sink(g, tbb::flow::serial, [](spb::Item * item) -> tbb::flow::continue_msg {
+        spb::Sink::op(*item);
+        spb::item_pool.release(item);
+        return tbb::flow::continue_msg();
+    });
+
+    tbb::flow::make_edge(source, limiter);
+    tbb::flow::make_edge(limiter, seg);
+    tbb::flow::make_edge(seg, ext);
+    tbb::flow::make_edge(ext, vec);
+    tbb::flow::make_edge(vec, rank);
+    tbb::flow::make_edge(rank, sink);
+    tbb::flow::make_edge(sink, limiter.decrementer());
+
+    spb::Metrics::init();
+
+    source.activate();
+    g.wait_for_all();
+    //END
+
+    spb::Metrics::stop();
+    spb::end_bench();
+    return 0;
+}
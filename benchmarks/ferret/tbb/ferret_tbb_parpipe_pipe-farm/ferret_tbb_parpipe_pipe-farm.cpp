@@ -0,0 +1,57 @@
+#include <ferret.hpp>
+#include <tbb/parallel_pipeline.h>
+#include <tbb/global_control.h>
+
+/* oneTBB version of ferret_tbb_pipe-farm, using parallel_pipeline instead of the legacy tbb::pipeline */
+
+int main(int argc, char *argv[]) {
+
+    spb::init_bench(argc, argv);
+    spb::Metrics::init();
+
+    //TBB code
+    tbb::global_control control(tbb::global_control::max_allowed_parallelism, spb::nthreads);
+
+    tbb::parallel_pipeline(spb::SPBench::getQueueCapacity(spb::nthreads*10),
+        tbb::make_filter<void, spb::Item*>(spb::SPBench::isOrdered(false) ? tbb::filter_mode::serial_in_order : tbb::filter_mode::serial_out_of_order,
+            [](tbb::flow_control & fc) -> spb::Item* {
+                spb::Item * item = spb::item_pool.acquire();
+                if (!spb::Source::op(*item)){
+                    spb::item_pool.release(item);
+                    fc.stop();
+                    return NULL;
+                }
+                return item;
+            }) &
+        tbb::make_filter<spb::Item*, spb::Item*>(tbb::filter_mode::parallel,
+            [](spb::Item * item) -> spb::Item* {
+                spb::Segmentation::op(*item);
+                return item;
+            }) &
+        tbb::make_filter<spb::Item*, spb::Item*>(tbb::filter_mode::parallel,
+            [](spb::Item * item) -> spb::Item* {
+                spb::Extract::op(*item);
+                return item;
+            }) &
+        tbb::make_filter<spb::Item*, spb::Item*>(tbb::filter_mode::parallel,
+            [](spb::Item * item) -> spb::Item* {
+                spb::Vectorization::op(*item);
+                return item;
+            }) &
+        tbb::make_filter<spb::Item*, spb::Item*>(tbb::filter_mode::parallel,
+            [](spb::Item * item) -> spb::Item* {
+                spb::Rank::op(*item);
+                return item;
+            }) &
+        tbb::make_filter<spb::Item*, void>(spb::SPBench::isOrdered(false) ? tbb::filter_mode::serial_in_order : tbb::filter_mode::serial_out_of_order,
+            [](spb::Item * item){
+                spb::Sink::op(*item);
+                spb::item_pool.release(item);
+            })
+    );
+    //END
+
+    spb::Metrics::stop();
+    spb::end_bench();
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include <ferret.hpp>
+
+namespace spb{
+
+// replayed in isolation with --replay=<file>
+static bool replay_registered = register_replay_operator("Rank", &Rank::op);
+
+void Rank::op(Item &item){	Metrics metrics;
+	static AllocOperator alloc_operator("Rank");
+	AllocScope alloc_scope(alloc_operator);
+	if(capture_file) capture_batch("Rank", item);
+	volatile unsigned long latency_op;
+	if(metrics.operator_latency_is_enabled(item)){
+		latency_op = current_time_usecs();
+	}
+	unsigned int num_item = 0;
+
+	while(num_item < item.batch_size){ //batch loop
+
+		rank_op(*item.item_batch[num_item]);
+
+		num_item++;
+	}
+	// the queries of the batch share the fetches of their common candidates
+	rank_batch_query(item.item_batch.data(), item.batch_size);
+	
+	if(metrics.operator_latency_is_enabled(item)){
+		item.latency_op.push_back(current_time_usecs() - latency_op);
+	}
+}
+
+}
\ No newline at end of file
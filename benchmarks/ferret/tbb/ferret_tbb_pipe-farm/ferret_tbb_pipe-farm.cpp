@@ -4,10 +4,10 @@
 
 class Source : public tbb::filter{
 public:
-    Source() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Source() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void*){
         while(1){
-            spb::Item * item = new spb::Item();
+            spb::Item * item = spb::item_pool.acquire();
             if (!spb::Source::op(*item)) break;
             return item;
         }
@@ -57,12 +57,12 @@ public:
 
 class Sink : public tbb::filter{
 public:
-    Sink() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Sink() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void* new_item){
     //Token* operator()(Token* t)const{
         spb::Item * item = static_cast <spb::Item*> (new_item);
         spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
         return NULL;
     }
 };
@@ -90,7 +90,7 @@ int main(int argc, char *argv[]) {
     Sink sink;
     pipeline.add_filter(sink);
 
-    pipeline.run(spb::nthreads*10);
+    pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
     //END
 
     spb::Metrics::stop();
@@ -4,10 +4,10 @@
 
 class Source : public tbb::filter{
 public:
-    Source() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Source() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void*){
         while(1){
-            spb::Item * item = new spb::Item();
+            spb::Item * item = spb::item_pool.acquire();
             if (!spb::Source::op(*item)) break;
             return item;
         }
@@ -17,7 +17,7 @@ public:
 
 class Segmentation : public tbb::filter{
 public:
-    Segmentation() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Segmentation() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void* new_item){
         spb::Item * item = static_cast <spb::Item*> (new_item);
         spb::Segmentation::op(*item);
@@ -27,7 +27,7 @@ public:
 
 class Extract : public tbb::filter{
 public:
-    Extract() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Extract() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void* new_item){
         spb::Item * item = static_cast <spb::Item*> (new_item);
         spb::Extract::op(*item);
@@ -37,7 +37,7 @@ public:
 
 class Vectorization : public tbb::filter{
 public:
-    Vectorization() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Vectorization() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void* new_item){
         spb::Item * item = static_cast <spb::Item*> (new_item);
         spb::Vectorization::op(*item);
@@ -47,7 +47,7 @@ public:
 
 class Rank : public tbb::filter{
 public:
-    Rank() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Rank() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void* new_item){
         spb::Item * item = static_cast <spb::Item*> (new_item);
         spb::Rank::op(*item);
@@ -57,12 +57,12 @@ public:
 
 class Sink : public tbb::filter{
 public:
-    Sink() : tbb::filter(tbb::filter::serial_out_of_order) {}
+    Sink() : tbb::filter(spb::SPBench::isOrdered(false) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
     void* operator() (void* new_item){
     //Token* operator()(Token* t)const{
         spb::Item * item = static_cast <spb::Item*> (new_item);
         spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
         return NULL;
     }
 };
@@ -90,7 +90,7 @@ int main(int argc, char *argv[]) {
     Sink sink;
     pipeline.add_filter(sink);
 
-    pipeline.run(spb::nthreads*10);
+    pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
     //END
 
     spb::Metrics::stop();
@@ -0,0 +1,131 @@
+#include <lane_detection.hpp>
+#include <queue>
+#include <memory>
+#include <algorithm>
+#include "Coro_Pipeline.hpp"
+
+/* Number of in-flight batches per channel */
+#define QUEUESIZE 1
+
+struct compare_item{
+	bool operator()(spb::Item * i1, spb::Item * i2){
+		return (i1->batch_index > i2->batch_index);
+	}
+};
+
+typedef void (*operator_t)(spb::Item &);
+
+/* Replicas per stage are coroutines, so they can outnumber the pool threads (-u <replicas>) */
+int replicas(){
+	if(spb::SPBench::userArgs.empty())
+		return spb::nthreads;
+	return std::max(1, atoi(spb::SPBench::getArg(0).c_str()));
+}
+
+coro::task emitter(coro::executor & exec, coro::event & slot_freed, coro::channel<spb::Item*> & out){
+	while(1){
+		// frequency control and the tuning gate suspend the emitter instead of blocking its thread
+		unsigned long delay;
+		while((delay = spb::SPBench::item_frequency_delay(spb::Source::source_item_timestamp)) > 0)
+			co_await exec.sleep_for(std::chrono::microseconds(delay));
+		while(!spb::SPBench::in_flight_try_control())
+			co_await slot_freed.wait();
+
+		spb::Item * item = spb::item_pool.acquire();
+		if(!spb::Source::op(*item)){
+			spb::SPBench::in_flight_cancel();
+			spb::item_pool.release(item);
+			break;
+		}
+		co_await out.push(item);
+	}
+	out.producer_done();
+}
+
+coro::task stage(operator_t op, coro::channel<spb::Item*> & in, coro::channel<spb::Item*> & out){
+	while(1){
+		std::optional<spb::Item*> item = co_await in.pop();
+		if(!item) break;
+		op(**item);
+		co_await out.push(*item);
+	}
+	out.producer_done();
+}
+
+coro::task collector(coro::channel<spb::Item*> & in){
+	std::priority_queue<spb::Item*, std::vector<spb::Item*>, compare_item> reorder_buffer;
+	int next_index = 0;
+	bool ordered = spb::SPBench::isOrdered(true);
+	while(1){
+		std::optional<spb::Item*> item = co_await in.pop();
+		if(!item) break;
+		if(!ordered){
+			// unordered (-U): the items go to the sink as they arrive
+			spb::Sink::op(**item);
+			spb::item_pool.release(*item);
+			continue;
+		}
+		reorder_buffer.push(*item);
+		while(!reorder_buffer.empty() && reorder_buffer.top()->batch_index == next_index){
+			spb::Item * ready = reorder_buffer.top();
+			reorder_buffer.pop();
+			spb::Sink::op(*ready);
+			spb::item_pool.release(ready);
+			next_index++;
+		}
+	}
+}
+
+int main (int argc, char* argv[]){
+	// Disabling internal OpenCV's support for multithreading.
+	cv::setNumThreads(0);
+
+	spb::init_bench(argc, argv); //Initializations
+
+	spb::Metrics::init();
+
+	// every operator is a farm of coroutines, all multiplexed on nthreads OS threads
+	std::vector<operator_t> operators = {
+		&spb::Segment::op,
+		&spb::Canny1::op,
+		&spb::HoughT::op,
+		&spb::HoughP::op,
+		&spb::Bitwise::op,
+		&spb::Canny2::op,
+		&spb::Overlap::op
+	};
+
+	int nworkers = replicas();
+	{
+		coro::executor executor(spb::nthreads);
+		coro::event slot_freed(executor); // a batch left the pipeline (tuning gate)
+		spb::SPBench::setInFlightNotify([&](){ slot_freed.set(); });
+
+		std::vector<std::unique_ptr<coro::channel<spb::Item*>>> channels;
+		channels.push_back(std::make_unique<coro::channel<spb::Item*>>(executor, spb::SPBench::getQueueCapacity(QUEUESIZE*nworkers), 1));
+		for(unsigned int s = 0; s < operators.size(); s++)
+			channels.push_back(std::make_unique<coro::channel<spb::Item*>>(executor, spb::SPBench::getQueueCapacity(QUEUESIZE*nworkers), nworkers));
+		// batches held by the emitter, the channels and the workers of every stage,
+		// and as many again for the reorder buffer of the collector
+		int held = nworkers * operators.size();
+		for(auto & channel : channels)
+			held += channel->get_capacity();
+		spb::item_pool.reserve(2 * held + 1);
+
+		executor.spawn(emitter(executor, slot_freed, *channels[0]));
+		for(unsigned int s = 0; s < operators.size(); s++){
+			for(int i = 0; i < nworkers; i++)
+				executor.spawn(stage(operators[s], *channels[s], *channels[s+1]));
+		}
+		executor.spawn(collector(*channels.back()));
+
+		executor.wait();
+		spb::SPBench::setInFlightNotify(nullptr);
+
+		spb::Metrics::stop();
+		executor.print_stats();
+	}
+
+	spb::end_bench();
+	return 0;
+}
@@ -0,0 +1,30 @@
+#include <lane_detection.hpp>
+
+namespace spb{
+
+// replayed in isolation with --replay=<file>
+static bool replay_registered = register_replay_operator("HoughT", &HoughT::op);
+
+void HoughT::op(Item &item){		Metrics metrics;
+	static AllocOperator alloc_operator("HoughT");
+	AllocScope alloc_scope(alloc_operator);
+	if(capture_file) capture_batch("HoughT", item);
+	volatile unsigned long latency_op;
+	if(metrics.operator_latency_is_enabled(item)){
+		latency_op = current_time_usecs();
+	}
+	unsigned int num_item = 0;
+
+	while(num_item < item.batch_size){ //batch loop
+
+		houghT_op(item.item_batch[num_item]);
+
+		num_item++;
+	}
+	
+	if(metrics.operator_latency_is_enabled(item)){
+		item.latency_op.push_back(current_time_usecs() - latency_op);
+	}
+}
+
+}
@@ -1,12 +1,13 @@
 #include <lane_detection.hpp>
 
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Source: ff::ff_node_t<spb::Item>{
 	Source(){}
 	spb::Item * svc(spb::Item * task){
 		while (1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source::op(*item)) break;
 			ff_send_out(item);
 		}
@@ -39,7 +40,7 @@ struct Sink: ff::ff_node_t<spb::Item>{
 	Sink(){}
 	spb::Item * svc(spb::Item * item){
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return GO_ON;
 	}
 };
@@ -58,7 +59,7 @@ int main (int argc, char* argv[]){
 		pipe->add_stage(new Worker2, true);
 		W_set1.push_back(std::make_unique<ff::ff_pipeline>(pipe));
 	}
-	ff::ff_OFarm<spb::Item> farm1(move(W_set1));
+	ff::ff_Farm<spb::Item> farm1(move(W_set1));
 
 #if defined(DEBUG)
 	printf("First Farm: %d threads\n", pipeVec->cardinality());
@@ -68,8 +69,10 @@ int main (int argc, char* argv[]){
 	Sink sink;
 	farm1.add_emitter(source);
 	farm1.add_collector(sink);
+	spb::ff_farm_options(farm1, true, false); // ordered, round-robin
 
 	ff::ff_Pipe<> pipe(farm1);
+	spb::ff_runtime_options(pipe);
 
 	printf("The total number of threads from the inner composition + the source and Sink is: %d\n", pipe.cardinality());
 
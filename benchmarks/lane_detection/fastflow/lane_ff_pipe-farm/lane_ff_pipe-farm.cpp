@@ -1,11 +1,12 @@
 #include <lane_detection.hpp>
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Source: ff::ff_node_t<spb::Item>{
 	Source(){}
 	spb::Item * svc(spb::Item * task){
 		while (1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source::op(*item)) break;
 			ff_send_out(item);
 		}
@@ -38,7 +39,7 @@ struct Sink: ff::ff_node_t<spb::Item>{
 	Sink(){}
 	spb::Item * svc(spb::Item * item){
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return GO_ON;
 	}
 };
@@ -54,7 +55,7 @@ int main (int argc, char* argv[]){
 	for(int i=0; i<spb::nthreads; i++){
 		W_set1.push_back(std::make_unique<Worker1>());
 	}
-	ff::ff_OFarm<spb::Item> farm1(move(W_set1));
+	ff::ff_Farm<spb::Item> farm1(move(W_set1));
 
 #if defined(DEBUG)
 	printf("First Farm: %d threads\n", pipeVec->cardinality());
@@ -64,7 +65,7 @@ int main (int argc, char* argv[]){
 	for(int i=0; i<spb::nthreads; i++){
 		W_set2.push_back(std::make_unique<Worker2>());
 	}
-	ff::ff_OFarm<spb::Item> farm2(move(W_set2));
+	ff::ff_Farm<spb::Item> farm2(move(W_set2));
 
 #if defined(DEBUG)
 	printf("Second Farm: %d threads\n", pipeRank->cardinality());
@@ -74,8 +75,11 @@ int main (int argc, char* argv[]){
 	Sink sink;
 	farm1.add_emitter(source);
 	farm2.add_collector(sink);
+	spb::ff_farm_options(farm1, true, false); // ordered, round-robin
+	spb::ff_farm_options(farm2, true, false);
 
 	ff::ff_Pipe<> pipe(farm1, farm2);
+	spb::ff_runtime_options(pipe);
 
 	printf("The total number of threads from the inner composition + the source and Sink is: %d\n", pipe.cardinality());
 
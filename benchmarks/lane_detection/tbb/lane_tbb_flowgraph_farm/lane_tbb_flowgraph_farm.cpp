@@ -0,0 +1,86 @@
+#include <lane_detection.hpp>
+#include <tbb/flow_graph.h>
+#include <tbb/global_control.h>
+
+/* oneTBB flow graph version of lane_tbb_farm:
+ * source -> limiter -> worker (nthreads) -> sequencer -> sink -> limiter.decrementer()
+ * The sequencer is left out in unordered mode (-U).
+ */
+
+// batches leave the source numbered from zero
+struct sequence{
+	size_t operator()(spb::Item * item) const {
+		return item->batch_index;
+	}
+};
+
+int main (int argc, char* argv[]){
+
+	// Disabling internal OpenCV's support for multithreading.
+	cv::setNumThreads(0);
+
+	spb::init_bench(argc, argv); //Initializations
+
+	//TBB code:
+	// a source waiting on the tuning gate (-A) holds a thread, so keep one more for the other nodes
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, spb::nthreads + (spb::SPBench::tuning_is_enabled() ? 1 : 0));
+
+	tbb::flow::graph g;
+
+	tbb::flow::input_node<spb::Item*> source(g, [](tbb::flow_control & fc) -> spb::Item* {
+		spb::Item * item = spb::item_pool.acquire();
+		if(!spb::Source::op(*item)){
+			spb::item_pool.release(item);
+			fc.stop();
+			return NULL;
+		}
+		return item;
+	});
+
+	// backpressure: bounds the number of batches between source and sink
+	int capacity = spb::SPBench::getQueueCapacity(spb::nthreads*10);
+	tbb::flow::limiter_node<spb::Item*> limiter(g, capacity);
+	// the input node fetches one batch ahead of the limiter
+	spb::item_pool.reserve(capacity + 1);
+
+	tbb::flow::function_node<spb::Item*, spb::Item*> worker(g, spb::nthreads, [](spb::Item * item) -> spb::Item* {
+		spb::Segment::op(*item);
+		spb::Canny1::op(*item);
+		spb::HoughT::op(*item);
+		spb::HoughP::op(*item);
+		spb::Bitwise::op(*item);
+		spb::Canny2::op(*item);
+		spb::Overlap::op(*item);
+		return item;
+	});
+
+	tbb::flow::sequencer_node<spb::Item*> sequencer(g, sequence());
+
+	tbb::flow::function_node<spb::Item*, tbb::flow::continue_msg> sink(g, tbb::flow::serial, [](spb::Item * item) -> tbb::flow::continue_msg {
+		spb::Sink::op(*item);
+		spb::item_pool.release(item);
+		return tbb::flow::continue_msg();
+	});
+
+	tbb::flow::make_edge(source, limiter);
+	tbb::flow::make_edge(limiter, worker);
+	if(spb::SPBench::isOrdered(true)){
+		tbb::flow::make_edge(worker, sequencer);
+		tbb::flow::make_edge(sequencer, sink);
+	} else {
+		// unordered (-U): the sink takes the batches as they complete
+		tbb::flow::make_edge(worker, sink);
+	}
+	tbb::flow::make_edge(sink, limiter.decrementer());
+
+	spb::Metrics::init();
+
+	source.activate();
+	g.wait_for_all();
+
+	spb::Metrics::stop();
+
+	spb::end_bench();
+
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include <lane_detection.hpp>
+#include <tbb/parallel_pipeline.h>
+#include <tbb/global_control.h>
+
+/* oneTBB version of lane_tbb_farm, using parallel_pipeline instead of the legacy tbb::pipeline */
+
+int main (int argc, char* argv[]){
+
+	// Disabling internal OpenCV's support for multithreading.
+	cv::setNumThreads(0);
+
+	spb::init_bench(argc, argv); //Initializations
+
+	//TBB code:
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, spb::nthreads);
+
+	spb::Metrics::init();
+
+	tbb::parallel_pipeline(spb::SPBench::getQueueCapacity(spb::nthreads*10),
+		tbb::make_filter<void, spb::Item*>(spb::SPBench::isOrdered(true) ? tbb::filter_mode::serial_in_order : tbb::filter_mode::serial_out_of_order,
+			[](tbb::flow_control & fc) -> spb::Item* {
+				spb::Item * item = spb::item_pool.acquire();
+				if(!spb::Source::op(*item)){
+					spb::item_pool.release(item);
+					fc.stop();
+					return NULL;
+				}
+				return item;
+			}) &
+		tbb::make_filter<spb::Item*, spb::Item*>(tbb::filter_mode::parallel,
+			[](spb::Item * item) -> spb::Item* {
+				spb::Segment::op(*item);
+				spb::Canny1::op(*item);
+				spb::HoughT::op(*item);
+				spb::HoughP::op(*item);
+				spb::Bitwise::op(*item);
+				spb::Canny2::op(*item);
+				spb::Overlap::op(*item);
+				return item;
+			}) &
+		tbb::make_filter<spb::Item*, void>(spb::SPBench::isOrdered(true) ? tbb::filter_mode::serial_in_order : tbb::filter_mode::serial_out_of_order,
+			[](spb::Item * item){
+				spb::Sink::op(*item);
+				spb::item_pool.release(item);
+			})
+	);
+
+	spb::Metrics::stop();
+
+	spb::end_bench();
+
+	return 0;
+}
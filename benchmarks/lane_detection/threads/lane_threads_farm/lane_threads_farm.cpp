@@ -78,6 +78,8 @@ void collector(SParSharedQueue<struct data> * queue2){
 	struct data * local;
 	std::priority_queue<struct data*,std::deque<struct data*>,compare_task_data> pqueue_buffer;
 	int local_id = 0;
+	// unordered (-U): the items go to the sink as they arrive
+	bool ordered = spb::SPBench::isOrdered(true);
 	while(1){
 		local = queue2->Remove();
 		if(local->omp_spar_eos){
@@ -85,7 +87,7 @@ void collector(SParSharedQueue<struct data> * queue2){
 		}
 		
 		while(1){
-			if(local->order_id!=local_id){
+			if(ordered && local->order_id!=local_id){
 				pqueue_buffer.push(local);
 				break;
 			}
@@ -112,8 +114,8 @@ int main (int argc, char* argv[]){
 
 	spb::Metrics::init();
 
-	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,1);
-	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(QUEUESIZE*spb::nthreads,spb::nthreads);
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
 
 	// Stage 1
 	std::thread stage1(emitter,queue1);
@@ -0,0 +1,78 @@
+#include <person_recognition.hpp>
+
+#include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
+
+/* Ordered farm of pipelines: each worker is a Detect -> Recognize pipeline */
+
+struct Emitter: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * task){
+		while (1){
+			spb::Item * item = spb::item_pool.acquire();
+			if (!spb::Source::op(*item)) break;
+		    ff_send_out(item);
+		}
+		return EOS;
+	}
+};
+
+struct Detect: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		//detect faces in the image:
+		spb::Detect::op(*item);
+		return item;
+	}
+};
+
+struct Recognize: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		//analyze each detected face:
+		spb::Recognize::op(*item);
+		return item;
+	}
+};
+
+struct Collector: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Sink::op(*item);
+		spb::item_pool.release(item);
+		return GO_ON;
+	}
+}Collector;
+
+int main (int argc, char* argv[]){
+	//Disabling internal OpenCV's support for multithreading. 
+	cv::setNumThreads(0);
+
+	spb::init_bench(argc, argv);
+	
+	spb::Metrics::init();
+
+	std::vector<std::unique_ptr<ff::ff_node>> workers;
+
+	for(int i=0; i<spb::nthreads; i++){
+		// build worker pipeline
+		ff::ff_pipeline * pipe = new ff::ff_pipeline;
+		pipe->add_stage(new Detect, true);
+		pipe->add_stage(new Recognize, true);
+		workers.push_back(std::unique_ptr<ff::ff_node>(pipe));
+	}
+
+	ff::ff_Farm<spb::Item> farm(move(workers));
+
+	Emitter E;
+	farm.add_emitter(E);
+	farm.add_collector(Collector);
+
+	spb::ff_farm_options(farm, true, true); // ordered, on-demand
+
+	if(farm.run_and_wait_end()<0){
+		std::cout << "error running pipe";
+	}
+
+	spb::Metrics::stop();
+	
+	spb::end_bench();
+	return 0;
+}
+
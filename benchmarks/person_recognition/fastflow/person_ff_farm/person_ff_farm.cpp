@@ -1,11 +1,12 @@
 #include <person_recognition.hpp>
 
 #include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
 
 struct Emitter: ff::ff_node_t<spb::Item>{
 	spb::Item * svc(spb::Item * task){
 		while (1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source::op(*item)) break;
 		    ff_send_out(item);
 		}
@@ -27,7 +28,7 @@ struct Worker: ff::ff_node_t<spb::Item>{
 struct Collector: ff::ff_node_t<spb::Item>{
 	spb::Item * svc(spb::Item * item){
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return GO_ON;
 	}
 }Collector;
@@ -46,13 +47,13 @@ int main (int argc, char* argv[]){
 		workers.push_back(ff::make_unique<Worker>());
 	}
 
-	ff::ff_OFarm<spb::Item> farm(move(workers));
+	ff::ff_Farm<spb::Item> farm(move(workers));
 
 	Emitter E;
 	farm.add_emitter(E);
 	farm.add_collector(Collector);
 
-	farm.set_scheduling_ondemand();
+	spb::ff_farm_options(farm, true, true); // ordered, on-demand
 
 	if(farm.run_and_wait_end()<0){
 		std::cout << "error running pipe";
@@ -0,0 +1,81 @@
+#include <person_recognition.hpp>
+
+#include <ff/ff.hpp>
+#include <spbench_fastflow.hpp>
+
+/* Pipeline of ordered farms: Detect farm -> Recognize farm */
+
+struct Emitter: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * task){
+		while (1){
+			spb::Item * item = spb::item_pool.acquire();
+			if (!spb::Source::op(*item)) break;
+		    ff_send_out(item);
+		}
+		return EOS;
+	}
+};
+
+struct Detect: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		//detect faces in the image:
+		spb::Detect::op(*item);
+		return item;
+	}
+};
+
+struct Recognize: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		//analyze each detected face:
+		spb::Recognize::op(*item);
+		return item;
+	}
+};
+
+struct Collector: ff::ff_node_t<spb::Item>{
+	spb::Item * svc(spb::Item * item){
+		spb::Sink::op(*item);
+		spb::item_pool.release(item);
+		return GO_ON;
+	}
+}Collector;
+
+int main (int argc, char* argv[]){
+	//Disabling internal OpenCV's support for multithreading. 
+	cv::setNumThreads(0);
+
+	spb::init_bench(argc, argv);
+	
+	spb::Metrics::init();
+
+	std::vector<std::unique_ptr<ff::ff_node>> detectors;
+	std::vector<std::unique_ptr<ff::ff_node>> recognizers;
+
+	for(int i=0; i<spb::nthreads; i++){
+		detectors.push_back(ff::make_unique<Detect>());
+		recognizers.push_back(ff::make_unique<Recognize>());
+	}
+
+	// each ordered farm keeps the order of its input, so the whole pipeline is ordered
+	ff::ff_Farm<spb::Item> detect_farm(move(detectors));
+	Emitter E;
+	detect_farm.add_emitter(E);
+	spb::ff_farm_options(detect_farm, true, true); // ordered, on-demand
+
+	ff::ff_Farm<spb::Item> recognize_farm(move(recognizers));
+	recognize_farm.add_collector(Collector);
+	spb::ff_farm_options(recognize_farm, true, true);
+
+	ff::ff_Pipe<> pipe(detect_farm, recognize_farm);
+	spb::ff_runtime_options(pipe);
+
+	if(pipe.run_and_wait_end()<0){
+		std::cout << "error running pipe";
+	}
+
+	spb::Metrics::stop();
+	
+	spb::end_bench();
+	return 0;
+}
+
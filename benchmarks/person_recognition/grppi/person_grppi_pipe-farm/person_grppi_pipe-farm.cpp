@@ -0,0 +1,69 @@
+#include <person_recognition.hpp>
+#include "grppi/grppi.h"
+#include "dyn/dynamic_execution.h"
+
+/* Pipeline of farms: Detect farm -> Recognize farm */
+
+using namespace std;
+using namespace experimental;
+
+void run(grppi::dynamic_execution & ex) {
+	tbb::task_scheduler_init init(spb::nthreads);
+	grppi::pipeline(ex,
+		[]() mutable -> optional<spb::Item*> {
+			spb::Item * item = spb::item_pool.acquire();
+			if(!spb::Source::op(*item)) {
+				spb::item_pool.release(item);
+				return {};
+			} else { 
+				return item;
+			}
+		},
+		grppi::farm(spb::nthreads,
+			[](spb::Item * item) {
+			spb::Detect::op(*item); //detect faces in the image:
+			return item;
+		}),
+		grppi::farm(spb::nthreads,
+			[](spb::Item * item) {
+			spb::Recognize::op(*item); //analyze each detected face:
+			return item;
+		}),
+		[](spb::Item * item) { spb::Sink::op(*item); spb::item_pool.release(item); }
+	);
+}
+
+grppi::dynamic_execution execution_mode(){
+	string backend = spb::SPBench::getArg(0);
+	if(backend == "tbb"){
+		auto ex = grppi::parallel_execution_tbb(spb::nthreads, spb::SPBench::isOrdered(true));
+		ex.set_queue_attributes(1, grppi::queue_mode::blocking, spb::SPBench::getQueueCapacity(spb::nthreads*10));
+		return ex;
+	} else if (backend == "ff"){
+		auto ex = grppi::parallel_execution_ff(spb::nthreads, spb::SPBench::isOrdered(true));
+		return ex;
+	} else if (backend == "omp"){
+		auto ex = grppi::parallel_execution_omp(spb::nthreads, spb::SPBench::isOrdered(true));
+		ex.set_queue_attributes(1, grppi::queue_mode::blocking);
+		return ex;
+	} else if (backend == "thr"){
+		auto ex = grppi::parallel_execution_native(spb::nthreads, spb::SPBench::isOrdered(true));
+		ex.set_queue_attributes(1, grppi::queue_mode::blocking);
+		return ex;
+	} else {
+		cout << "No backend selected" << endl;
+		exit(1);
+	}
+}
+
+int main (int argc, char* argv[]){
+	// Disabling internal OpenCV's support for multithreading.
+	cv::setNumThreads(0);
+	spb::init_bench(argc, argv); //Initializations
+	spb::Metrics::init();
+	auto ex = execution_mode();
+	run(ex);
+	spb::Metrics::stop();
+	spb::end_bench();
+	return 0;
+}
\ No newline at end of file
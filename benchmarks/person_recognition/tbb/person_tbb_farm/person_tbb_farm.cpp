@@ -4,10 +4,10 @@
 
 class stage1 : public tbb::filter{
 public:
-	stage1() : tbb::filter(tbb::filter::serial_in_order) {}
+	stage1() : tbb::filter(spb::SPBench::isOrdered(true) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
 	void* operator() (void*){
 		while(1){
-			spb::Item * item = new spb::Item();
+			spb::Item * item = spb::item_pool.acquire();
 			if (!spb::Source::op(*item)) break;
 			return item;
 		}
@@ -31,11 +31,11 @@ public:
 
 class stage3 : public tbb::filter{
 public:
-	stage3() : tbb::filter(tbb::filter::serial_in_order) {}
+	stage3() : tbb::filter(spb::SPBench::isOrdered(true) ? tbb::filter::serial_in_order : tbb::filter::serial_out_of_order) {}
 	void* operator() (void* new_item){
 		spb::Item * item = static_cast <spb::Item*> (new_item);
 		spb::Sink::op(*item);
-		delete item;
+		spb::item_pool.release(item);
 		return NULL;
 	}
 };
@@ -60,7 +60,7 @@ int main (int argc, char* argv[]){
 	stage3 write;
 	pipeline.add_filter(write);
 
-	pipeline.run(spb::nthreads*10);
+	pipeline.run(spb::SPBench::getQueueCapacity(spb::nthreads*10));
 
 	spb::Metrics::stop();
 	spb::end_bench();
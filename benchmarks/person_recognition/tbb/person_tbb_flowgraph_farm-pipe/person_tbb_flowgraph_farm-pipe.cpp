@@ -0,0 +1,101 @@
+#include <person_recognition.hpp>
+#include <tbb/flow_graph.h>
+#include <tbb/global_control.h>
+#include <memory>
+
+/* Farm of pipelines with a oneTBB flow graph. The legacy tbb::pipeline cannot
+ * nest a pipeline inside a parallel filter, so each replica is a chain of two
+ * serial nodes (Detect -> Recognize):
+ * source -> limiter -> dispatch -> replica[i] -> sequencer -> sink -> limiter.decrementer()
+ * The sequencer is left out in unordered mode (-U).
+ */
+
+typedef tbb::flow::function_node<spb::Item*, spb::Item*> stage_node_t;
+
+// batches leave the source numbered from zero
+struct sequence{
+	size_t operator()(spb::Item * item) const {
+		return item->batch_index;
+	}
+};
+
+int main (int argc, char* argv[]){
+	//Disabling internal OpenCV's support for multithreading.
+	cv::setNumThreads(0);
+
+	spb::init_bench(argc, argv);
+
+	//TBB code:
+	// a source waiting on the tuning gate (-A) holds a thread, so keep one more for the other nodes
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, spb::nthreads + (spb::SPBench::tuning_is_enabled() ? 1 : 0));
+
+	tbb::flow::graph g;
+
+	tbb::flow::input_node<spb::Item*> source(g, [](tbb::flow_control & fc) -> spb::Item* {
+		spb::Item * item = spb::item_pool.acquire();
+		if(!spb::Source::op(*item)){
+			spb::item_pool.release(item);
+			fc.stop();
+			return NULL;
+		}
+		return item;
+	});
+
+	// backpressure: bounds the number of batches between source and sink
+	int capacity = spb::SPBench::getQueueCapacity(spb::nthreads*10);
+	tbb::flow::limiter_node<spb::Item*> limiter(g, capacity);
+	// the input node fetches one batch ahead of the limiter
+	spb::item_pool.reserve(capacity + 1);
+
+	tbb::flow::sequencer_node<spb::Item*> sequencer(g, sequence());
+
+	// each replica is a pipeline of two serial stages
+	std::vector<std::unique_ptr<stage_node_t>> detect, recognize;
+	for(int i=0; i<spb::nthreads; i++){
+		detect.push_back(std::unique_ptr<stage_node_t>(new stage_node_t(g, tbb::flow::serial, [](spb::Item * item) -> spb::Item* {
+			//detect faces in the image:
+			spb::Detect::op(*item);
+			return item;
+		})));
+		recognize.push_back(std::unique_ptr<stage_node_t>(new stage_node_t(g, tbb::flow::serial, [](spb::Item * item) -> spb::Item* {
+			//analyze each detected face:
+			spb::Recognize::op(*item);
+			return item;
+		})));
+		tbb::flow::make_edge(*detect[i], *recognize[i]);
+	}
+
+	// round-robin the batches over the replicas
+	tbb::flow::function_node<spb::Item*, tbb::flow::continue_msg> dispatch(g, tbb::flow::serial, [&detect](spb::Item * item) -> tbb::flow::continue_msg {
+		detect[item->batch_index % detect.size()]->try_put(item);
+		return tbb::flow::continue_msg();
+	});
+
+	tbb::flow::function_node<spb::Item*, tbb::flow::continue_msg> sink(g, tbb::flow::serial, [](spb::Item * item) -> tbb::flow::continue_msg {
+		spb::Sink::op(*item);
+		spb::item_pool.release(item);
+		return tbb::flow::continue_msg();
+	});
+
+	tbb::flow::make_edge(source, limiter);
+	tbb::flow::make_edge(limiter, dispatch);
+	if(spb::SPBench::isOrdered(true)){
+		for(auto & replica : recognize)
+			tbb::flow::make_edge(*replica, sequencer);
+		tbb::flow::make_edge(sequencer, sink);
+	} else {
+		// unordered (-U): the replicas feed the sink directly
+		for(auto & replica : recognize)
+			tbb::flow::make_edge(*replica, sink);
+	}
+	tbb::flow::make_edge(sink, limiter.decrementer());
+
+	spb::Metrics::init();
+
+	source.activate();
+	g.wait_for_all();
+
+	spb::Metrics::stop();
+	spb::end_bench();
+	return 0;
+}
@@ -0,0 +1,149 @@
+/*
+Author: Renato Hoffmann
+Email: <renato.hoffmann@edu.pucrs.br>
+December 2022
+
+Although validated, there are no guarantees that this code will work. 
+In case of questions, please contact via email.
+*/
+
+/* Pipeline of farms: any Detect replica can feed any Recognize replica */
+
+#include <person_recognition.hpp>
+#include <queue>
+#include "SPar_Shared_Queue.hpp"
+
+#ifdef ONDEMAND
+    #define QUEUESIZE 1
+#else
+    #define QUEUESIZE 512
+#endif
+
+
+struct data{
+	spb::Item item;
+	bool omp_spar_eos;
+	int order_id;
+};
+
+struct compare_task_data{
+	bool operator()(struct data * t1, struct data * t2){
+		return (t1->order_id > t2->order_id);
+	}
+	bool operator()(const struct data & t1, const struct data & t2){
+		return (t1.order_id > t2.order_id);
+	}
+	bool operator()(struct data && t1, struct data && t2){
+		return (t1.order_id > t2.order_id);
+	}
+};
+
+void emitter(SParSharedQueue<struct data> * queue1){
+	struct data * local;
+	int curr_id = 0;
+	while(1){
+		spb::Item item;
+		if(!spb::Source::op(item)) {
+			queue1->NotifyEOS();
+			break;
+		}
+		local = new struct data();
+		local->omp_spar_eos = false;
+		local->item = item;
+		local->order_id = curr_id;
+		queue1->Add(local);
+		curr_id++;
+	}
+}
+
+void detect(SParSharedQueue<struct data> * inQueue, SParSharedQueue<struct data> * outQueue){
+	struct data * local;
+	while(1){
+		local = inQueue->Remove();
+		if(local->omp_spar_eos){
+			outQueue->NotifyEOS();
+			break;
+		}
+		spb::Detect::op(local->item); //detect faces in the image:
+		outQueue->Add(local);
+	}
+}
+
+void recognize(SParSharedQueue<struct data> * inQueue, SParSharedQueue<struct data> * outQueue){
+	struct data * local;
+	while(1){
+		local = inQueue->Remove();
+		if(local->omp_spar_eos){
+			outQueue->NotifyEOS();
+			break;
+		}
+		spb::Recognize::op(local->item); //analyze each detected face:
+		outQueue->Add(local);
+	}
+}
+
+void collector(SParSharedQueue<struct data> * queue3){
+	struct data * local;
+	std::priority_queue<struct data*,std::deque<struct data*>,compare_task_data> pqueue_buffer;
+	int local_id = 0;
+	// unordered (-U): the items go to the sink as they arrive
+	bool ordered = spb::SPBench::isOrdered(true);
+	while(1){
+		local = queue3->Remove();
+		if(local->omp_spar_eos){
+			break;
+		}
+		
+		while(1){
+			if(ordered && local->order_id!=local_id){
+				pqueue_buffer.push(local);
+				break;
+			}
+			spb::Sink::op(local->item);
+			local_id++;
+			delete local;
+			if(pqueue_buffer.empty() 
+				|| (local_id < pqueue_buffer.top()->order_id) )
+				break; 
+
+			local = pqueue_buffer.top();
+			pqueue_buffer.pop();
+
+		}
+
+	}
+}
+
+int main (int argc, char* argv[]){
+	// Disabling internal OpenCV's support for multithreading 
+	cv::setNumThreads(0);
+	spb::init_bench(argc, argv); // Initializations
+	spb::Metrics::init();
+
+	SParSharedQueue<struct data> * queue1 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),1);
+	SParSharedQueue<struct data> * queue2 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+	SParSharedQueue<struct data> * queue3 = new SParSharedQueue<struct data>(spb::SPBench::getQueueCapacity(QUEUESIZE*spb::nthreads),spb::nthreads);
+
+	// Stage 1
+	std::thread stage1(emitter,queue1);
+	// Stage 2 and 3
+	std::vector<std::thread> stage2, stage3;
+	for(int i=0;i < spb::nthreads; i++){
+		stage2.push_back(std::thread(detect,queue1,queue2));
+		stage3.push_back(std::thread(recognize,queue2,queue3));
+	}
+	// Stage 4
+	std::thread stage4(collector,queue3);
+
+	stage1.join();
+ 	for (auto& t : stage2)
+    	t.join();
+ 	for (auto& t : stage3)
+    	t.join();
+	stage4.join();
+
+	spb::Metrics::stop();
+	spb::end_bench();
+	return 0;
+}
+
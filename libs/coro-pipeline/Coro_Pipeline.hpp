@@ -0,0 +1,418 @@
+/**
+ * ************************************************************************
+ *  File  : Coro_Pipeline.hpp
+ *
+ *  Title : C++20 coroutine-based stream executor
+ *
+ *  Stages are coroutines that communicate through bounded async channels.
+ *  A fixed pool of OS threads resumes whichever stage is ready, so the
+ *  number of stages (and replicas) is not tied to the number of threads.
+ *
+ * ************************************************************************
+**/
+
+#ifndef CORO_PIPELINE_HPP
+#define CORO_PIPELINE_HPP
+
+#include <coroutine>
+#include <optional>
+#include <deque>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <cstdio>
+#include <sys/resource.h>
+
+namespace coro {
+
+class executor;
+
+/* Fire-and-forget coroutine used for pipeline stages */
+class task {
+public:
+	struct promise_type {
+		executor * exec = nullptr;
+
+		task get_return_object(){
+			return task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		// stages start only when spawned on an executor
+		std::suspend_always initial_suspend() noexcept { return {}; }
+
+		struct final_awaiter {
+			bool await_ready() noexcept { return false; }
+			void await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+			void await_resume() noexcept {}
+		};
+		final_awaiter final_suspend() noexcept { return {}; }
+
+		void return_void(){}
+		void unhandled_exception(){ std::terminate(); }
+	};
+
+	explicit task(std::coroutine_handle<promise_type> h): handle(h){}
+	task(task && other) noexcept : handle(other.handle){ other.handle = nullptr; }
+	task(const task&) = delete;
+	task& operator=(const task&) = delete;
+	~task(){
+		if(handle) handle.destroy(); // never spawned
+	}
+
+	std::coroutine_handle<promise_type> release(){
+		auto h = handle;
+		handle = nullptr;
+		return h;
+	}
+
+private:
+	std::coroutine_handle<promise_type> handle;
+};
+
+/* Fixed-size thread pool that resumes ready coroutines */
+class executor {
+private:
+	std::mutex mtx;
+	std::condition_variable ready_cv;
+	std::condition_variable done_cv;
+	std::deque<std::coroutine_handle<>> ready;
+	using timer = std::pair<std::chrono::steady_clock::time_point, std::coroutine_handle<>>;
+	struct timer_later {
+		bool operator()(const timer & a, const timer & b) const { return a.first > b.first; }
+	};
+	std::priority_queue<timer, std::vector<timer>, timer_later> timers; // earliest first
+	std::vector<std::thread> workers;
+	size_t running_tasks;
+	bool stopping;
+
+	std::atomic<unsigned long> resumes;
+	std::atomic<unsigned long> suspensions;
+
+	void worker_loop(){
+		while(1){
+			std::coroutine_handle<> h;
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				while(1){
+					auto now = std::chrono::steady_clock::now();
+					while(!timers.empty() && timers.top().first <= now){ // due timers become ready
+						ready.push_back(timers.top().second);
+						timers.pop();
+					}
+					if(!ready.empty() || stopping) break;
+					if(timers.empty())
+						ready_cv.wait(lock);
+					else
+						ready_cv.wait_until(lock, timers.top().first);
+				}
+				if(ready.empty()) return;
+				h = ready.front();
+				ready.pop_front();
+			}
+			resumes.fetch_add(1, std::memory_order_relaxed);
+			h.resume();
+		}
+	}
+
+public:
+	explicit executor(size_t nthreads):
+		running_tasks(0),
+		stopping(false),
+		resumes(0),
+		suspensions(0)
+	{
+		if(nthreads < 1) nthreads = 1;
+		for(size_t i = 0; i < nthreads; i++)
+			workers.emplace_back(&executor::worker_loop, this);
+	}
+
+	executor(const executor&) = delete;
+	executor& operator=(const executor&) = delete;
+
+	~executor(){
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stopping = true;
+		}
+		ready_cv.notify_all();
+		for(auto & t : workers)
+			if(t.joinable()) t.join();
+	}
+
+	size_t num_threads() const { return workers.size(); }
+
+	/* Queue a suspended coroutine to be resumed by one of the pool threads */
+	void schedule(std::coroutine_handle<> h){
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			ready.push_back(h);
+		}
+		ready_cv.notify_one();
+	}
+
+	/* Queue a suspended coroutine to be resumed once the given time is reached */
+	void schedule_at(std::chrono::steady_clock::time_point when, std::coroutine_handle<> h){
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			timers.push({when, h});
+		}
+		ready_cv.notify_one(); // an idle thread may be waiting for a later timer
+	}
+
+	/* Suspend the calling stage for the given time without holding a pool thread */
+	struct sleep_awaiter {
+		executor & exec;
+		std::chrono::microseconds duration;
+
+		bool await_ready() noexcept { return duration.count() <= 0; }
+		void await_suspend(std::coroutine_handle<> h){
+			exec.count_suspension();
+			exec.schedule_at(std::chrono::steady_clock::now() + duration, h);
+		}
+		void await_resume() noexcept {}
+	};
+
+	sleep_awaiter sleep_for(std::chrono::microseconds duration){ return sleep_awaiter{*this, duration}; }
+
+	/* Start a stage coroutine on the pool */
+	void spawn(task && t){
+		auto h = t.release();
+		h.promise().exec = this;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			running_tasks++;
+		}
+		schedule(h);
+	}
+
+	/* Block the calling (non-pool) thread until every spawned stage returned */
+	void wait(){
+		std::unique_lock<std::mutex> lock(mtx);
+		while(running_tasks > 0)
+			done_cv.wait(lock);
+	}
+
+	void task_done(){
+		std::lock_guard<std::mutex> lock(mtx);
+		running_tasks--;
+		if(running_tasks == 0)
+			done_cv.notify_all();
+	}
+
+	void count_suspension(){ suspensions.fetch_add(1, std::memory_order_relaxed); }
+
+	unsigned long get_resumes() const { return resumes.load(); }
+	unsigned long get_suspensions() const { return suspensions.load(); }
+
+	/* Print scheduler counters, and the context switches of the whole process
+	 * to compare with the thread-per-stage runtimes */
+	void print_stats(){
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		printf("------------- COROUTINE EXECUTOR --------------\n\n");
+		printf("\tPool threads = %lu\n", (unsigned long) workers.size());
+		printf("\tCoroutine resumes = %lu\n", get_resumes());
+		printf("\tCoroutine suspensions = %lu\n", get_suspensions());
+		printf("\n\tVoluntary context switches = %ld\n", usage.ru_nvcsw);
+		printf("\tInvoluntary context switches = %ld\n", usage.ru_nivcsw);
+		printf("\n-----------------------------------------------\n");
+	}
+};
+
+inline void task::promise_type::final_awaiter::await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+	executor * exec = h.promise().exec;
+	h.destroy();
+	if(exec) exec->task_done();
+}
+
+/* Auto-reset event: set() resumes one waiting stage, or lets the next wait()
+ * through if none is waiting. It may be set from any thread, coroutine or not.
+ */
+class event {
+private:
+	executor & exec;
+	std::mutex mtx;
+	std::deque<std::coroutine_handle<>> waiters;
+	bool signaled;
+
+public:
+	explicit event(executor & _exec): exec(_exec), signaled(false){}
+
+	event(const event&) = delete;
+	event& operator=(const event&) = delete;
+
+	struct wait_awaiter {
+		event & ev;
+
+		bool await_ready() noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> h){
+			std::lock_guard<std::mutex> lock(ev.mtx);
+			if(ev.signaled){
+				ev.signaled = false;
+				return false;
+			}
+			ev.waiters.push_back(h);
+			ev.exec.count_suspension();
+			return true;
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	wait_awaiter wait(){ return wait_awaiter{*this}; }
+
+	void set(){
+		std::coroutine_handle<> h;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if(waiters.empty()){
+				signaled = true;
+				return;
+			}
+			h = waiters.front();
+			waiters.pop_front();
+		}
+		exec.schedule(h);
+	}
+};
+
+/* Bounded multi-producer multi-consumer channel awaited by stage coroutines.
+ * A pop returns an empty optional once every producer called producer_done()
+ * and the buffer was drained.
+ */
+template <typename T>
+class channel {
+private:
+	struct waiting_pusher {
+		std::coroutine_handle<> handle;
+		T * value;
+	};
+	struct waiting_popper {
+		std::coroutine_handle<> handle;
+		std::optional<T> * slot;
+	};
+
+	executor & exec;
+	std::mutex mtx;
+	std::deque<T> buffer;
+	std::deque<waiting_pusher> pushers;
+	std::deque<waiting_popper> poppers;
+	size_t capacity;
+	size_t producers;
+	size_t finished_producers;
+	bool closed;
+
+public:
+	channel(executor & _exec, size_t _capacity, size_t _producers = 1):
+		exec(_exec),
+		capacity(_capacity),
+		producers(_producers),
+		finished_producers(0),
+		closed(false)
+	{}
+
+	channel(const channel&) = delete;
+	channel& operator=(const channel&) = delete;
+
+	size_t get_capacity() const { return capacity; }
+
+	struct push_awaiter {
+		channel & ch;
+		T value;
+
+		bool await_ready() noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> h){
+			channel & c = ch; // 'this' may be resumed on another thread once the lock is released
+			std::unique_lock<std::mutex> lock(c.mtx);
+			if(!c.poppers.empty()){ // hand the value straight to a waiting consumer
+				waiting_popper p = c.poppers.front();
+				c.poppers.pop_front();
+				p.slot->emplace(std::move(value));
+				lock.unlock();
+				c.exec.schedule(p.handle);
+				return false;
+			}
+			if(c.buffer.size() < c.capacity){
+				c.buffer.push_back(std::move(value));
+				return false;
+			}
+			c.pushers.push_back({h, &value});
+			c.exec.count_suspension();
+			return true;
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	struct pop_awaiter {
+		channel & ch;
+		std::optional<T> result;
+
+		bool await_ready() noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> h){
+			channel & c = ch;
+			std::unique_lock<std::mutex> lock(c.mtx);
+			if(!c.buffer.empty()){
+				result.emplace(std::move(c.buffer.front()));
+				c.buffer.pop_front();
+				if(!c.pushers.empty()){ // room was made, refill from a blocked producer
+					waiting_pusher p = c.pushers.front();
+					c.pushers.pop_front();
+					c.buffer.push_back(std::move(*p.value));
+					lock.unlock();
+					c.exec.schedule(p.handle);
+				}
+				return false;
+			}
+			if(!c.pushers.empty()){ // zero-capacity rendezvous
+				waiting_pusher p = c.pushers.front();
+				c.pushers.pop_front();
+				result.emplace(std::move(*p.value));
+				lock.unlock();
+				c.exec.schedule(p.handle);
+				return false;
+			}
+			if(c.closed)
+				return false;
+			c.poppers.push_back({h, &result});
+			c.exec.count_suspension();
+			return true;
+		}
+
+		std::optional<T> await_resume(){ return std::move(result); }
+	};
+
+	push_awaiter push(T value){ return push_awaiter{*this, std::move(value)}; }
+
+	pop_awaiter pop(){ return pop_awaiter{*this, std::nullopt}; }
+
+	/* Each producer calls it once; the last one closes the channel */
+	void producer_done(){
+		std::vector<std::coroutine_handle<>> to_wake;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			finished_producers++;
+			if(finished_producers < producers) return;
+			closed = true;
+			if(buffer.empty()){
+				for(auto & p : poppers)
+					to_wake.push_back(p.handle);
+				poppers.clear();
+			}
+		}
+		for(auto h : to_wake)
+			exec.schedule(h);
+	}
+};
+
+} // end of namespace coro
+
+#endif
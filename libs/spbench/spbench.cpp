@@ -32,6 +32,10 @@
 	#include <upl.h>
 #endif
 
+#if defined(SPB_ALLOC_ACCOUNTING)
+	#include <malloc.h>
+#endif
+
 namespace spb{
 unsigned int nthreads = 1;
 
@@ -47,8 +51,19 @@ bool SPBench::memory_source = false;
 std::string SPBench::bench_path; //stores executable name from arg[0] in init_bench()
 std::vector<std::string> SPBench::userArgs;
 std::vector<std::string> SPBench::operator_name_list;
-unsigned long SPBench::pattern_cycle_start_time = 0;
 int SPBench::number_of_operators = 0;
+int SPBench::queue_capacity = 0;
+tuning_t SPBench::tuning;
+open_loop_t SPBench::open_loop;
+sampling_t SPBench::sampling;
+runtime_options_t SPBench::runtime_options;
+
+// protects the tuning state, shared by source and sink
+std::mutex tuning_mtx;
+std::condition_variable tuning_cv;
+std::function<void()> SPBench::in_flight_wait;
+std::function<void()> SPBench::in_flight_notify;
+bool SPBench::item_paced = false;
 
 void frequency_pattern(double elapsed_time);
 
@@ -103,6 +118,12 @@ void printGeneralUsage(){
 	fprintf(stderr, "  -M, --monitor-thread   <time_interval_ms> monitors latency, throughput, and CPU and memory usage, running it on an individual thread.\n");
 	fprintf(stderr, "  -r, --resource-usage   print memory consumption results generated by UPL library\n");
 	fprintf(stderr, "  -u, --user-arg         send a custom argument to be used inside your programm\n");
+	fprintf(stderr, "  -q, --queue-capacity   <n> number of in-flight tokens / queue capacity used by the parallel runtime\n");
+	fprintf(stderr, "  -A, --autotune         <max_latency_ms> search the number of in-flight batches online (0: no latency constraint)\n");
+	fprintf(stderr, "  -O, --open-loop        with -f/-F, measure latency from the scheduled arrival time of each batch\n");
+	fprintf(stderr, "  -s, --sample           <n|rate> per-operator latency of one batch every n batches, or of each batch with probability rate (0-1)\n");
+	fprintf(stderr, "  -R, --runtime          <opt,...> parallel runtime options: blocking|spinning, ordered|unordered, ondemand[=n]|roundrobin, mapping=<core:core:...>|nomapping (FastFlow versions)\n");
+	fprintf(stderr, "  -U, --unordered        the sink takes the items as they complete instead of in the input order (same as -R unordered)\n");
 	fprintf(stderr, "  -h, --help             print this help message\n");
 }
 
@@ -262,22 +283,25 @@ void input_freq_pattern_parser(std::string pattern){
  * 
  * It presets up a frequency pattern.
  *
+ * @param freq_patt: pattern to be filled, the global one or the one of a source.
  * @param freq_pattern: it is the name of a frequency pattern, e.g. wave, increasing, etc.
  * @param freq_period: it is the time period of a cycle in the pattern
  * @param freq_low: it is the minimum possible frequency
  * @param freq_high: it is the maxiumum possible frequency
- * @param freq_spike: it is the spike size as percentage of the period (0-100) (optional) (default is 10%)
+ * @param freq_spike: it is the spike size as percentage of the period (0-100)
+ * @param freq_phase: it shifts the wave, spike and binary patterns by this many seconds (optional) (default is 0)
  *
- * @return nothing.
+ * @return the frequency the pattern starts from.
  */
-void SPBench::setFrequencyPattern(std::string freq_pattern, float freq_period, float freq_low, float freq_high, float freq_spike){
-	if(freq_pattern == "none") return;
+float set_frequency_pattern(frequencyPattern_t &freq_patt, std::string freq_pattern, float freq_period, float freq_low, float freq_high, float freq_spike, float freq_phase){
+	if(freq_pattern == "none") return 0.0;
 		
 	try{
 		if(freq_period < 0) throw std::invalid_argument("\n ERROR in setFrequencyPattern() --> Period must be higher than zero. Given value: " + std::to_string(freq_period) + "!\n");
 		if(freq_low < 0) throw std::invalid_argument("\n ERROR in setFrequencyPattern() --> Minimum frequency must be higher than zero. Given value: " + std::to_string(freq_low) + "!\n");
 		if(freq_high < 0) throw std::invalid_argument("\n ERROR in setFrequencyPattern() --> maxiumum frequency must be higher than zero. Given value: " + std::to_string(freq_high) + "!\n");
 		if(freq_low > freq_high) throw std::invalid_argument("\n ERROR in setFrequencyPattern() --> Minimum frequency must be lower than maximum. Given values:  min = " + std::to_string(freq_low) + ", max = " + std::to_string(freq_high) + "!\n");
+		if(freq_phase < 0) throw std::invalid_argument("\n ERROR in setFrequencyPattern() --> Phase can not be negative. Given value: " + std::to_string(freq_phase) + "!\n");
 		if(freq_pattern == "wave" || freq_pattern == "binary" || freq_pattern == "spike" || freq_pattern == "increasing" || freq_pattern == "decreasing"){
 			if(freq_pattern == "spike"){
 				if((freq_spike < 0) || (freq_spike > 100)){
@@ -289,6 +313,7 @@ void SPBench::setFrequencyPattern(std::string freq_pattern, float freq_period, f
 			freq_patt.period = freq_period;
 			freq_patt.low = freq_low;
 			freq_patt.high = freq_high;
+			freq_patt.phase = freq_phase;
 
 			freq_patt.range_freq = freq_high - freq_low;
 			freq_patt.amplitude = freq_patt.range_freq / 2;
@@ -298,11 +323,10 @@ void SPBench::setFrequencyPattern(std::string freq_pattern, float freq_period, f
 			freq_patt.wave_preset = 2 * M_PI * freq_patt.wavelength; // we do this here because it can be computed only once
 			
 			if(freq_pattern == "wave")
-				setFrequency(freq_patt.off_set);
+				return (freq_patt.amplitude * sin(freq_patt.wave_preset * freq_phase)) + freq_patt.off_set;
 			if(freq_pattern == "increasing" || freq_pattern == "binary" || freq_pattern == "spike")
-				setFrequency(freq_low);
-			if(freq_pattern == "decreasing")
-				setFrequency(freq_high);
+				return freq_low;
+			return freq_high; // decreasing
 		} else {
 			throw std::invalid_argument("\n ERROR in setFrequencyPattern() --> Invalid pattern: " + freq_pattern + "!\n");
 		}
@@ -312,43 +336,171 @@ void SPBench::setFrequencyPattern(std::string freq_pattern, float freq_period, f
 }
 
 /**
- * Item frequency control
+ * Set frequency pattern
  * 
- * It computes a waiting time based on a desired frequency and wait.
+ * It presets up the frequency pattern used by the source of single-source benchmarks,
+ * which is also the default pattern of every source in n-source benchmarks.
  *
+ * @param freq_pattern: it is the name of a frequency pattern, e.g. wave, increasing, etc.
+ * @param freq_period: it is the time period of a cycle in the pattern
+ * @param freq_low: it is the minimum possible frequency
+ * @param freq_high: it is the maxiumum possible frequency
+ * @param freq_spike: it is the spike size as percentage of the period (0-100) (optional) (default is 10%)
+ *
+ * @return nothing.
+ */
+void SPBench::setFrequencyPattern(std::string freq_pattern, float freq_period, float freq_low, float freq_high, float freq_spike){
+	float initial_frequency = set_frequency_pattern(freq_patt, freq_pattern, freq_period, freq_low, freq_high, freq_spike);
+	if(freq_patt.pattern != "none")
+		setFrequency(initial_frequency);
+}
+
+/**
+ * Start frequency pattern
+ * 
+ * It sets the time origin of a pattern, shifted back by its phase.
+ *
+ * @param freq_patt: the pattern.
+ * @param start_time: time the source starts.
+ *
+ * @return nothing.
+ */
+void start_frequency_pattern(frequencyPattern_t &freq_patt, unsigned long start_time){
+	freq_patt.start_time = start_time;
+	freq_patt.cycle_start_time = start_time;
+	if(freq_patt.pattern == "spike" || freq_patt.pattern == "binary")
+		freq_patt.cycle_start_time -= (unsigned long) (freq_patt.phase * 1000000);
+}
+
+void SPBench::start_frequency_pattern(unsigned long start_time){
+	spb::start_frequency_pattern(freq_patt, start_time);
+}
+
+/**
+ * Pattern frequency control
+ *
+ * Waits until one inter-arrival time of the pattern frequency has passed since
+ * the last item. The pattern is computed again after every slice of at most
+ * 10 ms, so a source at a low frequency, or paused at zero, follows the pattern
+ * as soon as it rises instead of sleeping the long interval computed before.
+ *
+ * @param freq_patt: the pattern and its state.
+ * @param frequency: the frequency updated by the pattern.
  * @param last_source_item_timestamp: the timestamp of the last item that left the source.
  *
  * @return nothing.
  */
-void SPBench::item_frequency_control(unsigned long last_source_item_timestamp) { //receives the target rate
+void pattern_frequency_control(frequencyPattern_t &freq_patt, float &frequency, unsigned long last_source_item_timestamp){
+	const float max_slice = 10000.0; // usec
+	while(1){
+		compute_frequency_pattern(freq_patt, frequency);
+		float elapsed_time = (current_time_usecs() - last_source_item_timestamp);
+		float remaining_time = (frequency > 0.0 ? (1000000/frequency) - elapsed_time : max_slice);
+		if(remaining_time <= 0)
+			return;
+		usleep(std::min(remaining_time, max_slice));
+	}
+}
+
+/**
+ * Item frequency delay
+ *
+ * It computes how long the source still has to wait before its next item,
+ * running the pattern (if set one) on every call. With a pattern the wait is
+ * cut in slices of at most 10 ms, so a low frequency, or a pause at zero,
+ * follows the pattern as soon as it rises. The caller sleeps the returned
+ * time and calls it again until it returns 0. Sources that must not block
+ * (e.g. coroutines, that suspend on a timer) call it before Source::op, and
+ * item_frequency_control does not wait again for that item.
+ *
+ * @param last_source_item_timestamp: the timestamp of the last item that left the source.
+ *
+ * @return the time to wait in microseconds, 0 if the item can be read now.
+ */
+unsigned long SPBench::item_frequency_delay(unsigned long last_source_item_timestamp){
+	const double max_slice = 10000.0; // usec
+	bool pattern = (freq_patt.pattern != "none");
+
 	// if no value was given for items_reading_frequency, then ignore frequency control
-	if(items_reading_frequency <= 0.0) 
-		return;
-	
+	if(items_reading_frequency <= 0.0 && !pattern){
+		item_paced = true;
+		return 0;
+	}
+
 	// Run the pattern computation (if set one) to set the correct items_reading_frequency
 	SPBench::frequency_pattern();
 
-	// The time the source toke to process and send the last item
-	float last_source_item_processing_time = (current_time_usecs() - last_source_item_timestamp);
-
-	// Expected sleep time considering only the target frequency, 
-	// Divided by 1000000 in order to estimate the time interval in microseconds to wait before generating the next item. 
-	float expected_waiting_time = (1000000/items_reading_frequency);
+	double waiting_time;
+	if(items_reading_frequency <= 0.0){
+		// a pattern at zero pauses the source until it rises
+		waiting_time = max_slice;
+		open_loop.next_arrival = 0.0; // the open-loop schedule starts again after the pause
+		open_loop.scheduled = false;
+	} else {
+		// Expected sleep time considering only the target frequency, 
+		// Divided by 1000000 in order to estimate the time interval in microseconds to wait before generating the next item. 
+		float expected_waiting_time = (1000000/items_reading_frequency);
+		unsigned long now = current_time_usecs();
+
+		if(open_loop.enabled){
+			// Open loop: arrivals follow the schedule no matter how late the source is,
+			// so the time a batch waits for the pipeline is counted in its latency
+			if(!open_loop.scheduled){ // once per item
+				if(open_loop.next_arrival == 0.0) // the schedule starts with the first batch
+					open_loop.next_arrival = now;
+				open_loop.intended_arrival = open_loop.next_arrival;
+				open_loop.interval = expected_waiting_time;
+				open_loop.next_arrival += expected_waiting_time;
+				open_loop.scheduled = true;
+			}
+			waiting_time = (long) open_loop.intended_arrival - (long) now;
+		} else {
+			// The time the source toke to process and send the last item
+			float last_source_item_processing_time = (now - last_source_item_timestamp);
 
-	// Some of the expected waiting time has already spent by the source to compute last item
-	// So cut this spent time off the expected time for it to be more precise
-	float actual_waiting_time = expected_waiting_time - last_source_item_processing_time;
+			// Some of the expected waiting time has already spent by the source to compute last item
+			// So cut this spent time off the expected time for it to be more precise
+			waiting_time = expected_waiting_time - last_source_item_processing_time;
+		}
+	}
+	if(pattern && waiting_time > max_slice)
+		waiting_time = max_slice;
 
-	//std::cout << last_source_item_processing_time << " " << expected_waiting_time << " " << actual_waiting_time << std::endl;
 	// If the source spent more time than the expected waiting time, do not sleep
-	if(actual_waiting_time > 0)
-		usleep(actual_waiting_time); // 1000: milliseconds to microseconds
+	if(waiting_time < 1.0){
+		open_loop.scheduled = false;
+		item_paced = true;
+		return 0;
+	}
+	return waiting_time;
+}
+
+/**
+ * Item frequency control
+ * 
+ * It waits the time computed by item_frequency_delay, unless the source
+ * already did it for this item.
+ *
+ * @param last_source_item_timestamp: the timestamp of the last item that left the source.
+ *
+ * @return nothing.
+ */
+void SPBench::item_frequency_control(unsigned long last_source_item_timestamp) { //receives the target rate
+	if(item_paced){ // waited before Source::op (see item_frequency_delay)
+		item_paced = false;
+		return;
+	}
+	unsigned long waiting_time;
+	while((waiting_time = item_frequency_delay(last_source_item_timestamp)) > 0)
+		usleep(waiting_time);
+	item_paced = false;
 }
 
 /**
  * Item frequency control for nsources benchmarks
  * 
  * It computes a waiting time based on a desired frequency and wait.
+ * Sources with a pattern use pattern_frequency_control instead (see SuperSource::frequencyControl).
  *
  * @param last_source_item_timestamp: the timestamp of the last item that left the source.
  * @param items_reading_frequency: the target frequency of the respective source.
@@ -359,9 +511,6 @@ void item_frequency_control(unsigned long last_source_item_timestamp, float item
 	// if no value was given for items_reading_frequency, then ignore frequency control
 	if(items_reading_frequency <= 0.0) 
 		return;
-	
-	// Run the pattern computation (if set one) to set the correct items_reading_frequency
-	SPBench::frequency_pattern();
 
 	// The time the source toke to process and send the last item
 	float last_source_item_processing_time = (current_time_usecs() - last_source_item_timestamp);
@@ -380,8 +529,27 @@ void item_frequency_control(unsigned long last_source_item_timestamp, float item
 		usleep(actual_waiting_time); // 1000: milliseconds to microseconds
 }
 
-long spike_cycle_start_time = 0; // global var for spike freq. pattern
-bool max_state = false; // global state for binary freq. pattern
+/**
+ * Source frequency control
+ * 
+ * Runs the pattern of this source (if set one) and waits before its next item.
+ * Each source keeps its own pattern state, so sources do not interfere.
+ *
+ * @param last_source_item_timestamp: the timestamp of the last item that left this source.
+ *
+ * @return nothing.
+ */
+void SuperSource::frequencyControl(unsigned long last_source_item_timestamp){
+	if(sourceFreqPatt.pattern != "none"){
+		if(sourceFreqPatt.start_time == 0) // the pattern starts with the first item of this source
+			start_frequency_pattern(sourceFreqPatt, current_time_usecs());
+		// not checked against zero first, a pattern with a low of zero starts there
+		pattern_frequency_control(sourceFreqPatt, sourceFrequency, last_source_item_timestamp);
+		return;
+	}
+	item_frequency_control(last_source_item_timestamp, sourceFrequency);
+}
+
 /**
  * Frequency pattern
  * 
@@ -390,61 +558,453 @@ bool max_state = false; // global state for binary freq. pattern
  * @return nothing.
  */
 void SPBench::frequency_pattern(){
+	compute_frequency_pattern(freq_patt, items_reading_frequency);
+}
+
+/**
+ * Compute frequency pattern
+ * 
+ * It updates a frequency following the given pattern.
+ *
+ * @param freq_patt: the pattern and its state.
+ * @param frequency: the frequency to be updated.
+ *
+ * @return nothing.
+ */
+void compute_frequency_pattern(frequencyPattern_t &freq_patt, float &frequency){
 
 	if(freq_patt.pattern == "none") return;
 
-	double elapsed_time = (current_time_usecs() - Metrics::execution_init_clock) / 1000000.0;
+	double elapsed_time = (current_time_usecs() - freq_patt.start_time) / 1000000.0 + freq_patt.phase;
 
-	float frequency;
     if(freq_patt.pattern == "wave"){ //sin formula: AMPLITUDE * sin(2 * M_PI * wavelength * time + off_set) + OFFSET;
-        items_reading_frequency = (freq_patt.amplitude * sin(freq_patt.wave_preset * elapsed_time)) + freq_patt.off_set;
+        frequency = (freq_patt.amplitude * sin(freq_patt.wave_preset * elapsed_time)) + freq_patt.off_set;
 	} else if(freq_patt.pattern == "spike"){
 
-		float pattern_cycle_elapsed_time = (current_time_usecs() - pattern_cycle_start_time) / 1000000.0;
+		float pattern_cycle_elapsed_time = (current_time_usecs() - freq_patt.cycle_start_time) / 1000000.0;
 		 
         if(pattern_cycle_elapsed_time > freq_patt.period - freq_patt.spikeInterval){
 			float step = freq_patt.range_freq / freq_patt.spikeInterval;
 
-			items_reading_frequency = freq_patt.low + ((pattern_cycle_elapsed_time - (freq_patt.period - freq_patt.spikeInterval)) * step);
+			frequency = freq_patt.low + ((pattern_cycle_elapsed_time - (freq_patt.period - freq_patt.spikeInterval)) * step);
 
 			if(pattern_cycle_elapsed_time > freq_patt.period){
-				pattern_cycle_start_time = current_time_usecs();
-				items_reading_frequency = freq_patt.low;
+				freq_patt.cycle_start_time = current_time_usecs();
+				frequency = freq_patt.low;
 			}
 		}
     } else if(freq_patt.pattern == "binary"){       		
-		float half_period_elapsed_time = (current_time_usecs() - pattern_cycle_start_time) / 1000000.0;
+		float half_period_elapsed_time = (current_time_usecs() - freq_patt.cycle_start_time) / 1000000.0;
 		if(half_period_elapsed_time > freq_patt.period / 2){
-			pattern_cycle_start_time = current_time_usecs();
-			if(!max_state){
-				items_reading_frequency = freq_patt.high;
-				max_state = true;
+			freq_patt.cycle_start_time = current_time_usecs();
+			if(!freq_patt.max_state){
+				frequency = freq_patt.high;
+				freq_patt.max_state = true;
 			} else {
-				items_reading_frequency = freq_patt.low;
-				max_state = false;
+				frequency = freq_patt.low;
+				freq_patt.max_state = false;
 			}
 		}
     } else if(freq_patt.pattern == "increasing"){
-        float item_elapsed_time = (current_time_usecs() - pattern_cycle_start_time) / 1000000.0;
-        if(items_reading_frequency < freq_patt.high) {
+        float item_elapsed_time = (current_time_usecs() - freq_patt.cycle_start_time) / 1000000.0;
+        if(frequency < freq_patt.high) {
 			// multiply the step it should increase per second by the elapsed time in seconds since the last step
-            items_reading_frequency += item_elapsed_time * freq_patt.step;
+            frequency += item_elapsed_time * freq_patt.step;
 		} else {
-            items_reading_frequency = freq_patt.high;
+            frequency = freq_patt.high;
 		}
-        pattern_cycle_start_time = current_time_usecs();
+        freq_patt.cycle_start_time = current_time_usecs();
     } else if(freq_patt.pattern == "decreasing"){
-        float item_elapsed_time = (current_time_usecs() - pattern_cycle_start_time) / 1000000.0;
-        if(items_reading_frequency > freq_patt.low){
+        float item_elapsed_time = (current_time_usecs() - freq_patt.cycle_start_time) / 1000000.0;
+        if(frequency > freq_patt.low){
 			// multiply the step it should decrease per second by the elapsed time in seconds since the last step
-            items_reading_frequency -= item_elapsed_time * freq_patt.step;
+            frequency -= item_elapsed_time * freq_patt.step;
 		} else {
-            items_reading_frequency = freq_patt.low;
+            frequency = freq_patt.low;
 		}
-        pattern_cycle_start_time = current_time_usecs();
+        freq_patt.cycle_start_time = current_time_usecs();
     }
 }
 
+/**
+ * Item arrival time
+ *
+ * Called by the source for every batch it emits, so the end of the stream
+ * is not accounted. In open-loop mode it returns the arrival time given by
+ * the schedule and accounts how late the batch left the source. Otherwise
+ * it returns the emission time.
+ *
+ * @param emission_time time the batch actually left the source.
+ * @return timestamp used to compute the latency of the batch.
+ */
+unsigned long SPBench::item_arrival_time(unsigned long emission_time){
+	if(!open_loop.enabled || open_loop.intended_arrival == 0)
+		return emission_time;
+
+	unsigned long lag = (emission_time > open_loop.intended_arrival ? emission_time - open_loop.intended_arrival : 0);
+	open_loop.batches++;
+	open_loop.lag_acc += lag;
+	if(lag > open_loop.max_lag) open_loop.max_lag = lag;
+	if(lag > open_loop.interval) open_loop.late_batches++;
+	return open_loop.intended_arrival;
+}
+
+/**
+ * Print open-loop results
+ *
+ * It prints how far behind its schedule the source was. A large lag means
+ * the target frequency was above what the benchmark could sustain.
+ *
+ * @return nothing.
+ */
+void SPBench::print_open_loop(){
+	printf("------------------ OPEN LOOP ------------------\n\n");
+	if(open_loop.batches == 0){
+		printf("\tNo arrival schedule, open-loop mode needs -f or -F\n");
+	} else {
+		printf("\tAverage source lag (ms) = %f\n", (open_loop.lag_acc / open_loop.batches) / 1000.0);
+		printf("\tMaximum source lag (ms) = %f\n", open_loop.max_lag / 1000.0);
+		printf("\tBatches behind schedule = %ld of %ld (%.2f%%)\n", open_loop.late_batches, open_loop.batches, (100.0 * open_loop.late_batches) / open_loop.batches);
+	}
+	printf("\n-----------------------------------------------\n");
+}
+
+/**
+ * Set the per-operator latency sampling
+ *
+ * @param sampling sampling state of a source.
+ * @param value values >= 1 sample one batch every 'value' batches, values
+ * between 0 and 1 sample each batch with this probability.
+ * @return nothing.
+ */
+void set_sampling(sampling_t &sampling, float value){
+	if(value <= 0)
+		throw std::invalid_argument("\n ARGUMENT ERROR (-s <n|rate>) --> Sampling must be a period (>= 1) or a rate between 0 and 1!\n");
+	if(value >= 1){
+		sampling.period = value;
+		sampling.rate = 0.0;
+	} else {
+		sampling.rate = value;
+	}
+}
+
+/**
+ * Sample a batch
+ *
+ * Called by the source once per batch. Sampled batches carry the per-operator
+ * latencies, while the end-to-end latency is measured for all of them.
+ *
+ * @param sampling sampling state of a source.
+ * @return true if the operators must record their latency for this batch.
+ */
+bool sample_batch(sampling_t &sampling){
+	if(!instrument::operators)
+		return false;
+	if(sampling.rate > 0.0)
+		return std::uniform_real_distribution<float>(0.0, 1.0)(sampling.generator) < sampling.rate;
+	return (sampling.counter++ % sampling.period) == 0;
+}
+
+/**
+ * Queue capacity
+ *
+ * Parallel versions call it wherever they need a number of in-flight tokens
+ * or a queue size, passing their original constant as the default.
+ *
+ * @param default_capacity capacity used when none was given by the user.
+ * @return the capacity to be used by the benchmark.
+ */
+int SPBench::getQueueCapacity(int default_capacity){
+	int capacity = (queue_capacity > 0 ? queue_capacity : default_capacity);
+	if(tuning.enabled){
+		// the runtime's own limit is the ceiling of the search
+		std::lock_guard<std::mutex> lock(tuning_mtx);
+		if(capacity > tuning.max_limit) tuning.max_limit = capacity;
+	}
+	return capacity;
+}
+
+/**
+ * Runtime options
+ *
+ * Parses the comma separated list of -R, --runtime. Options that are not
+ * given keep the default of the benchmark.
+ *
+ * @param options e.g. "spinning,unordered,ondemand=2,mapping=0:2:4".
+ * @return nothing. Throws std::invalid_argument for unknown options.
+ */
+void SPBench::setRuntimeOptions(std::string options){
+	std::stringstream ss(options);
+	std::string option;
+	while(std::getline(ss, option, ',')){
+		std::string value;
+		std::size_t eq = option.find('=');
+		if(eq != std::string::npos){
+			value = option.substr(eq + 1);
+			option = option.substr(0, eq);
+		}
+		if(option == "blocking" && value.empty()){
+			runtime_options.blocking = 1;
+		} else if(option == "spinning" && value.empty()){
+			runtime_options.blocking = 0;
+		} else if(option == "ordered" && value.empty()){
+			runtime_options.ordered = 1;
+		} else if(option == "unordered" && value.empty()){
+			runtime_options.ordered = 0;
+		} else if(option == "ondemand"){
+			runtime_options.ondemand = value.empty() ? 1 : atoi(value.c_str());
+			if(runtime_options.ondemand <= 0)
+				throw std::invalid_argument("\n ARGUMENT ERROR (-R ondemand=<n>) --> The worker queue size of on-demand scheduling must be higher than zero!\n");
+		} else if(option == "roundrobin" && value.empty()){
+			runtime_options.ondemand = 0;
+		} else if(option == "mapping"){
+			if(value.empty() || value.find_first_not_of("0123456789:") != std::string::npos)
+				throw std::invalid_argument("\n ARGUMENT ERROR (-R mapping=<core:core:...>) --> The mapping must be a list of core ids separated by ':'!\n");
+			runtime_options.mapping = value;
+		} else if(option == "nomapping" && value.empty()){
+			runtime_options.mapping.clear();
+		} else if(!option.empty()){
+			throw std::invalid_argument("\n ARGUMENT ERROR (-R <options>) --> Unknown runtime option: " + option + (value.empty() ? "" : "=" + value) + "\n Available: blocking, spinning, ordered, unordered, ondemand[=n], roundrobin, mapping=<core:core:...>, nomapping\n");
+		}
+	}
+}
+
+/**
+ * Enable tuning
+ *
+ * The number of batches in flight is searched online by hill-climbing
+ * on the throughput, only accepting values whose average latency stays
+ * below the given constraint.
+ *
+ * @param max_latency latency constraint in milliseconds, if <= 0 only throughput is considered.
+ * @return nothing.
+ */
+void SPBench::enable_tuning(float max_latency){
+	tuning.enabled = true;
+	tuning.max_latency = max_latency;
+}
+
+/**
+ * In-flight control
+ *
+ * Called by the source before emitting a batch, once the batch is known not
+ * to be empty (the end of the stream does not take a slot). It waits until
+ * the number of batches in flight is lower than the current tuned limit.
+ * If a wait hook was set (see setInFlightWait), it is called without the
+ * lock instead of blocking, until a slot is free.
+ *
+ * @return nothing.
+ */
+void SPBench::in_flight_control(){
+	if(!tuning.enabled)
+		return;
+
+	std::unique_lock<std::mutex> lock(tuning_mtx);
+	if(tuning.entered){ // slot taken before the batch was read (see in_flight_try_control)
+		tuning.entered = false;
+		return;
+	}
+	start_in_flight_limit();
+	while(tuning.in_flight >= tuning.limit){
+		if(in_flight_wait){
+			lock.unlock();
+			in_flight_wait();
+			lock.lock();
+		} else {
+			tuning_cv.wait(lock);
+		}
+	}
+	tuning.in_flight++;
+	if(tuning.in_flight > tuning.max_in_flight)
+		tuning.max_in_flight = tuning.in_flight;
+}
+
+/**
+ * In-flight try control
+ *
+ * Non-blocking form of in_flight_control, for sources that must not block
+ * (e.g. coroutines, that suspend until a batch leaves, see setInFlightNotify).
+ * Called before Source::op, it takes the slot of the next batch if one is
+ * free, and in_flight_control uses that slot. If the stream ended instead,
+ * the slot is given back with in_flight_cancel.
+ *
+ * @return true if the slot was taken (always with tuning disabled), false otherwise.
+ */
+bool SPBench::in_flight_try_control(){
+	if(!tuning.enabled)
+		return true;
+
+	std::lock_guard<std::mutex> lock(tuning_mtx);
+	if(tuning.entered)
+		return true;
+	start_in_flight_limit();
+	if(tuning.in_flight >= tuning.limit)
+		return false;
+	tuning.in_flight++;
+	if(tuning.in_flight > tuning.max_in_flight)
+		tuning.max_in_flight = tuning.in_flight;
+	tuning.entered = true;
+	return true;
+}
+
+/**
+ * In-flight cancel
+ *
+ * Gives back the slot taken by in_flight_try_control when Source::op
+ * found the end of the stream.
+ *
+ * @return nothing.
+ */
+void SPBench::in_flight_cancel(){
+	if(!tuning.enabled)
+		return;
+
+	std::lock_guard<std::mutex> lock(tuning_mtx);
+	if(tuning.entered){
+		tuning.entered = false;
+		tuning.in_flight--;
+	}
+}
+
+/**
+ * Start in-flight limit
+ *
+ * The search starts from one batch per thread at the first batch.
+ * Must be called holding tuning_mtx.
+ *
+ * @return nothing.
+ */
+void SPBench::start_in_flight_limit(){
+	if(tuning.limit == 0){
+		tuning.limit = nthreads;
+		if(tuning.max_limit > 0 && tuning.limit > tuning.max_limit)
+			tuning.limit = tuning.max_limit;
+		tuning.window_start = current_time_usecs();
+	}
+}
+
+/**
+ * In-flight release
+ *
+ * Called by the sink for every batch it receives. It feeds the current
+ * measurement window and moves the limit when the window is closed.
+ *
+ * @param item_timestamp timestamp given to the batch at the source.
+ * @param batch_size number of items in the batch.
+ * @return nothing.
+ */
+void SPBench::in_flight_release(unsigned long item_timestamp, int batch_size){
+	if(!tuning.enabled)
+		return;
+
+	unsigned long current_time = current_time_usecs();
+	{
+		std::lock_guard<std::mutex> lock(tuning_mtx);
+		tuning.in_flight--;
+		tuning.window_batches++;
+		tuning.window_items += batch_size;
+		tuning.window_latency_acc += (current_time - item_timestamp);
+
+		// a window lasts at least one monitoring interval and sees the pipeline full twice
+		if((current_time - tuning.window_start) / 1000.0 >= Metrics::get_monitoring_time_interval() &&
+			tuning.window_batches >= 2 * tuning.limit){
+			adjust_in_flight_limit(current_time);
+		}
+	}
+	tuning_cv.notify_one();
+	if(in_flight_notify)
+		in_flight_notify();
+}
+
+/**
+ * Adjust in-flight limit
+ *
+ * One hill-climbing step. While the result improves it keeps the direction
+ * and doubles the step, otherwise it turns back with half of the step.
+ * Values violating the latency constraint always move the limit down.
+ * Must be called holding tuning_mtx.
+ *
+ * @param current_time time that closes the window.
+ * @return nothing.
+ */
+void SPBench::adjust_in_flight_limit(unsigned long current_time){
+
+	float throughput = tuning.window_items / ((current_time - tuning.window_start) / 1000000.0);
+	float latency = (tuning.window_latency_acc / tuning.window_batches) / 1000.0;
+	bool feasible = (tuning.max_latency <= 0 || latency <= tuning.max_latency);
+
+	bool better;
+	if(tuning.last_latency < 0){ // first window
+		better = true;
+	} else if(feasible != tuning.last_feasible){
+		better = feasible;
+	} else if(feasible){
+		better = (throughput > tuning.last_throughput);
+	} else {
+		better = (latency < tuning.last_latency);
+	}
+
+	if(feasible && throughput > tuning.best_throughput){
+		tuning.best_limit = tuning.limit;
+		tuning.best_throughput = throughput;
+		tuning.best_latency = latency;
+	}
+
+	if(better){
+		tuning.step = std::min(tuning.step * 2, std::max(1, tuning.limit));
+	} else {
+		tuning.direction = -tuning.direction;
+		tuning.step = std::max(1, tuning.step / 2);
+	}
+	if(!feasible) tuning.direction = -1;
+
+	tuning.limit += tuning.direction * tuning.step;
+	if(tuning.limit < 1) tuning.limit = 1;
+	if(tuning.max_limit > 0 && tuning.limit > tuning.max_limit) tuning.limit = tuning.max_limit;
+
+	tuning.last_feasible = feasible;
+	tuning.last_throughput = throughput;
+	tuning.last_latency = latency;
+	tuning.adjustments++;
+
+	tuning.window_start = current_time;
+	tuning.window_items = 0;
+	tuning.window_batches = 0;
+	tuning.window_latency_acc = 0.0;
+}
+
+/**
+ * Print tuning results
+ *
+ * It prints the in-flight value chosen by the online search.
+ * The value can be fixed in later runs with -q.
+ * Versions that never have more than one batch in flight (e.g. the
+ * sequential ones) do not enforce the limit, so only a note is printed.
+ *
+ * @return nothing.
+ */
+void SPBench::print_tuning(){
+	printf("-------------------- TUNING -------------------\n\n");
+	if(tuning.max_limit == 0 && tuning.max_in_flight <= 1){
+		printf("\tNo batches overlapped, the in-flight limit has no effect in this version\n");
+		printf("\n-----------------------------------------------\n");
+		return;
+	}
+	if(tuning.max_latency > 0)
+		printf("\tLatency constraint (ms) = %f\n", tuning.max_latency);
+	printf("\tSearch steps = %ld\n", tuning.adjustments);
+	if(tuning.best_limit > 0){
+		printf("\tTuned in-flight batches = %d\n", tuning.best_limit);
+		printf("\tThroughput at tuned value (items/sec) = %f\n", tuning.best_throughput);
+		printf("\tLatency at tuned value (ms) = %f\n", tuning.best_latency);
+	} else if(tuning.adjustments > 0){
+		printf("\tNo value met the latency constraint, last in-flight batches = %d\n", tuning.limit);
+	} else {
+		printf("\tExecution too short to tune, in-flight batches = %d\n", tuning.limit);
+	}
+	printf("\n-----------------------------------------------\n");
+}
+
 /**
  * CPU usage
  * 
@@ -761,11 +1321,16 @@ void Metrics::init(){
 	print_date_time();
 	std::cout << std::endl;
 
+	if(!instrument::end_to_end && (print_latency || latency_to_file)){
+		std::cerr << " Warning: latency is not measured with the " << instrument::name() << " instrumentation policy." << std::endl;
+	}
+
 	if(throughput_is_enabled()){
 		metrics.start_throughput_clock = current_time_usecs();
 	}
 	
-	SPBench::pattern_cycle_start_time = item_old_time = execution_init_clock = current_time_usecs();
+	item_old_time = execution_init_clock = current_time_usecs();
+	SPBench::start_frequency_pattern(execution_init_clock);
 }
 
 /**
@@ -794,7 +1359,6 @@ data_metrics init_metrics(){
 	if(Metrics::throughput_is_enabled()){
 		metrics.start_throughput_clock = current_time_usecs();
 	}
-	SPBench::pattern_cycle_start_time = current_time_usecs();
 
 	return metrics;
 }
@@ -848,9 +1412,18 @@ void Metrics::stop(){
 	if(print_latency_is_enabled()){
 		print_average_latency();
 	}
+	#if defined(SPB_ALLOC_ACCOUNTING)
+		print_allocations(batches_at_sink_counter);
+	#endif
 	if(throughput_is_enabled()){
 		print_throughput(metrics);
 	}
+	if(SPBench::tuning_is_enabled()){
+		SPBench::print_tuning();
+	}
+	if(SPBench::open_loop_is_enabled()){
+		SPBench::print_open_loop();
+	}
 	if(latency_to_file_is_enabled()){
 		write_latency(prepareOutFileAt("log") + "_latency.dat");
 	}
@@ -948,6 +1521,13 @@ void compute_metrics(){
 			fclose(monitor_file);
 		}
 	}
+
+	#if defined(SPB_ALLOC_ACCOUNTING)
+		unsigned long batches = 0;
+		for (auto & element : metrics_vec)
+			batches += element.batches_at_sink_counter;
+		print_allocations(batches);
+	#endif
 }
 
 /**
@@ -991,6 +1571,108 @@ void print_throughput(data_metrics metrics){
 	printf("\n");
 }
 
+/**
+ * Count the operators with latency records
+ * 
+ * Depending on the instrumentation policy (see spb::instrument), only some
+ * batches or none of them carry per-operator latencies.
+ * 
+ * @param latency_vector latency records of the batches
+ * @param samples returns the number of batches with per-operator latencies
+ * @return the number of operators measured.
+ */
+template <typename T>
+unsigned int measured_operators(const std::vector<T> &latency_vector, unsigned long &samples){
+	unsigned int operators = 0;
+	samples = 0;
+	for(unsigned int i = 0; i < latency_vector.size(); i++){
+		if(latency_vector[i].local_latency.empty()) continue;
+		if(operators == 0) operators = latency_vector[i].local_latency.size();
+		samples++;
+	}
+	return operators;
+}
+
+/**
+ * Percentile of the end-to-end latency
+ * 
+ * @param latency_vector latency records of the batches
+ * @param percentile percentile to compute (0-100)
+ * @return the latency (usec) under which the given percentage of the batches fall.
+ */
+template <typename T>
+double latency_percentile(const std::vector<T> &latency_vector, double percentile){
+	if(latency_vector.empty()) return 0.0;
+	std::vector<double> latencies;
+	latencies.reserve(latency_vector.size());
+	for(unsigned int i = 0; i < latency_vector.size(); i++)
+		latencies.push_back(latency_vector[i].total_latency);
+	// nearest-rank method
+	size_t rank = (size_t)ceil(percentile / 100.0 * latencies.size());
+	if(rank > 0) rank--;
+	std::nth_element(latencies.begin(), latencies.begin() + rank, latencies.end());
+	return latencies[rank];
+}
+
+/**
+ * Print the results of an operator replay
+ * 
+ * It prints the service time distribution of the single thread replay and
+ * the throughput of each number of threads.
+ * 
+ * @param operator_name name of the replayed operator
+ * @param results results of replay_operator() for each number of threads
+ * @return nothing.
+ */
+void print_replay(const std::string &operator_name, const std::vector<replay_result_t> &results){
+	if(results.empty() || results[0].service_time.empty()){
+		std::cerr << " Error: no batches were replayed." << std::endl;
+		return;
+	}
+
+	std::vector<double> service_time = results[0].service_time;
+	std::sort(service_time.begin(), service_time.end());
+	double sum = 0.0;
+	for(unsigned int i = 0; i < service_time.size(); i++)
+		sum += service_time[i];
+	double mean = sum / service_time.size();
+	double var = 0.0;
+	for(unsigned int i = 0; i < service_time.size(); i++)
+		var += (service_time[i] - mean) * (service_time[i] - mean);
+
+	// nearest-rank percentile
+	auto percentile = [&service_time](double p){
+		size_t rank = (size_t)ceil(p / 100.0 * service_time.size());
+		return service_time[rank > 0 ? rank - 1 : 0];
+	};
+
+	printf("\n--------------- OPERATOR REPLAY ---------------\n\n");
+	printf("  Operator: %s\n", operator_name.c_str());
+	printf("  Batches per thread: %lu\n", results[0].batches);
+	printf("\n  Service time, 1 thread (ms):\n");
+	printf("\t   Mean = %.3f (std. dev. %.3f)\n", mean/1000.0, sqrt(var / service_time.size())/1000.0);
+	printf("\t    Min = %.3f\n", service_time.front()/1000.0);
+	printf("\t    p50 = %.3f\n", percentile(50.0)/1000.0);
+	printf("\t    p90 = %.3f\n", percentile(90.0)/1000.0);
+	printf("\t    p99 = %.3f\n", percentile(99.0)/1000.0);
+	printf("\t    Max = %.3f\n", service_time.back()/1000.0);
+
+	double base = results[0].items / (results[0].elapsed / 1000000.0);
+	printf("\n  Threads   Items-per-second   Speedup   Efficiency   Mean service (ms)%s\n", results[0].bytes > 0 ? "   MB/s" : "");
+	for(unsigned int i = 0; i < results.size(); i++){
+		double throughput = results[i].items / (results[i].elapsed / 1000000.0);
+		double service = 0.0;
+		for(unsigned int j = 0; j < results[i].service_time.size(); j++)
+			service += results[i].service_time[j];
+		printf("  %7u   %16.3f   %7.2f   %9.1f%%   %17.3f", results[i].nthreads, throughput, throughput/base, 100.0*throughput/base/results[i].nthreads, service/results[i].service_time.size()/1000.0);
+		if(results[i].bytes > 0)
+			printf("   %.1f", results[i].bytes / (results[i].elapsed / 1000000.0) / (1024.0*1024.0));
+		printf("\n");
+	}
+	printf("\n  A mean service time growing with the threads points to shared\n  resources (memory bandwidth, locks, allocator) limiting the operator.\n");
+	printf("\n-----------------------------------------------\n");
+}
+
 /**
  * Print average latency
  * 
@@ -1009,7 +1691,8 @@ void Metrics::print_average_latency(){
 	//std::vector<std::string> operator_name_list = set_operators_name();
 	double total = 0.0;
 
-	for(unsigned int j = 0; j < latency_vector[0].local_latency.size(); j++)
+	unsigned long samples;
+	for(unsigned int j = 0; j < measured_operators(latency_vector, samples); j++)
 		operator_aux.push_back(0.0); //initialize the vector to receive the sum of latencies
 
 	float max_latency = 0.0;
@@ -1029,16 +1712,21 @@ void Metrics::print_average_latency(){
 		}
 	}
 	printf("\n--------------- AVERAGE LATENCY ---------------\n\n");
-	if(SPBench::get_operator_name_list().size() != latency_vector[0].local_latency.size()){
+	if(operator_aux.empty()){
+		printf("\tOperators not measured (%s instrumentation)\n", instrument::name());
+	} else if(SPBench::get_operator_name_list().size() != operator_aux.size()){
 		printf("Warning: the list of operator names does not match up the number of analyzed operators.\n");
 		printf("The names will be changed to default names.\n\n");
 		for(unsigned int j = 0; j < operator_aux.size(); j++)
-			printf("\tOperator %d = %f\n", j, (operator_aux[j]/latency_vector.size()));
+			printf("\tOperator %d = %f\n", j, (operator_aux[j]/samples));
 	} else {
 		for(unsigned int j = 0; j < operator_aux.size(); j++)	
-			printf("\tOperator %s = %f\n", SPBench::get_operator_name_list()[j].c_str(), (operator_aux[j]/latency_vector.size()));
+			printf("\tOperator %s = %f\n", SPBench::get_operator_name_list()[j].c_str(), (operator_aux[j]/samples));
 	}
+	if(!operator_aux.empty() && samples < latency_vector.size())
+		printf("\n\tSampling rate = %.4f (operators measured in %lu of %lu batches)\n", (double)samples/latency_vector.size(), samples, (unsigned long)latency_vector.size());
 	printf("\n  End-to-end latency (ms) = %.3f\n", (total/latency_vector.size())/1000.0);
+	printf("         p99 latency (ms) = %.3f\n", latency_percentile(latency_vector, 99.0)/1000.0);
 	printf("\n     Maximum latency (ms) = %.3f (at %.1f sec)\n", max_latency/1000.0, max_ts/1000000.0);
 	printf("     Minimum latency (ms) = %.3f (at %.1f sec)\n", min_latency/1000.0, min_ts/1000000.0);
 	printf("\n-----------------------------------------------\n");
@@ -1063,7 +1751,8 @@ void print_average_latency(data_metrics metrics){
 	//std::vector<std::string> operator_name_list = set_operators_name();
 	double total = 0.0;
 
-	for(unsigned int j = 0; j < metrics.latency_vector_ns[0].local_latency.size(); j++)
+	unsigned long samples;
+	for(unsigned int j = 0; j < measured_operators(metrics.latency_vector_ns, samples); j++)
 		operator_aux.push_back(0.0); //initialize the vector to receive the sum of latencies
 
 	float max_latency = 0.0;
@@ -1083,16 +1772,21 @@ void print_average_latency(data_metrics metrics){
 		}
 	}
 	printf("-------------- AVERAGE LATENCIES --------------\n\n");
-	if(SPBench::get_operator_name_list().size() != metrics.latency_vector_ns[0].local_latency.size()){
+	if(operator_aux.empty()){
+		printf("\t Operators not measured (%s instrumentation)\n", instrument::name());
+	} else if(SPBench::get_operator_name_list().size() != operator_aux.size()){
 		printf("Warning: the list of operator names does not match up the number of analyzed operators.\n");
 		printf("The names will be changed to default names.\n\n");
 		for(unsigned int j = 0; j < operator_aux.size(); j++)
-			printf("\t Operator %d = %f\n", j, (operator_aux[j]/metrics.latency_vector_ns.size()));
+			printf("\t Operator %d = %f\n", j, (operator_aux[j]/samples));
 	} else {
 		for(unsigned int j = 0; j < operator_aux.size(); j++)	
-			printf("\t Operator %s = %f\n", SPBench::get_operator_name_list()[j].c_str(), (operator_aux[j]/metrics.latency_vector_ns.size()));
+			printf("\t Operator %s = %f\n", SPBench::get_operator_name_list()[j].c_str(), (operator_aux[j]/samples));
 	}
+	if(!operator_aux.empty() && samples < metrics.latency_vector_ns.size())
+		printf("\n\t Sampling rate = %.4f (operators measured in %lu of %lu batches)\n", (double)samples/metrics.latency_vector_ns.size(), samples, (unsigned long)metrics.latency_vector_ns.size());
 	printf("\n  End-to-end latency (ms) = %f \n", (total/metrics.latency_vector_ns.size())/1000.0);
+	printf("         p99 latency (ms) = %.3f\n", latency_percentile(metrics.latency_vector_ns, 99.0)/1000.0);
 	printf("\n     Maximum latency (ms) = %.3f\n", max_latency/1000.0);
 	printf("     Minimum latency (ms) = %.3f\n", min_latency/1000.0);
 	printf("\n-----------------------------------------------\n");
@@ -1113,10 +1807,12 @@ void Metrics::write_latency(std::string file_name){
 	latency_file = fopen(file_name.c_str(), "w");
 
 	//write the head of the file
-	if(SPBench::get_operator_name_list().size() != latency_vector[0].local_latency.size()){
+	unsigned long samples;
+	unsigned int operators = measured_operators(latency_vector, samples);
+	if(operators > 0 && SPBench::get_operator_name_list().size() != operators){
 		printf("Warning: the list of operator names does not match up the number of analyzed operators.\n");
 		printf("Operators' names will be changed to default names.\n\n");
-		for(unsigned int i = 0; i < latency_vector[0].local_latency.size(); i++)
+		for(unsigned int i = 0; i < operators; i++)
 			fprintf(latency_file, "Operator%d ", i);
 	} else {
 		for(unsigned int i = 0; i < SPBench::get_operator_name_list().size(); i++)
@@ -1126,6 +1822,7 @@ void Metrics::write_latency(std::string file_name){
 
 	//write the results 
 	for(unsigned int i = 0; i < latency_vector.size(); i++){
+		if(latency_vector[i].local_latency.empty()) continue; // batch not sampled
 		for(unsigned int j = 0; j < latency_vector[i].local_latency.size(); j++)
 			fprintf(latency_file, "%.4f ", (latency_vector[i].local_latency[j])/1000.0);
 		fprintf(latency_file, "\n");
@@ -1149,10 +1846,12 @@ void write_latency(data_metrics metrics){
 	latency_file = fopen(file_name.c_str(), "w");
 
 	//write the header of the file
-	if(SPBench::get_operator_name_list().size() != metrics.latency_vector_ns[0].local_latency.size()){
+	unsigned long samples;
+	unsigned int operators = measured_operators(metrics.latency_vector_ns, samples);
+	if(operators > 0 && SPBench::get_operator_name_list().size() != operators){
 		printf("Warning: the list of operator names does not match up the number of analyzed operators.\n");
 		printf("The names will be changed to default names.\n\n");
-		for(unsigned int i = 0; i < metrics.latency_vector_ns[0].local_latency.size(); i++)
+		for(unsigned int i = 0; i < operators; i++)
 			fprintf(latency_file, "Operator%d ", i);
 	} else {
 		for(unsigned int i = 0; i < SPBench::get_operator_name_list().size(); i++)
@@ -1162,6 +1861,7 @@ void write_latency(data_metrics metrics){
 
 	//write the results 
 	for(unsigned int i = 0; i < metrics.latency_vector_ns.size(); i++){
+		if(metrics.latency_vector_ns[i].local_latency.empty()) continue; // batch not sampled
 		for(unsigned int j = 0; j < metrics.latency_vector_ns[i].local_latency.size(); j++)
 			fprintf(latency_file, "%.4f ", (metrics.latency_vector_ns[i].local_latency[j])/1000.0);
 		fprintf(latency_file, "\n");
@@ -1169,4 +1869,240 @@ void write_latency(data_metrics metrics){
 	fclose(latency_file);
 }
 
+#if defined(SPB_ALLOC_ACCOUNTING)
+
+/* Counters of one thread for each operator. Only the owner thread updates
+ * them (except for the threads beyond SPB_ALLOC_THREADS, which share the
+ * last ones), so the relaxed atomic additions do not contend.
+ */
+struct alloc_counters_t{
+	std::atomic<unsigned long> allocations;
+	std::atomic<unsigned long> frees;
+	std::atomic<unsigned long> bytes;
+	std::atomic<unsigned long> nanoseconds;
+};
+
+struct alignas(64) alloc_thread_t{
+	alloc_counters_t operators[SPB_ALLOC_OPERATORS];
+};
+
+// zero-initialized before any allocation of the program
+static alloc_thread_t alloc_threads[SPB_ALLOC_THREADS];
+static std::atomic<int> alloc_threads_used(0);
+static const char *alloc_operator_names[SPB_ALLOC_OPERATORS] = {"Other"};
+static std::atomic<int> alloc_operators_used(1);
+static std::mutex alloc_names_mtx;
+
+static thread_local int alloc_thread = -1;
+static thread_local int alloc_operator = 0; // "Other"
+
+static inline alloc_counters_t &alloc_counters(){
+	if(alloc_thread < 0)
+		alloc_thread = std::min(alloc_threads_used.fetch_add(1, std::memory_order_relaxed), SPB_ALLOC_THREADS - 1);
+	return alloc_threads[alloc_thread].operators[alloc_operator];
+}
+
+static thread_local unsigned int alloc_calls = 0;
+
+// start of a timed call, 0 for the calls left out of the time sampling
+static inline unsigned long alloc_clock(){
+	if(++alloc_calls % SPB_ALLOC_TIME_SAMPLING != 0)
+		return 0;
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+// a timed call stands for the SPB_ALLOC_TIME_SAMPLING calls around it
+static inline void account_time(unsigned long start){
+	if(start == 0)
+		return;
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	unsigned long elapsed = ts.tv_sec * 1000000000UL + ts.tv_nsec - start;
+	alloc_counters().nanoseconds.fetch_add(elapsed * SPB_ALLOC_TIME_SAMPLING, std::memory_order_relaxed);
+}
+
+static inline void account_allocation(size_t size){
+	alloc_counters_t &counters = alloc_counters();
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static inline void account_free(){
+	alloc_counters().frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+// called once per operator (see AllocOperator), so a linear search is enough
+static int alloc_operator_id(const char *operator_name){
+	int used = alloc_operators_used.load(std::memory_order_acquire);
+	for(int i = 0; i < used; i++)
+		if(alloc_operator_names[i] == operator_name || strcmp(alloc_operator_names[i], operator_name) == 0)
+			return i;
+
+	std::lock_guard<std::mutex> lock(alloc_names_mtx);
+	used = alloc_operators_used.load(std::memory_order_relaxed);
+	for(int i = 0; i < used; i++)
+		if(strcmp(alloc_operator_names[i], operator_name) == 0)
+			return i;
+	if(used == SPB_ALLOC_OPERATORS)
+		return 0;
+	alloc_operator_names[used] = operator_name;
+	alloc_operators_used.store(used + 1, std::memory_order_release);
+	return used;
+}
+
+AllocOperator::AllocOperator(const char *operator_name){
+	id = alloc_operator_id(operator_name);
+}
+
+AllocScope::AllocScope(const AllocOperator &scope_operator){
+	previous = alloc_operator;
+	alloc_operator = scope_operator.id;
+}
+
+AllocScope::~AllocScope(){
+	alloc_operator = previous;
+}
+
+/**
+ * Print allocations
+ *
+ * It prints the allocations charged to each operator, per batch, and the
+ * time spent in the allocator, comparable to the operator latencies. The
+ * time is estimated from one call in SPB_ALLOC_TIME_SAMPLING.
+ *
+ * @param batches number of batches processed.
+ * @return nothing.
+ */
+void print_allocations(unsigned long batches){
+	if(batches < 1)
+		batches = 1;
+	int threads = std::min(alloc_threads_used.load(), SPB_ALLOC_THREADS);
+	unsigned long total_allocations = 0, total_bytes = 0;
+
+	printf("\n----------------- ALLOCATIONS -----------------\n\n");
+	printf("\t%-14s %10s %10s %10s %10s\n", "Per batch", "Allocs", "KB", "Frees", "Time (ms)");
+	for(int j = 0; j < alloc_operators_used.load(); j++){
+		unsigned long allocations = 0, frees = 0, bytes = 0, nanoseconds = 0;
+		for(int i = 0; i < threads; i++){
+			allocations += alloc_threads[i].operators[j].allocations.load(std::memory_order_relaxed);
+			frees += alloc_threads[i].operators[j].frees.load(std::memory_order_relaxed);
+			bytes += alloc_threads[i].operators[j].bytes.load(std::memory_order_relaxed);
+			nanoseconds += alloc_threads[i].operators[j].nanoseconds.load(std::memory_order_relaxed);
+		}
+		if(allocations == 0 && frees == 0)
+			continue;
+		printf("\t%-14s %10.1f %10.1f %10.1f %10.4f\n", alloc_operator_names[j],
+			(double) allocations / batches, bytes / 1024.0 / batches, (double) frees / batches, nanoseconds / 1000000.0 / batches);
+		total_allocations += allocations;
+		total_bytes += bytes;
+	}
+	printf("\n\tAllocations = %lu (%.1f MB) in %lu batches\n", total_allocations, total_bytes / (1024.0 * 1024.0), batches);
+	printf("\tThreads accounted = %d\n", threads);
+	printf("\tAllocator time sampled on 1 of %d calls\n", SPB_ALLOC_TIME_SAMPLING);
+	printf("\n-----------------------------------------------\n");
+}
+
+#endif
+
 } //end of namespace spb
+
+#if defined(SPB_ALLOC_ACCOUNTING)
+
+/* The allocation functions of the C library, defined by the executable, so
+ * they are also used by the shared libraries. They forward to the glibc
+ * allocator (__libc_*) and account the calls to the running operator.
+ */
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void *__libc_valloc(size_t size);
+void *__libc_pvalloc(size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size) noexcept {
+	unsigned long start = spb::alloc_clock();
+	void *ptr = __libc_malloc(size);
+	spb::account_time(start);
+	spb::account_allocation(size);
+	return ptr;
+}
+
+void *calloc(size_t nmemb, size_t size) noexcept {
+	unsigned long start = spb::alloc_clock();
+	void *ptr = __libc_calloc(nmemb, size);
+	spb::account_time(start);
+	spb::account_allocation(nmemb * size);
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size) noexcept {
+	unsigned long start = spb::alloc_clock();
+	void *new_ptr = __libc_realloc(ptr, size);
+	spb::account_time(start);
+	// on failure the old block is left untouched
+	if(new_ptr == NULL && size != 0)
+		return new_ptr;
+	// a block moved or resized is a free of the old one and a new allocation
+	if(ptr != NULL)
+		spb::account_free();
+	// realloc(NULL, 0) is a malloc(0), realloc(ptr, 0) only a free
+	if(ptr == NULL || size != 0)
+		spb::account_allocation(size);
+	return new_ptr;
+}
+
+void *memalign(size_t alignment, size_t size) noexcept {
+	unsigned long start = spb::alloc_clock();
+	void *ptr = __libc_memalign(alignment, size);
+	spb::account_time(start);
+	spb::account_allocation(size);
+	return ptr;
+}
+
+void *valloc(size_t size) noexcept {
+	unsigned long start = spb::alloc_clock();
+	void *ptr = __libc_valloc(size);
+	spb::account_time(start);
+	spb::account_allocation(size);
+	return ptr;
+}
+
+void *pvalloc(size_t size) noexcept {
+	unsigned long start = spb::alloc_clock();
+	void *ptr = __libc_pvalloc(size);
+	spb::account_time(start);
+	spb::account_allocation(size);
+	return ptr;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept {
+	return memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) noexcept {
+	if(alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+		return EINVAL;
+	void *ptr = memalign(alignment, size);
+	if(ptr == NULL && size != 0)
+		return ENOMEM;
+	*memptr = ptr;
+	return 0;
+}
+
+void free(void *ptr) noexcept {
+	if(ptr == NULL)
+		return;
+	unsigned long start = spb::alloc_clock();
+	__libc_free(ptr);
+	spb::account_time(start);
+	spb::account_free();
+}
+
+}
+
+#endif
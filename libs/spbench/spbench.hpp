@@ -39,6 +39,7 @@
 #include <cstdlib>
 #include <sstream>
 #include <atomic>
+#include <memory>
 #include <stdexcept>
 #include <getopt.h>
 
@@ -57,6 +58,8 @@
 #include <condition_variable>
 #include <thread>
 #include <functional>
+#include <algorithm>
+#include <random>
 
 #define MAX_CAPACITY 50
 
@@ -65,12 +68,17 @@ extern unsigned int nthreads;
 
 class SPBench;
 class Metrics;
+class Batch;
 class blocking_queue;
 
 struct data_metrics;
 struct item_metrics_data;
 struct monitor_data;
 struct frequencyPattern_t;
+struct tuning_t;
+struct open_loop_t;
+struct runtime_options_t;
+struct sampling_t;
 
 std::string prepareOutFileAt(std::string);
 bool file_exists (const std::string&);
@@ -126,6 +134,12 @@ const struct option long_opts[] = {
 		{"monitor-thread", REQUIRED, 0, 'M'},
 		{"resource-usage", NONE, 0, 'r'},
 		{"user-arg", REQUIRED, 0, 'u'},	
+		{"queue-capacity", REQUIRED, 0, 'q'},
+		{"autotune", REQUIRED, 0, 'A'},
+		{"open-loop", NONE, 0, 'O'},
+		{"sample", REQUIRED, 0, 's'},
+		{"runtime", REQUIRED, 0, 'R'},
+		{"unordered", NONE, 0, 'U'},
         {0, 0, 0, 0}
 };
 
@@ -216,6 +230,10 @@ struct frequencyPattern_t{
 		float range_freq;
 		float step;
 		float spikeInterval;
+		float phase; // shift of the pattern in seconds
+		unsigned long start_time; // time origin of the pattern
+		unsigned long cycle_start_time;
+		bool max_state; // state of the binary pattern
 	frequencyPattern_t():
 		pattern("none"),
 		period(0.0),
@@ -227,10 +245,180 @@ struct frequencyPattern_t{
 		amplitude(0.0),
 		range_freq(0.0),
 		step(0.0),
-		spikeInterval(0.0)
+		spikeInterval(0.0),
+		phase(0.0),
+		start_time(0),
+		cycle_start_time(0),
+		max_state(false)
 	{}
 };
 
+float set_frequency_pattern(frequencyPattern_t &freq_patt, std::string freq_pattern, float freq_period, float freq_low, float freq_high, float freq_spike, float freq_phase = 0);
+void start_frequency_pattern(frequencyPattern_t &freq_patt, unsigned long start_time);
+void compute_frequency_pattern(frequencyPattern_t &freq_patt, float &frequency);
+void pattern_frequency_control(frequencyPattern_t &freq_patt, float &frequency, unsigned long last_source_item_timestamp);
+
+/* State of the online search for the number of in-flight batches */
+struct tuning_t{
+		bool enabled;
+		float max_latency; // latency constraint in milliseconds, <= 0 means throughput only
+		int limit; // batches allowed in flight right now
+		int max_limit; // largest capacity requested by the benchmark, 0 means unbounded
+		int step;
+		int direction;
+		int in_flight;
+		int max_in_flight; // most batches seen in flight, 1 if the runtime never overlaps them
+		bool entered; // slot of the next batch taken by in_flight_try_control
+		unsigned long window_start;
+		long window_items;
+		long window_batches;
+		double window_latency_acc;
+		bool last_feasible;
+		float last_throughput;
+		float last_latency;
+		int best_limit;
+		float best_throughput;
+		float best_latency;
+		long adjustments;
+	tuning_t():
+		enabled(false),
+		max_latency(0.0),
+		limit(0),
+		max_limit(0),
+		step(1),
+		direction(1),
+		in_flight(0),
+		max_in_flight(0),
+		entered(false),
+		window_start(0),
+		window_items(0),
+		window_batches(0),
+		window_latency_acc(0.0),
+		last_feasible(false),
+		last_throughput(0.0),
+		last_latency(-1.0), // no window closed yet
+		best_limit(0),
+		best_throughput(0.0),
+		best_latency(0.0),
+		adjustments(0)
+	{}
+};
+
+/* Arrival schedule of the source in open-loop mode */
+struct open_loop_t{
+		bool enabled;
+		double next_arrival; // intended emission time of the next batch (usec)
+		unsigned long intended_arrival; // intended emission time of the current batch (usec)
+		float interval; // inter-arrival time of the current batch (usec)
+		bool scheduled; // the next batch already has its arrival time
+		long batches;
+		long late_batches; // emitted more than one inter-arrival time after the intended time
+		double lag_acc;
+		unsigned long max_lag;
+	open_loop_t():
+		enabled(false),
+		next_arrival(0.0),
+		intended_arrival(0),
+		interval(0.0),
+		scheduled(false),
+		batches(0),
+		late_batches(0),
+		lag_acc(0.0),
+		max_lag(0)
+	{}
+};
+
+/* Run-time options of the parallel runtime (-R, --runtime), e.g.
+ * "spinning,unordered,ondemand=2,mapping=0:2:4". A value of -1 keeps the
+ * default of the benchmark. Applied by the FastFlow versions
+ * (spbench_fastflow.hpp), except the ordering (also set by -U, --unordered),
+ * which every version reads with SPBench::isOrdered().
+ */
+struct runtime_options_t{
+	int blocking; // 0: spinning, 1: blocking
+	int ordered; // 0: unordered farms, 1: ordered farms
+	int ondemand; // 0: round-robin, n > 0: on-demand scheduling with n-slot worker queues
+	std::string mapping; // cores the threads are pinned to (empty: no pinning)
+	runtime_options_t():
+		blocking(-1),
+		ordered(-1),
+		ondemand(-1)
+	{}
+};
+
+/* Instrumentation policies. The policy is fixed at build time with
+ * -DSPB_INSTRUMENT=<policy> (set by make_gen.py from the INSTRUMENT key of
+ * the config files), so the timing code disabled by a policy is compiled out
+ * of the operators, sources and sinks. The Instrument prefix keeps the names
+ * clear of macros such as None from X11 headers.
+ */
+#ifndef SPB_SAMPLE_PERIOD
+#define SPB_SAMPLE_PERIOD 16
+#endif
+
+struct InstrumentFull { // end-to-end and per-operator latency of every batch
+	static constexpr bool end_to_end = true;
+	static constexpr bool operators = true;
+	static constexpr unsigned long period = 1;
+	static const char * name(){return "Full";}
+};
+
+struct InstrumentEndToEndOnly { // end-to-end latency only
+	static constexpr bool end_to_end = true;
+	static constexpr bool operators = false;
+	static constexpr unsigned long period = 1;
+	static const char * name(){return "EndToEndOnly";}
+};
+
+struct InstrumentSampled { // end-to-end latency of every batch, per-operator latency of sampled batches (one in SPB_SAMPLE_PERIOD by default)
+	static constexpr bool end_to_end = true;
+	static constexpr bool operators = true;
+	static constexpr unsigned long period = SPB_SAMPLE_PERIOD;
+	static const char * name(){return "Sampled";}
+};
+
+struct InstrumentNone { // no latency measurement at all
+	static constexpr bool end_to_end = false;
+	static constexpr bool operators = false;
+	static constexpr unsigned long period = 1;
+	static const char * name(){return "None";}
+};
+
+template <typename Policy>
+struct Instrument {
+	static constexpr bool end_to_end = Policy::end_to_end;
+	static constexpr bool operators = Policy::operators;
+	static constexpr unsigned long period = Policy::period; // default sampling period of the operators
+	static const char * name(){return Policy::name();}
+};
+
+#ifndef SPB_INSTRUMENT
+#define SPB_INSTRUMENT InstrumentFull
+#endif
+
+typedef Instrument<SPB_INSTRUMENT> instrument;
+
+/* Selects the batches whose operators record their latency. The source
+ * samples one batch every 'period' batches or, when 'rate' is set, each
+ * batch with probability 'rate'. The decision is carried by the batch
+ * (Batch::sampled), so every operator measures the same batches.
+ */
+struct sampling_t{
+		unsigned long period;
+		float rate;
+		unsigned long counter;
+		std::minstd_rand generator;
+	sampling_t():
+		period(instrument::period),
+		rate(0.0),
+		counter(0),
+		generator(1)
+	{}
+};
+
+void set_sampling(sampling_t &sampling, float value);
+bool sample_batch(sampling_t &sampling);
+
 class SPBench{
 private:
 
@@ -247,6 +435,19 @@ private:
 
 	static int number_of_operators;
 
+	static int queue_capacity; // if <= 0, then benchmarks use their own default capacity
+	static tuning_t tuning;
+	static open_loop_t open_loop;
+	static sampling_t sampling;
+	static runtime_options_t runtime_options;
+
+	static bool item_paced; // the source already waited for the next item (see item_frequency_delay)
+
+	static void start_in_flight_limit();
+	static void adjust_in_flight_limit(unsigned long current_time);
+	static std::function<void()> in_flight_wait;
+	static std::function<void()> in_flight_notify;
+
 public:
 
 	static int getNewOpId();
@@ -254,10 +455,12 @@ public:
 	static void frequency_pattern();
 
 	static void item_frequency_control(unsigned long last_source_item_timestamp);
+	static unsigned long item_frequency_delay(unsigned long last_source_item_timestamp);
 
 	static void setFrequencyPattern(std::string freq_pattern, float freq_period, float freq_low, float freq_high, float freq_spike = 10);
+	static frequencyPattern_t getFrequencyPattern(){return freq_patt;}
 
-	static unsigned long pattern_cycle_start_time;
+	static void start_frequency_pattern(unsigned long start_time);
 	
 	static std::vector<std::string> userArgs;
 	static void setArg(std::string);
@@ -291,6 +494,45 @@ public:
 
 	static std::string getExecPath(){ return bench_path; }
 
+	static void setQueueCapacity(int _queue_capacity){queue_capacity = _queue_capacity;}
+	static int getQueueCapacity(int default_capacity);
+	static int getQueueCapacity(){return queue_capacity;}
+
+	static void setRuntimeOptions(std::string options);
+	static runtime_options_t getRuntimeOptions(){return runtime_options;}
+	static void setOrdered(bool ordered){runtime_options.ordered = ordered;}
+	static bool isOrdered(bool default_ordered){return (runtime_options.ordered < 0 ? default_ordered : runtime_options.ordered == 1);}
+
+	static void enable_tuning(float max_latency);
+	static bool tuning_is_enabled(){return tuning.enabled;}
+	static int getTuningMaxLimit(){return tuning.max_limit;}
+
+	static void in_flight_control();
+	// for sources that must not block, e.g. the thread creating OpenMP tasks, that has to keep running them
+	static void setInFlightWait(std::function<void()> wait){in_flight_wait = wait;}
+	// for sources that wait without blocking, e.g. coroutines: try before Source::op, and wait for the notification
+	static bool in_flight_try_control();
+	static void in_flight_cancel();
+	static void setInFlightNotify(std::function<void()> notify){in_flight_notify = notify;}
+	static void in_flight_release(unsigned long item_timestamp, int batch_size);
+	static void print_tuning();
+
+	// the source timestamps feed the latency, pacing, batch interval, tuning and open-loop schedule,
+	// with none of them in use (e.g. with InstrumentNone) the source does not read the clock
+	static bool source_timing_is_enabled(){
+		return instrument::end_to_end || tuning.enabled || open_loop.enabled || batch_interval > 0 ||
+			items_reading_frequency > 0.0 || freq_patt.pattern != "none";
+	}
+
+	static void enable_open_loop(){open_loop.enabled = true;}
+	static bool open_loop_is_enabled(){return open_loop.enabled;}
+	static unsigned long item_arrival_time(unsigned long emission_time);
+	static void print_open_loop();
+
+	static void setSampling(float value){set_sampling(sampling, value);}
+	static sampling_t getSampling(){return sampling;}
+	static bool batch_sampling(){return sample_batch(sampling);}
+
 };
 
 class Metrics {
@@ -418,7 +660,9 @@ public:
 	}
 
 	static void enable_latency(){latency = true;}
-	static bool latency_is_enabled(){return latency;}
+	static bool latency_is_enabled(){return instrument::end_to_end && latency;}
+	// per-operator latency of a given batch (see spb::instrument and spb::sampling_t)
+	static bool operator_latency_is_enabled(const Batch &item);
 
 	static void set_monitoring_time_interval(long _monitoring_time_interval){monitoring_time_interval = _monitoring_time_interval;}
 	static unsigned long get_monitoring_time_interval(){return monitoring_time_interval;}
@@ -427,13 +671,13 @@ public:
 		print_latency = true;
 		enable_latency();
 	}
-	static bool print_latency_is_enabled(){return print_latency;}
+	static bool print_latency_is_enabled(){return instrument::end_to_end && print_latency;}
 
 	static void enable_latency_to_file(){
 		latency_to_file = true;
 		enable_latency();
 	}
-	static bool latency_to_file_is_enabled(){return latency_to_file;}
+	static bool latency_to_file_is_enabled(){return instrument::end_to_end && latency_to_file;}
 
 }; // end of SPBench class
 
@@ -569,26 +813,167 @@ class Batch {
 		volatile unsigned long timestamp;
 		int batch_size;
 		int batch_index;
+		bool sampled; // its operators record their latency
 
 		Batch(int operators):
 			//latency_op(operators, 0.0),
 			timestamp(0.0),
 			batch_size(0),
-			batch_index(0)
+			batch_index(0),
+			sampled(true)
 		{};
 
 		~Batch(){
 			latency_op.clear();
 		}
+
+		// back to an empty batch, keeping the capacity of its buffers
+		void recycle(){
+			latency_op.clear();
+			timestamp = 0;
+			batch_size = 0;
+			batch_index = 0;
+			sampled = true;
+		}
+};
+
+/* Preallocated item slots. Sources acquire() an item and sinks release() it
+ * back, recycled by item_t::recycle() with the capacity of its buffers,
+ * instead of a new and a delete per batch. The last released slots are
+ * acquired first, while they are still in cache. If more items are in flight
+ * than slots, a new slot is allocated and counted, so the statistics show
+ * when (and whether) the steady state stopped allocating.
+ */
+template<typename item_t>
+class ItemPool{
+	private:
+		std::mutex pool_mutex;
+		std::vector<std::unique_ptr<item_t>> slots;
+		std::vector<item_t*> free_slots;
+		unsigned long preallocated;
+		unsigned long acquired;
+		unsigned long allocations; // slots allocated after reserve()
+		unsigned long last_allocation; // acquisition that allocated the last slot
+
+	public:
+		ItemPool():
+			preallocated(0),
+			acquired(0),
+			allocations(0),
+			last_allocation(0)
+		{}
+
+		void reserve(unsigned long n){
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			slots.reserve(n);
+			free_slots.reserve(n);
+			while(slots.size() < n){
+				slots.emplace_back(new item_t());
+				free_slots.push_back(slots.back().get());
+			}
+			preallocated = slots.size();
+		}
+
+		item_t *acquire(){
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			acquired++;
+			if(free_slots.empty()){
+				slots.emplace_back(new item_t());
+				allocations++;
+				last_allocation = acquired;
+				return slots.back().get();
+			}
+			item_t *item = free_slots.back();
+			free_slots.pop_back();
+			return item;
+		}
+
+		void release(item_t *item){
+			item->recycle();
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			free_slots.push_back(item);
+		}
+
+		void print_stats(){
+			if(acquired == 0)
+				return;
+			printf("---------------- ITEM SLOTS -------------------\n\n");
+			printf("\tPreallocated slots = %lu\n", preallocated);
+			printf("\tSlots allocated at run time = %lu\n", allocations);
+			if(allocations > 0)
+				printf("\tLast slot allocation at batch = %lu of %lu\n", last_allocation, acquired);
+			printf("\tAllocations per batch = %f\n", (double) allocations / acquired);
+			if(allocations > 0)
+				printf("\n\tWarning: the reserve is smaller than the batches held by this runtime\n");
+			printf("\n-----------------------------------------------\n");
+		}
 };
 
+/* Allocation accounting. Built with -DSPB_ALLOC_ACCOUNTING (the
+ * ALLOC_ACCOUNTING key of the config files), SPBench defines malloc, free
+ * and the other allocation functions of the C library, so the allocations of
+ * the whole benchmark, libraries included, are counted with their bytes and
+ * the time spent in the allocator, no LD_PRELOAD needed. They are charged to
+ * the operator running on the thread, set by the AllocScope at the start of
+ * the operators, sources and sinks; the rest (runtime, main thread) is
+ * charged to "Other". Without the macro an AllocScope does nothing.
+ * Cost: every call adds a thread-local lookup and two or three relaxed
+ * atomic additions on counters owned by the thread. Only one call in
+ * SPB_ALLOC_TIME_SAMPLING reads the clock (two clock_gettime), so the
+ * allocator time is an estimate. Allocation-heavy operators still run
+ * slower than in a build without the macro; compare latencies only between
+ * builds with the same setting.
+ */
+#define SPB_ALLOC_OPERATORS 32 // operator names accounted, "Other" included
+#define SPB_ALLOC_THREADS 256 // threads with their own counters, the others share the last ones
+#define SPB_ALLOC_TIME_SAMPLING 64 // one allocator call in this many is timed
+
+/* Operator charged by an AllocScope. It is a static of the operator, e.g.
+ *   static AllocOperator alloc_operator("Compress");
+ *   AllocScope alloc_scope(alloc_operator);
+ * so the name is looked up once and not on every call of the operator.
+ */
+class AllocOperator{
+#if defined(SPB_ALLOC_ACCOUNTING)
+	public:
+		int id;
+		AllocOperator(const char *operator_name);
+#else
+	public:
+		constexpr AllocOperator(const char *){}
+#endif
+};
+
+class AllocScope{
+#if defined(SPB_ALLOC_ACCOUNTING)
+	private:
+		int previous;
+	public:
+		AllocScope(const AllocOperator &scope_operator);
+		~AllocScope();
+#else
+	public:
+		AllocScope(const AllocOperator &){}
+#endif
+};
+
+#if defined(SPB_ALLOC_ACCOUNTING)
+void print_allocations(unsigned long batches);
+#endif
+
+inline bool Metrics::operator_latency_is_enabled(const Batch &item){
+	return instrument::operators && latency_is_enabled() && item.sampled;
+}
+
 /* This class implements the main methods used by nsources benchmarks */
 class SuperSource{
 
 	protected:
 		std::thread source_thread;
 
-		long sourceFrequency;
+		float sourceFrequency;
+		frequencyPattern_t sourceFreqPatt;
+		sampling_t sourceSampling;
 		int sourceBatchSize;
 		float sourceBatchInterval;
 		
@@ -614,21 +999,41 @@ class SuperSource{
 	public:
 		static int sourceObjCounter;
 
-		SuperSource(){}
+		// sources start with the pattern given by -F and the sampling given by -s, if any
+		SuperSource():
+			sourceFreqPatt(SPBench::getFrequencyPattern()),
+			sourceSampling(SPBench::getSampling())
+		{}
 
 		~SuperSource(){
 			tryToJoin();
 		}
 		
-		void setFrequency(long sourceFrequency){
+		void setFrequency(float sourceFrequency){
 			this->sourceFrequency = (sourceFrequency > 0 ? sourceFrequency : 0);
 			return;
 		}
 
-		long getFrequency(){
+		float getFrequency(){
 			return this->sourceFrequency;
 		}
 
+		// pattern owned by this source, the phase (in seconds) shifts it from other sources
+		void setFrequencyPattern(std::string freq_pattern, float freq_period, float freq_low, float freq_high, float freq_spike = 10, float freq_phase = 0){
+			frequencyPattern_t freq_patt;
+			float initial_frequency = set_frequency_pattern(freq_patt, freq_pattern, freq_period, freq_low, freq_high, freq_spike, freq_phase);
+			sourceFreqPatt = freq_patt;
+			if(freq_patt.pattern != "none")
+				setFrequency(initial_frequency);
+		}
+
+		void frequencyControl(unsigned long last_source_item_timestamp);
+
+		// per-operator latency sampling of this source (see spb::sampling_t)
+		void setSampling(float value){
+			set_sampling(sourceSampling, value);
+		}
+
 		void setSourceName(std::string sourceName){
 			this->sourceName = sourceName;
 			return;
@@ -693,6 +1098,82 @@ class SuperSource{
 		}
 };
 
+/* Operator isolation (replay) harness. Batches captured at the input of an
+ * operator in a sequential run are replayed through that operator alone by
+ * n independent threads, without source pacing, queues or other stages.
+ */
+struct replay_result_t{
+	unsigned int nthreads;
+	unsigned long batches; // replayed by all threads
+	unsigned long items;
+	double bytes; // input bytes replayed, if known by the application
+	double elapsed; // wall time (usec)
+	std::vector<double> service_time; // of each batch (usec)
+	replay_result_t():
+		nthreads(0),
+		batches(0),
+		items(0),
+		bytes(0.0),
+		elapsed(0.0)
+	{}
+};
+
+void print_replay(const std::string &operator_name, const std::vector<replay_result_t> &results);
+
+/* Each thread replays every batch 'rounds' times. prepare() returns the private
+ * copy of a batch given to the operator and release() frees what the operator
+ * allocated in it. Only the operator call is timed. */
+template <typename T, typename Prepare, typename Op, typename Release>
+replay_result_t replay_operator(const std::vector<T> &batches, unsigned int nthreads, unsigned int rounds, Prepare prepare, Op op, Release release){
+	replay_result_t result;
+	result.nthreads = nthreads;
+
+	std::vector<std::vector<double>> service_time(nthreads);
+	std::vector<std::thread> threads;
+	std::atomic<unsigned int> ready(0);
+	std::atomic<bool> go(false);
+
+	for(unsigned int t = 0; t < nthreads; t++){
+		threads.push_back(std::thread([&, t](){
+			service_time[t].reserve(batches.size() * rounds);
+			ready++;
+			while(!go.load()); // all threads start together
+			for(unsigned int r = 0; r < rounds; r++){
+				for(unsigned int b = 0; b < batches.size(); b++){
+					T item = prepare(batches[b]);
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					op(item);
+					service_time[t].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+					release(item);
+				}
+			}
+		}));
+	}
+	while(ready.load() < nthreads);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	go = true;
+	for(unsigned int t = 0; t < nthreads; t++)
+		threads[t].join();
+	result.elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	for(unsigned int t = 0; t < nthreads; t++)
+		result.service_time.insert(result.service_time.end(), service_time[t].begin(), service_time[t].end());
+	result.batches = result.service_time.size();
+	for(unsigned int b = 0; b < batches.size(); b++)
+		result.items += batches[b].batch_size;
+	result.items *= (unsigned long)rounds * nthreads;
+	return result;
+}
+
+/* Thread counts of a replay: 1, 2, 4, ... up to nthreads */
+inline std::vector<unsigned int> replay_thread_counts(unsigned int nthreads){
+	std::vector<unsigned int> counts;
+	for(unsigned int n = 1; n < nthreads; n *= 2)
+		counts.push_back(n);
+	counts.push_back(nthreads < 1 ? 1 : nthreads);
+	return counts;
+}
+
 } //end of namespace spb
 
 
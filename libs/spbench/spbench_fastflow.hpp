@@ -0,0 +1,99 @@
+/**
+ * ************************************************************************
+ *  File  : spbench_fastflow.hpp
+ *
+ *  Title : SPBench run-time options of the FastFlow versions
+ *
+ *  Author: Adriano Marques Garcia <adriano1mg@gmail.com>
+ *
+ *  Date  : July 06, 2021
+ *
+ *  Copyright (C) 2021 Adriano M. Garcia
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License version 3 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, write to the Free Software Foundation,
+ *  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ ****************************************************************************
+ */
+
+#ifndef SPBENCH_FASTFLOW_H
+#define SPBENCH_FASTFLOW_H
+
+#include <ff/ff.hpp>
+#include <spbench.hpp>
+
+/* The FastFlow versions are built with -DBLOCKING_MODE -DFF_BOUNDED_BUFFER
+ * -DDEFAULT_BUFFER_CAPACITY=1 as defaults, and these functions apply the
+ * options given at run time (-R, --runtime and -q, --queue-capacity) to
+ * their skeletons before they run.
+ */
+
+namespace spb{
+
+/**
+ * Runtime options
+ *
+ * Blocking mode and thread mapping of a farm or pipeline. Call it for the
+ * outermost skeleton (ff_farm_options() already does it for farms). Without
+ * a mapping the threads are not pinned, as with -DNO_DEFAULT_MAPPING.
+ *
+ * @param skeleton farm or pipeline.
+ * @return nothing.
+ */
+template<typename skeleton_t>
+inline void ff_runtime_options(skeleton_t &skeleton){
+	runtime_options_t options = SPBench::getRuntimeOptions();
+	if(options.blocking >= 0)
+		skeleton.blocking_mode(options.blocking == 1);
+	if(options.mapping.empty()){
+		skeleton.no_mapping();
+	} else {
+		std::string mapping = options.mapping;
+		std::replace(mapping.begin(), mapping.end(), ':', ',');
+		ff::threadMapper::instance()->setMappingList(mapping.c_str());
+	}
+}
+
+/**
+ * Farm options
+ *
+ * Ordering, scheduling and queue capacity of a farm, then the runtime
+ * options. The farm must be built unordered (ff_Farm or ff_farm).
+ *
+ * @param farm farm of the benchmark.
+ * @param ordered true if the benchmark keeps the order of the items by default.
+ * @param ondemand true if the benchmark uses on-demand scheduling by default.
+ * @return nothing.
+ */
+inline void ff_farm_options(ff::ff_farm &farm, bool ordered, bool ondemand){
+	runtime_options_t options = SPBench::getRuntimeOptions();
+	if(SPBench::isOrdered(ordered))
+		farm.set_ordered();
+
+	int capacity = SPBench::getQueueCapacity();
+	if(capacity > 0){
+		farm.setInputQueueLength(capacity, true);
+		farm.setOutputQueueLength(capacity, true);
+	}
+
+	// on-demand scheduling bounds the worker queues to 'slots' items
+	int slots = (options.ondemand >= 0 ? options.ondemand : (ondemand ? 1 : 0));
+	if(slots > 0)
+		farm.set_scheduling_ondemand(slots);
+
+	ff_runtime_options(farm);
+}
+
+} // end of namespace spb
+
+#endif
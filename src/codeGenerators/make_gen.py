@@ -29,6 +29,7 @@
 import sys
 import os
 import json
+import io
 
 from src.utils.shell import *
 from src.utils.utils import *
@@ -147,6 +148,30 @@ def make_gen(stream_path, selected_benchmark):
 
     if(global_json_data["EXTRA_MACROS"]):
         macros += " " + global_json_data["EXTRA_MACROS"]
+
+    # instrumentation policy compiled into SPBench (see spb::instrument in spbench.hpp)
+    instrument_policies = {"full": "InstrumentFull", "end-to-end": "InstrumentEndToEndOnly", "sampled": "InstrumentSampled", "none": "InstrumentNone"}
+    if(global_json_data.get("INSTRUMENT")):
+        instrument = global_json_data["INSTRUMENT"]
+    else:
+        instrument = json_data.get("INSTRUMENT", "full")
+    if instrument.lower() not in instrument_policies:
+        print("   Error!\n-> Unknown INSTRUMENT policy: [" + instrument + "]\n")
+        print("-> Use one of: " + ", ".join(instrument_policies))
+        sys.exit()
+    macros += " -DSPB_INSTRUMENT=" + instrument_policies[instrument.lower()]
+
+    # per-operator allocation accounting (see spb::AllocScope in spbench.hpp)
+    if(global_json_data.get("ALLOC_ACCOUNTING")):
+        alloc_accounting = global_json_data["ALLOC_ACCOUNTING"]
+    else:
+        alloc_accounting = json_data.get("ALLOC_ACCOUNTING", "off")
+    if alloc_accounting.lower() not in ["on", "off"]:
+        print("   Error!\n-> Unknown ALLOC_ACCOUNTING value: [" + alloc_accounting + "]\n")
+        print("-> Use one of: on, off")
+        sys.exit()
+    if alloc_accounting.lower() == "on":
+        macros += " -DSPB_ALLOC_ACCOUNTING"
     
     pkgconfig = json_data["PKG-CONFIG"]
     global_pkgconfig = global_json_data["PKG-CONFIG"]
@@ -199,7 +224,8 @@ def make_gen(stream_path, selected_benchmark):
     ###########################################
     # Makefile writing
     ###########################################
-    Makefile = open(programm_path+'Makefile', 'w')
+    # written to disk only when it changes, since the objects depend on it
+    Makefile = io.StringIO()
 
     Makefile.write('SPB_HOME := ' + stream_path + '\n\n')
     
@@ -235,6 +261,11 @@ def make_gen(stream_path, selected_benchmark):
     Makefile.write('LDFLAGS := ' + ldflags + '\n')
     Makefile.write('MACROS := ' + macros + '\n\n')
 
+    # build variants (PGO, LTO, -march=native) set these from the command line,
+    # e.g. make VARIANT_FLAGS=-flto BIN_SUFFIX=_lto (see compile_option.py)
+    Makefile.write('VARIANT_FLAGS :=\n')
+    Makefile.write('BIN_SUFFIX :=\n\n')
+
     if includes_cmd:
         Makefile.write('INCLUDES := ')
         for include in includes_cmd:
@@ -271,36 +302,53 @@ def make_gen(stream_path, selected_benchmark):
     Makefile.write('\t@mkdir -p $(BIN_DIR)\n')
 
     if app_id == 'ferret':
-        Makefile.write('\t@$(CXX) $(CFLAGS) $(INCLUDES) $^ -o $(BIN_DIR)/$@ $(LIBDIR)/libcass.a $(LIBDIR)/libcassimage.a $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+        Makefile.write('\t@$(CXX) $(CXX_FLAGS) $(VARIANT_FLAGS) $(INCLUDES) $^ -o $(BIN_DIR)/$@$(BIN_SUFFIX) $(LIBDIR)/libcass.a $(LIBDIR)/libcassimage.a $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
     else:    
-        Makefile.write('\t@$(CXX) $(CFLAGS) $(INCLUDES) $^ -o $(BIN_DIR)/$@ $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+        Makefile.write('\t@$(CXX) $(CXX_FLAGS) $(VARIANT_FLAGS) $(INCLUDES) $^ -o $(BIN_DIR)/$@$(BIN_SUFFIX) $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+
+    # SPBench and the application utilities are compiled with the MACROS of each
+    # benchmark (e.g. SPB_INSTRUMENT), so every benchmark keeps its own objects,
+    # and all objects depend on this makefile to be rebuilt when the flags change
+    Makefile.write('UTILS_OBJ := $(OBJ_PATH)/$(APP_ID)_utils' + ns + '.o\n')
+    Makefile.write('SPB_OBJ := $(OBJ_PATH)/spbench.o\n\n')
 
-    Makefile.write('$(APP_ID).a: $(BENCHMARK).o $(SPB_LIB_DIR)/spbench.o $(SRC_DIR)/$(APP_ID)_utils' + ns + '.o $(OBJ)\n')
+    Makefile.write('$(APP_ID).a: $(BENCHMARK).o $(SPB_OBJ) $(UTILS_OBJ) $(OBJ)\n')
     Makefile.write('\t@echo "   ar  $^ ==> $@"\n')
-    Makefile.write('\t@ar -crs $@ $^\n\n')
+    Makefile.write('\t@$(AR) -crs $@ $^\n\n')
 
-    Makefile.write('$(SPB_LIB_DIR)/spbench.o: $(SPB_LIB_DIR)/spbench.cpp\n')
+    Makefile.write('$(SPB_OBJ): $(SPB_LIB_DIR)/spbench.cpp Makefile\n')
     Makefile.write('\t@echo "   $(CXX) $< ==> $@"\n')
-    Makefile.write('\t@$(CXX) $(CFLAGS) $(INCLUDES) -c $^ -o $@ $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+    Makefile.write('\t@mkdir -p $(OBJ_PATH)\n')
+    Makefile.write('\t@$(CXX) $(CXX_FLAGS) $(VARIANT_FLAGS) $(INCLUDES) -c $< -o $@ $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
 
-    Makefile.write('$(SRC_DIR)/$(APP_ID)_utils' + ns + '.o: $(SRC_DIR)/$(APP_ID)_utils' + ns + '.cpp\n')
+    Makefile.write('$(UTILS_OBJ): $(SRC_DIR)/$(APP_ID)_utils' + ns + '.cpp Makefile\n')
     Makefile.write('\t@echo "   $(CXX) $< ==> $@"\n')
-    Makefile.write('\t@$(CXX) $(CFLAGS) $(INCLUDES) -c $^ -o $@ $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+    Makefile.write('\t@mkdir -p $(OBJ_PATH)\n')
+    Makefile.write('\t@$(CXX) $(CXX_FLAGS) $(VARIANT_FLAGS) $(INCLUDES) -c $< -o $@ $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
 
-    Makefile.write('$(BENCHMARK).o: $(BENCHMARK).cpp\n')
+    Makefile.write('$(BENCHMARK).o: $(BENCHMARK).cpp Makefile\n')
     Makefile.write('\t@echo "   $(PPI_CXX) $< ==> $@"\n')
-    Makefile.write('\t@$(PPI_CXX) $(PPI_CXX_FLAGS) $(INCLUDES) -c $(PRE_SRC_CMD) $^ $(POS_SRC_CMD) $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+    Makefile.write('\t@$(PPI_CXX) $(PPI_CXX_FLAGS) $(VARIANT_FLAGS) $(INCLUDES) -c $(PRE_SRC_CMD) $< $(POS_SRC_CMD) $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
 
-    Makefile.write('$(OBJ_PATH)/%.o : $(SRC_PATH)/%.cpp\n')
+    Makefile.write('$(OBJ_PATH)/%.o : $(SRC_PATH)/%.cpp Makefile\n')
     Makefile.write('\t@echo "   $(PPI_CXX) $< ==> $@"\n')
     Makefile.write('\t@mkdir -p $(OBJ_PATH)\n')
-    Makefile.write('\t@$(PPI_CXX) $(PPI_CXX_FLAGS) $(INCLUDES) -c $(PRE_SRC_CMD) $^ $(POS_SRC_CMD) -o $@ $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+    Makefile.write('\t@$(PPI_CXX) $(PPI_CXX_FLAGS) $(VARIANT_FLAGS) $(INCLUDES) -c $(PRE_SRC_CMD) $< $(POS_SRC_CMD) -o $@ $(PKG) $(LIBS) $(LDFLAGS) $(MACROS)\n\n')
+
+    Makefile.write('.PHONY: clean clean_obj\n')
+    Makefile.write('clean: clean_obj\n')
+    Makefile.write('\trm -f $(BIN_DIR)/$(BENCHMARK)$(BIN_SUFFIX)\n\n')
 
-    Makefile.write('.PHONY: clean\n')
-    Makefile.write('clean:\n')
+    # removes only the objects, keeping the binaries of the other build variants
+    Makefile.write('clean_obj:\n')
     if app_id == 'ferret':
         Makefile.write('\trm -f $(SRC_DIR)/parsec/obj/*\n')
-    Makefile.write('\trm -f $(OBJ) $(BENCHMARK).o $(SRC_DIR)/$(APP_ID)_utils' + ns + '.o $(APP_ID).a $(SPB_LIB_DIR)/spbench.o $(BIN_DIR)/$(BENCHMARK)\n')
+    Makefile.write('\trm -f $(OBJ) $(BENCHMARK).o $(UTILS_OBJ) $(APP_ID).a $(SPB_OBJ)\n')
     Makefile.write('\trm -rf $(OBJ_PATH)\n\n')
 
+    makefile_path = programm_path + 'Makefile'
+    content = Makefile.getvalue()
     Makefile.close()
+    if not os.path.exists(makefile_path) or open(makefile_path).read() != content:
+        with open(makefile_path, 'w') as f:
+            f.write(content)
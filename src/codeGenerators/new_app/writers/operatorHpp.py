@@ -61,7 +61,7 @@ def writeOperatorHpp(file_path, operator_id, app_id):
     op_hpp_file.write("\n")
     op_hpp_file.write("\tMetrics metrics;\n")
     op_hpp_file.write("\tvolatile unsigned long latency_op;\n")
-    op_hpp_file.write("\tif(metrics.latency_is_enabled()){\n")
+    op_hpp_file.write("\tif(metrics.operator_latency_is_enabled(item)){\n")
     op_hpp_file.write("\t\tlatency_op = current_time_usecs();\n")
     op_hpp_file.write("\t}\n")
     op_hpp_file.write("\tunsigned int num_item = 0;\n")
@@ -73,7 +73,7 @@ def writeOperatorHpp(file_path, operator_id, app_id):
     op_hpp_file.write("\t\tnum_item++;\n")
     op_hpp_file.write("\t}\n")
     op_hpp_file.write("\t\n")
-    op_hpp_file.write("\tif(metrics.latency_is_enabled()){\n")
+    op_hpp_file.write("\tif(metrics.operator_latency_is_enabled(item)){\n")
     op_hpp_file.write("\t\titem.latency_op.push_back(current_time_usecs() - latency_op);\n")
     op_hpp_file.write("\t}\n")
     op_hpp_file.write("}\n")
@@ -37,6 +37,40 @@ from src.codeGenerators.make_gen import *
 from sys import version_info 
 python_3 = version_info[0]
 
+# Profile-guided optimization: builds an instrumented binary, runs it with the
+# training input and returns the make command that rebuilds it using the profile
+def buildVariantPGO(spbench_path, args, benchmark, make_cmd, variant_flags, variant_suffix):
+    app_id = benchmark["app_id"]
+    ppi_id = benchmark["ppi_id"]
+    bench_id = benchmark["bench_id"]
+    programm_path = spbench_path + "/benchmarks/" + app_id + "/" + ppi_id + "/" + bench_id + "/"
+
+    profile_dir = programm_path + "pgo_profile"
+    os.system("rm -rf " + profile_dir)
+
+    print("\n -> PGO: building the instrumented binary...")
+    generate_flags = variant_flags + " -fprofile-generate -fprofile-dir=" + profile_dir
+    if(os.WEXITSTATUS(os.system(make_cmd + " VARIANT_FLAGS=\"" + generate_flags + "\" BIN_SUFFIX=" + variant_suffix))):
+        print("\n Compilation of the instrumented binary failed!\n")
+        sys.exit()
+
+    # training run
+    inputs_ID_list = []
+    for sub_list in args.pgo_input:
+        for input_id in sub_list:
+            inputs_ID_list.append(input_id)
+    cmd_line = spbench_path + "/bin/" + app_id + "/" + ppi_id + "/" + bench_id + variant_suffix
+    cmd_line += getInputArguments(spbench_path, app_id, benchmark["nsources"], inputs_ID_list) + " " + args.pgo_args
+    print("\n -> PGO: training run >> " + cmd_line)
+    if(os.WEXITSTATUS(os.system(cmd_line + " > /dev/null"))):
+        print("\n Training run failed! Check the input and the -pgo-args.\n")
+        sys.exit()
+
+    os.system("make -s -C " + programm_path + " clean_obj")
+    print("\n -> PGO: rebuilding with the profile...")
+    use_flags = variant_flags + " -fprofile-use -fprofile-correction -Wno-missing-profile -fprofile-dir=" + profile_dir
+    return make_cmd + " VARIANT_FLAGS=\"" + use_flags + "\" BIN_SUFFIX=" + variant_suffix
+
 def compile_func(spbench_path, args):
 
     # get the selected benchmarks
@@ -45,6 +79,18 @@ def compile_func(spbench_path, args):
     # succeed flag for later verifications
     compilation_succeed = False
 
+    # Build variants are separate binaries named <benchmark>_<variant>, e.g. bzip2_tbb_farm_pgo_lto
+    variant_flags = ""
+    variant_suffix = ""
+    if args.pgo_input:
+        variant_suffix += "_pgo"
+    if args.lto:
+        variant_flags += " -flto"
+        variant_suffix += "_lto"
+    if args.march_native:
+        variant_flags += " -march=native"
+        variant_suffix += "_native"
+
     for benchmark in selected_benchmarks:
         app_id = benchmark["app_id"]
         ppi_id = benchmark["ppi_id"]
@@ -62,8 +108,8 @@ def compile_func(spbench_path, args):
         #path where make will run
         programm_path = spbench_path + "/benchmarks/" + app_id + "/" + ppi_id + "/" + bench_id + "/" 
 
-        # Build the makefile if it does not exist yet
-        if not fileExists(programm_path + 'Makefile'):
+        # Build the makefile if it does not exist yet (variants require the current makefile format)
+        if variant_suffix or not fileExists(programm_path + 'Makefile'):
             make_gen(spbench_path, benchmark)
 
         # check if exists the make directory
@@ -72,7 +118,7 @@ def compile_func(spbench_path, args):
             sys.exit()
         
         if args.clean:
-            runShellCmd("make -C " + programm_path + " clean")
+            runShellCmd("make -C " + programm_path + " clean" + (" BIN_SUFFIX=" + variant_suffix if variant_suffix else ""))
 
         #else:
         #    if app_id == 'ferret':
@@ -116,6 +162,20 @@ def compile_func(spbench_path, args):
         else:
             make_cmd = ("make -C " + programm_path + " -j$(nproc)")
         
+        if variant_suffix:
+            # objects built with other flags cannot be reused
+            os.system("make -s -C " + programm_path + " clean_obj")
+
+            # archives of LTO objects need the linker plugin, also in both PGO builds
+            if args.lto and programmExists("gcc-ar", ""):
+                make_cmd += " AR=gcc-ar"
+
+            if args.pgo_input:
+                variant_make_cmd = buildVariantPGO(spbench_path, args, benchmark, make_cmd, variant_flags, variant_suffix)
+            else:
+                variant_make_cmd = make_cmd + " VARIANT_FLAGS=\"" + variant_flags + "\" BIN_SUFFIX=" + variant_suffix
+            make_cmd = variant_make_cmd
+
         # compile the programm
         if(os.WEXITSTATUS(os.system(make_cmd))):
             print("\n ---------------------------------------")
@@ -134,6 +194,12 @@ def compile_func(spbench_path, args):
             #    print(" Compilation succeed!")
             #    print(" Version: " + bench_id)
             print(" ---------------------------------------\n")
+        elif variant_suffix:
+            print("\n -> Build variant: " + bin_path + "/" + bench_id + variant_suffix)
+
+        if variant_suffix:
+            # do not let the default build reuse these objects
+            os.system("make -s -C " + programm_path + " clean_obj")
             
         compilation_succeed = True
 
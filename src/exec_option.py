@@ -34,10 +34,101 @@ from src.errors import *
 from src.utils.shell import *
 from src.utils.dict import *
 from src.utils.utils import *
+from src.utils.scalability import *
 
 from sys import version_info 
 python_3 = version_info[0]
 
+def toFloatOrNone(value):
+    if isPositiveFloat(str(value)):
+        return float(value)
+    return None
+
+# Largest relative half-width of the 95% confidence interval among the
+# measured metrics (latency and throughput, or exec. time if neither
+# is measured), after discarding outliers
+def relativeCIWidth(latencies, throughputs, exec_times):
+    metrics = [data for data in [latencies, throughputs] if data]
+    if not metrics:
+        metrics = [data for data in [exec_times] if data]
+    if not metrics:
+        # nothing to refine
+        return 0
+    width = 0
+    for data in metrics:
+        kept = discardOutliers(data)
+        mean = sum(kept)/len(kept)
+        if mean <= 0:
+            continue
+        width = max(width, confidenceInterval95(kept)/mean)
+    return width
+
+def discardedNote(all_values, kept_values):
+    discarded = len(all_values) - len(kept_values)
+    if discarded:
+        return "(" + str(discarded) + " outlier(s) discarded)"
+    return ""
+
+# Fit USL and Amdahl's law to the (nthreads, throughput) points, print
+# them and keep the coefficients in the scalability log
+def scalabilitySummary(log_dir, bench_id, points):
+    usl = fitModel(points)
+    amdahl = fitModel(points, True)
+    if usl is None:
+        if points:
+            print("\n Scalability model not computed: it requires throughput results (-throughput) for at least 3 different numbers of threads.")
+        return
+
+    peak = peakConcurrency(usl)
+    max_nthreads = max(n for n, thr in points)
+
+    print("\n************* SCALABILITY MODEL *************\n")
+    print("             Benchmark:", bench_id)
+    print("\n  Universal Scalability Law")
+    print("    Single thread (X1):", round(usl['lambda'], 3))
+    print("    Contention (sigma):", round(usl['sigma'], 6))
+    print("     Coherency (kappa):", round(usl['kappa'], 6))
+    print("    RMS relative error:", str(round(usl['rms']*100, 2)) + "%")
+    if peak is None:
+        print("      Peak concurrency: none (no coherency delay)")
+    else:
+        print("      Peak concurrency:", round(peak, 1), "threads (predicted throughput:", str(round(uslThroughput(usl, peak), 3)) + ")")
+    print("\n  Amdahl's law")
+    print("       Serial fraction:", round(amdahl['sigma'], 6))
+    print("    RMS relative error:", str(round(amdahl['rms']*100, 2)) + "%")
+
+    print("\n  Predicted throughput (USL | Amdahl):")
+    for n in [max_nthreads*2, max_nthreads*4]:
+        print("     " + str(n).rjust(4) + " threads:", round(uslThroughput(usl, n), 3), "|", round(uslThroughput(amdahl, n), 3))
+
+    deviating = deviatingPoints(usl, points)
+    if deviating:
+        print("\n  Measured points deviating from the USL:")
+        for n, thr, predicted, deviation in deviating:
+            print("     " + str(int(n)).rjust(4) + " threads: measured", round(thr, 3), "predicted", round(predicted, 3), "(" + str(round(deviation*100, 1)) + "%)")
+    print("\n********************************************")
+
+    log_header = ("Time;Benchmark;N threads;X1;Sigma;Kappa;Peak concurrency;USL error;Amdahl serial fraction;Amdahl error;Deviating points\n")
+    log_file = log_dir + "/scalability_log.csv"
+    if(not fileExists(log_file)):
+        with open(log_file, 'w') as scalability_log_file:
+            scalability_log_file.write(log_header)
+
+    log_line = []
+    log_line.append(datetime.datetime.now().strftime("%d/%m/%y %H:%M:%S"))
+    log_line.append(bench_id)
+    log_line.append(','.join(str(n) for n, thr in points))
+    log_line.append(str(usl['lambda']))
+    log_line.append(str(usl['sigma']))
+    log_line.append(str(usl['kappa']))
+    log_line.append('' if peak is None else str(peak))
+    log_line.append(str(usl['rms']))
+    log_line.append(str(amdahl['sigma']))
+    log_line.append(str(amdahl['rms']))
+    log_line.append(','.join(str(int(n)) for n, thr, predicted, deviation in deviating))
+    with open(log_file, 'a') as scalability_log_file:
+        scalability_log_file.write(';'.join(log_line) + "\n")
+
 def execute_func(spbench_path, args):
     
     
@@ -62,6 +153,10 @@ def execute_func(spbench_path, args):
         bench_id = benchmark["bench_id"]
         nsources = benchmark["nsources"]
 
+        # build variants (compile -pgo/-lto/-march-native) are separate binaries
+        if args.build_variant:
+            bench_id = bench_id + "_" + args.build_variant.strip("_")
+
         if not fileExists(spbench_path + "/bin/" + app_id + "/" + ppi_id + "/" + bench_id):
             print("\n  Error!! Binary file not found for "+ bench_id)
             print("  Make sure you compiled the benchmark before run it.")
@@ -199,6 +294,23 @@ def execute_func(spbench_path, args):
         if args.repetitions:
             if not args.repetitions.isdigit():
                 raise ArgumentTypeError("Argument error! The number of repetitions must be an integer higher than or equal to one: " + args.repetitions)
+        repetitions = int(args.repetitions)
+
+        # Check for errors in adaptive repetitions
+        adaptive = False
+        if args.adaptive_ci:
+            if not isPositiveFloat(args.adaptive_ci) or float(args.adaptive_ci) <= 0:
+                raise ArgumentTypeError("Argument error! The target relative width of the confidence interval must be a number higher than zero: " + args.adaptive_ci)
+            if not args.min_repetitions.isdigit() or int(args.min_repetitions) < 2:
+                raise ArgumentTypeError("Argument error! The minimum number of repetitions must be an integer higher than or equal to two: " + args.min_repetitions)
+            if not args.max_repetitions.isdigit() or int(args.max_repetitions) < int(args.min_repetitions):
+                raise ArgumentTypeError("Argument error! The maximum number of repetitions must be an integer higher than or equal to the minimum: " + args.max_repetitions)
+            if args.debug:
+                raise ArgumentTypeError("Argument error! Adaptive repetitions read the results from the benchmark output and cannot be used with -debug.")
+            adaptive = True
+            target_ci = float(args.adaptive_ci)
+            min_repetitions = int(args.min_repetitions)
+            repetitions = int(args.max_repetitions)
 
         # Check for errors in batch size
         if args.batch_size:
@@ -266,6 +378,9 @@ def execute_func(spbench_path, args):
                 for sub_list in args.user_args:
                     for arg in sub_list:
                         user_args += " -u" + arg
+
+            if args.runtime_options:
+                user_args += " --runtime=" + args.runtime_options
             
             other_args = ' --force --keep'
 
@@ -298,6 +413,9 @@ def execute_func(spbench_path, args):
                 for sub_list in args.user_args:
                     for arg in sub_list:
                         user_args += " -u \"" + arg + "\""
+
+            if args.runtime_options:
+                user_args += " -R " + args.runtime_options
             
         exec_arguments = " "
         if args.exec_arguments:
@@ -404,7 +522,7 @@ def execute_func(spbench_path, args):
             except OSError as error: 
                 print(error)
 
-        if is_range and (int(args.repetitions) > 1):
+        if is_range and (repetitions > 1):
 
             # if range start is zero, change it to 1 in the file name
             real_range_start = str(range_start)
@@ -417,6 +535,8 @@ def execute_func(spbench_path, args):
                 range_log_file = log_dir + "/" + bench_id + "_" + real_range_start + ":" + str(range_end) + ".dat"
                 
             nth_log_header = ("Thread Average_latency Std_dev_latency Average_throughput Std_dev_throughput Average_exec_time Std_dev_exec_time\n")
+            if adaptive:
+                nth_log_header = ("Thread Average_latency Std_dev_latency CI95_latency Average_throughput Std_dev_throughput CI95_throughput Average_exec_time Std_dev_exec_time CI95_exec_time Repetitions\n")
 
             #if(not fileExists(range_log_file)):
             with open(range_log_file, 'w') as nth_log_file:
@@ -430,6 +550,18 @@ def execute_func(spbench_path, args):
             with open(log_file, 'w') as general_log_file:
                 general_log_file.write(log_header)
 
+        # per-repetition raw values of the adaptive mode
+        if adaptive:
+            rep_log_header = ("Time;Benchmark;N threads;Repetition;Latency;Throughput;Exec. time;Discarded\n")
+            rep_log_file = log_dir + "/" + bench_id + "_repetitions.csv"
+
+            if(not fileExists(rep_log_file)):
+                with open(rep_log_file, 'w') as repetitions_log_file:
+                    repetitions_log_file.write(rep_log_header)
+
+        # average throughput of each number of threads
+        scaling_points = []
+
         # run the benchmark for n threads
         for nthread in nthreads:
 
@@ -450,11 +582,14 @@ def execute_func(spbench_path, args):
             latencies = []
             exec_times = []
             throughputs = []
+            raw_values = []
 
             # run the benchmark n times
-            for n in range(0, int(args.repetitions)):
+            for n in range(0, repetitions):
 
-                if(int(args.repetitions) > 1):
+                if adaptive:
+                    print("\n ~~~~~~> Execution " + str(n+1) + " (adaptive, at most " + str(repetitions) + ")")
+                elif(repetitions > 1):
                     print("\n ~~~~~~> Execution " + str(n+1) + " from " + args.repetitions)
 
                 if args.debug:
@@ -503,6 +638,8 @@ def execute_func(spbench_path, args):
                             if(isPositiveFloat(throughput)):
                                 throughputs.append(float(throughput))
 
+                    raw_values.append([n+1, toFloatOrNone(end_latency), toFloatOrNone(throughput), toFloatOrNone(exec_time)])
+
                     if args.quiet:
                         if args.exec_arguments and "-l" in args.exec_arguments:
                             print(" Average latency (ms) = " + str((round(float(end_latency), 3))))
@@ -610,43 +747,97 @@ def execute_func(spbench_path, args):
                     print("")
                 # end of the correcteness checking
 
+                # adaptive mode: stop once the metrics are precise enough
+                if adaptive and (n+1) >= min_repetitions:
+                    ci_width = relativeCIWidth(latencies, throughputs, exec_times)
+                    if ci_width <= target_ci:
+                        print(" Confidence interval within " + str(round(ci_width*100, 2)) + "% of the mean after " + str(n+1) + " repetitions.")
+                        break
+                    if not args.quiet:
+                        print(" Confidence interval still at " + str(round(ci_width*100, 2)) + "% of the mean (target: " + str(round(target_ci*100, 2)) + "%).")
+
             if not args.debug:
                 ##
                 # Compute and print the metrics sumary
                 ##
-                if(int(args.repetitions) > 1):
+                if(repetitions > 1):
+
+                    all_latencies = latencies
+                    all_throughputs = throughputs
+                    all_exec_times = exec_times
+                    if adaptive:
+                        # outliers do not enter the summary (see outlierBounds)
+                        latencies = discardOutliers(latencies)
+                        throughputs = discardOutliers(throughputs)
+                        exec_times = discardOutliers(exec_times)
+
+                    latency_ci = 0
+                    thr_ci = 0
+                    exec_time_ci = 0
 
                     if(latencies):
                         latency_average = sum(latencies)/len(latencies)
                         latency_error = stdev(latencies)
+                        latency_ci = confidenceInterval95(latencies)
 
                     if(exec_times):
                         exec_time_average = sum(exec_times)/len(exec_times)
                         exec_time_error = stdev(exec_times)
+                        exec_time_ci = confidenceInterval95(exec_times)
 
                     if(throughputs):
                         thr_average = sum(throughputs)/len(throughputs)
                         thr_error = stdev(throughputs)
+                        thr_ci = confidenceInterval95(throughputs)
 
                     if (latencies or exec_times or throughputs) and not args.quiet:
                         print("*************** RESULTS SUMARY ***************\n")
                         print("             Benchmark:", bench_id)
-                        print("           Repetitions:", args.repetitions)
+                        if adaptive:
+                            print("           Repetitions:", len(raw_values), "(adaptive, target CI +/-", str(round(target_ci*100, 2)) + "%)")
+                        else:
+                            print("           Repetitions:", args.repetitions)
                         if(latencies):
                             print("\n       Average latency:", latency_average)
                             print("     Latency std. dev.:", latency_error)
+                            if adaptive:
+                                print("    Latency 95% CI +/-:", latency_ci, discardedNote(all_latencies, latencies))
                         if(throughputs):
                             print("\n    Average throughput:", thr_average)
                             print("  Throughput std. dev.:", thr_error)
+                            if adaptive:
+                                print(" Throughput 95% CI +/-:", thr_ci, discardedNote(all_throughputs, throughputs))
                         if(exec_times):
                             print("\n    Average exec. time:", exec_time_average)
                             print("  Exec. time std. dev.:", exec_time_error)
+                            if adaptive:
+                                print(" Exec. time 95% CI +/-:", exec_time_ci, discardedNote(all_exec_times, exec_times))
 
                         if nsources:
                             print("\n CAUTION: This is a multi-source benchmark.")
                             print("          This summary includes all different")
                             print("          sources and may not be accurate.")
                         print("\n********************************************")
+
+                    ##
+                    # Write the raw values of each repetition, marking the discarded ones
+                    ##
+                    if adaptive:
+                        print_time = datetime.datetime.now().strftime("%d/%m/%y %H:%M:%S")
+                        bounds = [outlierBounds(all_latencies), outlierBounds(all_throughputs), outlierBounds(all_exec_times)]
+                        metric_names = ["latency", "throughput", "exec_time"]
+                        with open(rep_log_file, 'a') as repetitions_log_file:
+                            for values in raw_values:
+                                discarded = []
+                                for i in range(0, 3):
+                                    value = values[i+1]
+                                    if value is not None and not (bounds[i][0] <= value <= bounds[i][1]):
+                                        discarded.append(metric_names[i])
+                                log_line = [print_time, bench_id, str(nthread), str(values[0])]
+                                for value in values[1:]:
+                                    log_line.append('' if value is None else str(value))
+                                log_line.append(','.join(discarded) if discarded else '-')
+                                repetitions_log_file.write(';'.join(log_line) + "\n")
                 
                     ##
                     # Generate a specific performance log if repetitions and nthreads range are enabled
@@ -661,14 +852,37 @@ def execute_func(spbench_path, args):
                                 nth_log_file.write(nth_log_header)
 
                             nth_log_file.seek(0, 2)
-                            nth_log_file.write(
-                                str(nthread) + " " + 
-                                str(latency_average) + " " + 
-                                str(latency_error) + " " + 
-                                str(thr_average) + " " + 
-                                str(thr_error) + " " + 
-                                str(exec_time_average) + " " + 
-                                str(exec_time_error) + "\n")
+                            if adaptive:
+                                nth_log_file.write(
+                                    str(nthread) + " " + 
+                                    str(latency_average) + " " + 
+                                    str(latency_error) + " " + 
+                                    str(latency_ci) + " " + 
+                                    str(thr_average) + " " + 
+                                    str(thr_error) + " " + 
+                                    str(thr_ci) + " " + 
+                                    str(exec_time_average) + " " + 
+                                    str(exec_time_error) + " " + 
+                                    str(exec_time_ci) + " " + 
+                                    str(len(raw_values)) + "\n")
+                            else:
+                                nth_log_file.write(
+                                    str(nthread) + " " + 
+                                    str(latency_average) + " " + 
+                                    str(latency_error) + " " + 
+                                    str(thr_average) + " " + 
+                                    str(thr_error) + " " + 
+                                    str(exec_time_average) + " " + 
+                                    str(exec_time_error) + "\n")
                             nth_log_file.truncate()
 
+                if(throughputs):
+                    scaling_points.append((int(nthread), sum(throughputs)/len(throughputs)))
+
+        ##
+        # Fit the scalability models to the throughput of the nthreads range
+        ##
+        if is_range and not args.debug:
+            scalabilitySummary(log_dir, bench_id, scaling_points)
+
     sys.exit()
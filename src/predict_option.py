@@ -0,0 +1,173 @@
+##
+ ##############################################################################
+ #  File  : predict_option.py
+ #
+ #  Title : SPBench-CLI Performance Prediction Option
+ #
+ #  Author: Adriano Marques Garcia <adriano1mg@gmail.com>
+ #
+ #  Date  : July 06, 2021
+ #
+ #  Copyright (C) 2021 Adriano M. Garcia
+ #
+ #  This program is free software: you can redistribute it and/or modify
+ #  it under the terms of the GNU General Public License as published by
+ #  the Free Software Foundation, either version 3 of the License, or
+ #  (at your option) any later version.
+ #
+ #  This program is distributed in the hope that it will be useful,
+ #  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ #  GNU General Public License for more details.
+ #
+ #  You should have received a copy of the GNU General Public License
+ #  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ #
+ ##############################################################################
+##
+
+import sys
+import os
+import datetime
+
+from src.errors import *
+from src.utils.shell import *
+from src.utils.dict import *
+from src.utils.utils import *
+from src.utils.queueing import *
+from src.tune_option import parseValues, configArguments, parseResults
+
+def relativeDifference(predicted, measured):
+    return (predicted - measured) / measured if measured else 0.0
+
+def predict_func(spbench_path, args):
+
+    if args.benchmark_id == 'all':
+        print("\n Error!! You cannot use all benchmarks at once.\n Try again using a single benchmark ID.\n")
+        sys.exit()
+
+    # the service times come from the latency log of the profiled benchmark
+    log_dir = spbench_path + "/log"
+    latency_log = args.latency_log
+    if not latency_log:
+        latency_log = log_dir + "/" + args.benchmark_id + "_latency.dat"
+    if not fileExists(latency_log):
+        print("\n  Error!! Latency log not found: " + latency_log)
+        print("  Run the benchmark with -latency-monitor first, e.g.:")
+        print("    ./spbench exec -bench " + args.benchmark_id + " -input <input_id> -latency-monitor\n")
+        sys.exit()
+
+    operators, samples = readLatencyLog(latency_log)
+    if len(operators) < 2 or not samples:
+        raise ArgumentTypeError("Error! The latency log " + latency_log + " has no per-operator latencies (the benchmark must run with -latency-monitor and per-operator latency sampling).")
+
+    topology_list = [topology for topology in args.topologies.replace(" ", "").split(',') if topology]
+    for topology in topology_list:
+        if topology not in topologies:
+            raise ArgumentTypeError("Argument error! Unknown topology: " + topology + "\n  Available: " + ', '.join(topologies))
+    nthreads_list = parseValues('nthreads', args.nthreads)
+    if not args.batch_size.isdigit() or int(args.batch_size) < 1:
+        raise ArgumentTypeError("Argument error! The batch size must be an integer higher than or equal to one: " + args.batch_size)
+    if args.queue and (not args.queue.isdigit() or int(args.queue) < 1):
+        raise ArgumentTypeError("Argument error! The queue capacity must be an integer higher than or equal to one: " + args.queue)
+    if args.batches and (not args.batches.isdigit() or int(args.batches) < 1):
+        raise ArgumentTypeError("Argument error! The number of simulated batches must be an integer higher than or equal to one: " + args.batches)
+    batch_size = int(args.batch_size)
+    batches = int(args.batches) if args.batches else None
+
+    print("\n Service times: " + latency_log + " (" + str(len(samples)) + " batches)")
+    print(" Operators: " + ', '.join(operator.strip() for operator in operators))
+    for c in range(0, len(operators)):
+        column = [row[c] for row in samples]
+        print("   " + operators[c].strip().ljust(14) + " mean = " + str(round(sum(column)/len(column), 3)) + " ms, p99 = " + str(round(percentile(column, 99), 3)) + " ms")
+
+    ##
+    # Predict every topology and number of threads
+    ##
+    predictions = {}
+    print("\n*************** PREDICTION ***************\n")
+    print("  Topology    Threads   Items-per-second   Bound   Latency (ms)   p99 (ms)   Bottleneck (util.)")
+    for topology in topology_list:
+        for nthreads in (['1'] if topology in ['sequential', 'pipeline'] else nthreads_list):
+            in_flight = int(args.queue) if args.queue else int(nthreads) * 10
+            result = simulate(samples, operators, topology, int(nthreads), in_flight, batches, args.seed)
+            bound, bottleneck = throughputBound(samples, operators, topology, int(nthreads))
+            result['throughput'] *= batch_size
+            result['bound'] = bound * batch_size
+            result['bottleneck'] = bottleneck
+            utilization = dict(result['utilization'])[bottleneck]
+            predictions[(topology, nthreads)] = result
+            print("  " + topology.ljust(10) + nthreads.rjust(9) + str(round(result['throughput'], 3)).rjust(19) + str(round(result['bound'], 1)).rjust(8) + str(round(result['latency'], 3)).rjust(15) + str(round(result['p99_latency'], 3)).rjust(11) + "   " + bottleneck + " (" + str(round(utilization*100, 1)) + "%)")
+
+    best = max(predictions, key=lambda key: predictions[key]['throughput'])
+    print("\n  Highest throughput: " + best[0] + " with " + best[1] + " thread(s)")
+    print("\n******************************************")
+
+    ##
+    # Validate the predictions against real runs of compiled benchmarks
+    ##
+    measurements = {}
+    if args.validate:
+        if not args.input_id:
+            raise ArgumentTypeError("Argument error! Validating the predictions requires an input (-input).")
+        inputs_ID_list = [input_id for sub_list in args.input_id for input_id in sub_list]
+        executor = args.executor + " " if args.executor else ''
+
+        print("\n*************** VALIDATION ***************\n")
+        print("  Benchmark                 Threads   Items-per-second (pred. / meas.)   p99 latency (pred. / meas.)")
+        for bench_id in [bench for sub_list in args.validate for bench in sub_list]:
+            selected_benchmark = registryDicToList(filterBenchRegByBench(getBenchRegistry(spbench_path), bench_id))
+            if not selected_benchmark:
+                print("  " + bench_id + ": benchmark not found, skipped")
+                continue
+            app_id = selected_benchmark[0]["app_id"]
+            ppi_id = selected_benchmark[0]["ppi_id"]
+            nsources = selected_benchmark[0]["nsources"]
+            topology = topologyFromName(bench_id)
+            bench_binary = spbench_path + "/bin/" + app_id + "/" + ppi_id + "/" + bench_id
+            if topology is None or not fileExists(bench_binary):
+                print("  " + bench_id + ": " + ("unknown topology" if topology is None else "binary not found (compile it first)") + ", skipped")
+                continue
+
+            exec_arguments = getInputArguments(spbench_path, app_id, nsources, inputs_ID_list) + " -l -T"
+            for nthreads in (['1'] if topology in ['sequential', 'pipeline'] else nthreads_list):
+                if (topology, nthreads) not in predictions:
+                    predicted = simulate(samples, operators, topology, int(nthreads), int(args.queue) if args.queue else int(nthreads) * 10, batches, args.seed)
+                    predicted['throughput'] *= batch_size
+                    predictions[(topology, nthreads)] = predicted
+                predicted = predictions[(topology, nthreads)]
+                config = {'nthreads': nthreads, 'batch_size': args.batch_size, 'batch_interval': '0', 'queue': args.queue if not nsources else ''}
+                measured = parseResults(runShellWithReturn(executor + bench_binary + exec_arguments + configArguments(app_id, config)))
+                if measured is None:
+                    print("  " + bench_id.ljust(24) + nthreads.rjust(9) + "   unsuccessful execution")
+                    continue
+                measurements[(bench_id, nthreads)] = (topology, measured)
+                print("  " + bench_id.ljust(24) + nthreads.rjust(9) + "   " + (str(round(predicted['throughput'], 2)) + " / " + str(round(measured[0], 2)) + " (" + str(round(relativeDifference(predicted['throughput'], measured[0])*100, 1)) + "%)").ljust(33) + "   " + str(round(predicted['p99_latency'], 2)) + " / " + str(round(measured[1], 2)) + " (" + str(round(relativeDifference(predicted['p99_latency'], measured[1])*100, 1)) + "%)")
+
+        if measurements:
+            errors = [abs(relativeDifference(predictions[(topology, key[1])]['throughput'], measured[0])) for key, (topology, measured) in measurements.items()]
+            print("\n  Mean absolute throughput error: " + str(round(sum(errors)/len(errors)*100, 1)) + "%")
+        print("\n******************************************")
+
+    ##
+    # Write the predictions (and measurements) to the prediction log
+    ##
+    if(not dirExists(log_dir)):
+        try:
+            os.mkdir(log_dir)
+        except OSError as error:
+            print(error)
+
+    log_file = log_dir + "/" + args.benchmark_id + "_predict.csv"
+    with open(log_file, 'w') as predict_log_file:
+        predict_log_file.write("Time;Latency log;Topology;N threads;Batch size;Throughput;Throughput bound;Latency;p99 latency;Bottleneck;Measured by;Measured throughput;Measured p99 latency\n")
+        print_time = datetime.datetime.now().strftime("%d/%m/%y %H:%M:%S")
+        for (topology, nthreads), result in sorted(predictions.items()):
+            measured_by = [(bench_id, measured) for (bench_id, n), (bench_topology, measured) in measurements.items() if n == nthreads and bench_topology == topology]
+            for bench_id, measured in (measured_by if measured_by else [('', ('', ''))]):
+                log_line = [print_time, latency_log, topology, nthreads, args.batch_size, str(result['throughput']), str(result.get('bound', '')), str(result['latency']), str(result['p99_latency']), result.get('bottleneck', ''), bench_id, str(measured[0]), str(measured[1])]
+                predict_log_file.write(';'.join(log_line) + "\n")
+
+    print("\n Results written to " + log_file + "\n")
+
+    sys.exit()
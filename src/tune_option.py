@@ -0,0 +1,270 @@
+##
+ ##############################################################################
+ #  File  : tune_option.py
+ #
+ #  Title : SPBench-CLI Benchmark Configuration Tuning Option
+ #
+ #  Author: Adriano Marques Garcia <adriano1mg@gmail.com>
+ #
+ #  Date  : July 06, 2021
+ #
+ #  Copyright (C) 2021 Adriano M. Garcia
+ #
+ #  This program is free software: you can redistribute it and/or modify
+ #  it under the terms of the GNU General Public License as published by
+ #  the Free Software Foundation, either version 3 of the License, or
+ #  (at your option) any later version.
+ #
+ #  This program is distributed in the hope that it will be useful,
+ #  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ #  GNU General Public License for more details.
+ #
+ #  You should have received a copy of the GNU General Public License
+ #  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ #
+ ##############################################################################
+##
+
+import sys
+import os
+import math
+import random
+import datetime
+import itertools
+
+from src.errors import *
+from src.utils.shell import *
+from src.utils.dict import *
+from src.utils.utils import *
+
+# parameters explored by the tuner, in the order they appear in the results
+tune_parameters = ['nthreads', 'batch_size', 'batch_interval', 'queue']
+
+# Parse a list of values given as a single value (4), a list (1,2,4) or
+# a range (start:end or start:step:end, integers only)
+def parseValues(arg_name, values, is_float=False):
+    values = values.replace(" ", "").lower()
+    if ':' in values:
+        range_arg = values.split(':')
+        if len(range_arg) < 2 or len(range_arg) > 3:
+            raise ArgumentTypeError("Argument error! Invalid format for " + arg_name + " range: " + values + "\n  Expected: start:end or start:step:end\n")
+        for value in range_arg:
+            if not value.isdigit():
+                raise ArgumentTypeError("Argument error! Values in the " + arg_name + " range must be integer numbers: " + values)
+        range_step = 1
+        if len(range_arg) == 3:
+            range_step = int(range_arg[1])
+        if range_step < 1 or int(range_arg[0]) > int(range_arg[-1]):
+            raise ArgumentTypeError("Argument error! Invalid " + arg_name + " range: " + values)
+        return [str(value) for value in range(int(range_arg[0]), int(range_arg[-1]) + 1, range_step)]
+
+    value_list = [value for value in values.split(',') if value]
+    for value in value_list:
+        if is_float:
+            if not isPositiveFloat(value):
+                raise ArgumentTypeError("Argument error! Values of " + arg_name + " must be numbers higher than or equal to zero: " + values)
+        elif not value.isdigit() or int(value) < 1:
+            raise ArgumentTypeError("Argument error! Values of " + arg_name + " must be integer numbers higher than or equal to one: " + values)
+    return value_list
+
+# Command line arguments of a configuration. Bzip2 takes the values attached to the flags
+def configArguments(app_id, config):
+    sep = '' if app_id == 'bzip2' else ' '
+    queue_flag = ' -S' if app_id == 'bzip2' else ' -q'
+    arguments = " -t" + sep + config['nthreads'] + " -b" + sep + config['batch_size']
+    if float(config['batch_interval']) > 0:
+        arguments += " -B" + sep + config['batch_interval']
+    if config['queue']:
+        arguments += queue_flag + sep + config['queue']
+    return arguments
+
+# Get throughput and p99 latency from the benchmark output (None if the run failed)
+def parseResults(output):
+    throughput = None
+    p99_latency = None
+    for line in output.splitlines():
+        if "Items-per-second" in line:
+            value = line.split()[2]
+            if isPositiveFloat(value):
+                throughput = float(value)
+        if "p99 latency" in line:
+            value = line.split()[4]
+            if isPositiveFloat(value):
+                p99_latency = float(value)
+    if throughput is None or p99_latency is None:
+        return None
+    return (throughput, p99_latency)
+
+# True if result a is at least as good as b in both objectives and better in one.
+# Results are (throughput, p99 latency): throughput is maximized and latency minimized
+def dominates(a, b):
+    return a[0] >= b[0] and a[1] <= b[1] and (a[0] > b[0] or a[1] < b[1])
+
+# Non-dominated sorting: returns the list of Pareto fronts (lists of indexes), best first
+def paretoFronts(results):
+    fronts = []
+    remaining = list(range(len(results)))
+    while remaining:
+        front = [i for i in remaining if not any(dominates(results[j], results[i]) for j in remaining if j != i)]
+        fronts.append(front)
+        remaining = [i for i in remaining if i not in front]
+    return fronts
+
+def configToString(config):
+    queue = config['queue'] if config['queue'] else 'default'
+    return "nthreads=" + config['nthreads'] + " batch=" + config['batch_size'] + " interval=" + config['batch_interval'] + " queue=" + queue
+
+def tune_func(spbench_path, args):
+
+    if args.benchmark_id == 'all':
+        print("\n Error!! You cannot tune all benchmarks at once.\n Try again using a single benchmark ID.\n")
+        sys.exit()
+
+    # get the selected benchmark (it is a list)
+    selected_benchmark = registryDicToList(filterBenchRegByBench(getBenchRegistry(spbench_path), args.benchmark_id))
+
+    app_id = selected_benchmark[0]["app_id"]
+    ppi_id = selected_benchmark[0]["ppi_id"]
+    bench_id = selected_benchmark[0]["bench_id"]
+    nsources = selected_benchmark[0]["nsources"]
+
+    bench_binary = spbench_path + "/bin/" + app_id + "/" + ppi_id + "/" + bench_id
+    if not fileExists(bench_binary):
+        print("\n  Error!! Binary file not found for "+ bench_id)
+        print("  Make sure you compiled the benchmark before tuning it.")
+        print("\n  Try to run:\n    ./spbench compile -bench " + bench_id + "\n")
+        sys.exit()
+
+    # put user selected inputs into a list
+    inputs_ID_list = []
+    for sub_list in args.input_id:
+        for input_id in sub_list:
+            inputs_ID_list.append(input_id)
+
+    # search space
+    space = {}
+    space['nthreads'] = parseValues('nthreads', args.nthreads)
+    space['batch_size'] = parseValues('batch', args.batch_size)
+    space['batch_interval'] = parseValues('batch-interval', args.batch_interval, True)
+    space['queue'] = ['']
+    if args.queue:
+        if nsources:
+            raise ArgumentTypeError("Argument error! Multi-source benchmarks do not support setting the queue capacity.")
+        space['queue'] = parseValues('queue', args.queue)
+
+    if not args.eta.isdigit() or int(args.eta) < 2:
+        raise ArgumentTypeError("Argument error! The reduction factor (-eta) must be an integer higher than or equal to two: " + args.eta)
+    if not args.max_repetitions.isdigit() or int(args.max_repetitions) < 1:
+        raise ArgumentTypeError("Argument error! The maximum number of repetitions must be an integer higher than or equal to one: " + args.max_repetitions)
+    if args.samples and (not args.samples.isdigit() or int(args.samples) < 1):
+        raise ArgumentTypeError("Argument error! The number of sampled configurations must be an integer higher than or equal to one: " + args.samples)
+    eta = int(args.eta)
+    max_repetitions = int(args.max_repetitions)
+
+    configs = [dict(zip(tune_parameters, values)) for values in itertools.product(*[space[p] for p in tune_parameters])]
+
+    # start from a random sample of the search space
+    random.seed(args.seed)
+    if args.samples and int(args.samples) < len(configs):
+        configs = random.sample(configs, int(args.samples))
+
+    exec_arguments = getInputArguments(spbench_path, app_id, nsources, inputs_ID_list) + " -l -T"
+    if args.user_args:
+        for sub_list in args.user_args:
+            for arg in sub_list:
+                if app_id == 'bzip2':
+                    exec_arguments += " -u" + arg
+                else:
+                    exec_arguments += " -u \"" + arg + "\""
+
+    executor = ''
+    if args.executor:
+        executor = args.executor + " "
+
+    print("\n Tuning benchmark: " + bench_id)
+    print(" Search space: " + str(len(configs)) + " configurations (" + args.strategy + ")")
+
+    # every run of each configuration, as (throughput, p99 latency)
+    runs = [[] for config in configs]
+
+    def evaluate(candidates, repetitions):
+        for i in candidates:
+            while len(runs[i]) < repetitions:
+                cmd_line = executor + bench_binary + exec_arguments + configArguments(app_id, configs[i])
+                result = parseResults(runShellWithReturn(cmd_line))
+                if result is None:
+                    print(" -> " + configToString(configs[i]) + ": unsuccessful execution, discarded")
+                    runs[i] = None
+                    break
+                runs[i].append(result)
+                if not args.quiet:
+                    print(" -> " + configToString(configs[i]) + ": throughput = " + str(round(result[0], 3)) + ", p99 latency (ms) = " + str(round(result[1], 3)))
+        return [i for i in candidates if runs[i] is not None]
+
+    def average(i):
+        return (sum(run[0] for run in runs[i])/len(runs[i]), sum(run[1] for run in runs[i])/len(runs[i]))
+
+    ##
+    # Successive halving: every rung runs the surviving configurations 'eta' times
+    # more and keeps the best 1/eta of them (by Pareto front), always keeping the
+    # whole first front. Grid search runs every configuration max-repeat times.
+    ##
+    candidates = list(range(len(configs)))
+    repetitions = 1 if args.strategy == 'halving' else max_repetitions
+    rung = 0
+    while True:
+        if args.strategy == 'halving':
+            print("\n ~~~> Rung " + str(rung) + ": " + str(len(candidates)) + " configurations, " + str(repetitions) + " repetition(s) each")
+        candidates = evaluate(candidates, repetitions)
+        if not candidates:
+            print("\n Error!! No configuration ran successfully.\n")
+            sys.exit()
+        if args.strategy != 'halving' or repetitions >= max_repetitions or len(candidates) <= eta:
+            break
+
+        fronts = paretoFronts([average(i) for i in candidates])
+        keep = max(int(math.ceil(len(candidates)/float(eta))), len(fronts[0]))
+        survivors = []
+        for front in fronts:
+            # prefer the higher throughput inside a front
+            for j in sorted(front, key=lambda j: -average(candidates[j])[0]):
+                if len(survivors) < keep:
+                    survivors.append(candidates[j])
+        if len(survivors) == len(candidates):
+            break
+        candidates = survivors
+        repetitions = min(repetitions*eta, max_repetitions)
+        rung += 1
+
+    results = [average(i) for i in candidates]
+    pareto = sorted([candidates[j] for j in paretoFronts(results)[0]], key=lambda i: -average(i)[0])
+
+    print("\n*************** PARETO FRONT ***************\n")
+    print(" Throughput (items/s) x p99 latency (ms)\n")
+    for i in pareto:
+        print("  " + str(round(average(i)[0], 3)).rjust(12) + "  " + str(round(average(i)[1], 3)).rjust(10) + "   " + configToString(configs[i]))
+    print("\n********************************************")
+
+    ##
+    # Write every configuration evaluated in the last rung to the tuning log
+    ##
+    log_dir = spbench_path + "/log"
+    if(not dirExists(log_dir)):
+        try:
+            os.mkdir(log_dir)
+        except OSError as error:
+            print(error)
+
+    log_file = log_dir + "/" + bench_id + "_tune.csv"
+    with open(log_file, 'w') as tune_log_file:
+        tune_log_file.write("Time;Benchmark;Input;N threads;Batch size;Batch int.;Queue;Repetitions;Throughput;p99 latency;Pareto\n")
+        print_time = datetime.datetime.now().strftime("%d/%m/%y %H:%M:%S")
+        for i in sorted(candidates, key=lambda i: -average(i)[0]):
+            config = configs[i]
+            log_line = [print_time, bench_id, ','.join(inputs_ID_list), config['nthreads'], config['batch_size'], config['batch_interval'], config['queue'], str(len(runs[i])), str(average(i)[0]), str(average(i)[1]), str(i in pareto)]
+            tune_log_file.write(';'.join(log_line) + "\n")
+
+    print("\n Results written to " + log_file + "\n")
+
+    sys.exit()
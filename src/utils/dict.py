@@ -56,6 +56,37 @@ def getInputsRegistry(spbench_path):
         sys.exit()
     return getRegistry(registry_file)
 
+# Build the input arguments of the benchmark (same rules as the exec command)
+def getInputArguments(spbench_path, app_id, nsources, inputs_ID_list):
+    inputs_dic = getInputsRegistry(spbench_path).get(app_id)
+    if not inputs_dic:
+        print("\n  Error! No registered inputs for benchmarks based on \'" + app_id + "\' application.")
+        print("  You can run \'./spbench list-inputs\' to see the registered inputs.\n")
+        sys.exit()
+
+    input_id = ''
+    for key in inputs_ID_list:
+        if key not in inputs_dic:
+            print(" Input ID \'" + key + "\' not found for " + app_id)
+            print(" You can run \'./spbench list-inputs\' to see the registered inputs.")
+            sys.exit()
+        input = inputs_dic[key]['input'].replace('$SPB_HOME', spbench_path)
+        if app_id == 'bzip2':
+            input_id += " " + os.path.abspath(input) # bzip2 does not require -i flag
+        elif app_id == 'lane_detection':
+            input_id += " -i " + os.path.abspath(input)
+        else:
+            input_id += " -i \"" + input + ' ' + key + "\""
+
+        # if it is a single source benchmark, get only the first input
+        if not nsources:
+            break
+
+    if app_id == 'bzip2':
+        # keep the registered input and overwrite the previous output
+        input_id += ' --force --keep'
+    return input_id
+
 def getAppsRegistry(spbench_path):
     """return a dictionay with the apps registered data
     """
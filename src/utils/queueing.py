@@ -0,0 +1,223 @@
+##
+ ##############################################################################
+ #  File  : queueing.py
+ #
+ #  Title : SPBench queueing-network model of stream processing topologies
+ #
+ #  Author: Adriano Marques Garcia <adriano1mg@gmail.com>
+ #
+ #  Date  : July 06, 2021
+ #
+ #  Copyright (C) 2021 Adriano M. Garcia
+ #
+ #  This program is free software: you can redistribute it and/or modify
+ #  it under the terms of the GNU General Public License as published by
+ #  the Free Software Foundation, either version 3 of the License, or
+ #  (at your option) any later version.
+ #
+ #  This program is distributed in the hope that it will be useful,
+ #  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ #  GNU General Public License for more details.
+ #
+ #  You should have received a copy of the GNU General Public License
+ #  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ #
+ ##############################################################################
+##
+
+import heapq
+import math
+import random
+
+from collections import deque
+
+##
+# A topology is a network of stations. Each station runs one or more operators
+# (columns of the latency log) for every batch and has one or more replicas
+# (servers) taking batches from a FIFO queue. Batches are emitted by the
+# source (a single server) while fewer than 'in_flight' batches are between
+# the source and the sink, like the token limit of the TBB, GrPPI and threads
+# versions, and the sink can take them in order (reordering buffer).
+#
+# The latency of a batch goes from the source starting it to the sink
+# finishing it, as measured by SPBench.
+##
+
+topologies = ['sequential', 'pipeline', 'farm', 'pipe-farm', 'farm-pipe', 'a2a']
+
+class Station:
+    def __init__(self, name, columns, servers, ordered=False):
+        self.name = name
+        self.columns = columns
+        self.servers = servers
+        self.ordered = ordered
+        self.busy = 0
+        self.busy_time = 0.0
+        self.queue = deque()
+        self.pending = set()
+        self.next_index = 0
+
+    def ready(self):
+        if self.ordered:
+            return self.next_index in self.pending
+        return len(self.queue) > 0
+
+    def push(self, batch):
+        if self.ordered:
+            self.pending.add(batch)
+        else:
+            self.queue.append(batch)
+
+    def pop(self):
+        if self.ordered:
+            self.pending.remove(self.next_index)
+            self.next_index += 1
+            return self.next_index - 1
+        return self.queue.popleft()
+
+# Topology of a benchmark from the name of its parallel pattern
+def topologyFromName(bench_id):
+    if 'a2a' in bench_id:
+        return 'a2a'
+    for topology in ['farm-pipe', 'pipe-farm', 'farm', 'pipeline']:
+        if topology in bench_id:
+            return topology
+    if 'seq' in bench_id:
+        return 'sequential'
+    return None
+
+##
+# Stations of a topology for the operators of the latency log (source first
+# and sink last). It returns the source, the paths (lists of stations from
+# the source to the sink, batch i takes path i % len(paths)) and the groups
+# of stations reported together.
+##
+def buildTopology(topology, operators, nthreads):
+    last = len(operators) - 1
+    middle = list(range(1, last))
+    source = Station(operators[0], [0], 1)
+    if topology == 'sequential' or last < 1:
+        source.columns = list(range(0, last + 1))
+        source.name = 'Sequential'
+        return source, [[source]], [[source]]
+
+    sink = Station(operators[last], [last], 1, ordered=(topology != 'a2a'))
+    if topology == 'farm-pipe':
+        # replicas of the whole pipeline of operators, dispatched round-robin
+        chains = [[Station(operators[c], [c], 1) for c in middle] for i in range(nthreads)]
+        paths = [[source] + chain + [sink] for chain in chains]
+        groups = [[source]] + [[chain[j] for chain in chains] for j in range(len(middle))] + [[sink]]
+        return source, paths, groups
+
+    if topology == 'farm':
+        workers = [Station('+'.join(operators[c].strip() for c in middle), middle, nthreads)]
+    elif topology == 'pipeline':
+        workers = [Station(operators[c], [c], 1) for c in middle]
+    else: # pipe-farm, a2a
+        workers = [Station(operators[c], [c], nthreads) for c in middle]
+    path = [source] + workers + [sink]
+    return source, [path], [[station] for station in path]
+
+def percentile(values, p):
+    """Nearest-rank percentile, as printed by SPBench"""
+    ordered = sorted(values)
+    if not ordered:
+        return 0.0
+    return ordered[max(0, int(math.ceil(p/100.0 * len(ordered))) - 1)]
+
+##
+# Discrete-event simulation of a topology. 'samples' are the per-batch
+# service times (ms) of each operator. By default the batches replay the
+# samples in order (trace driven); with 'batches' they are drawn at random.
+##
+def simulate(samples, operators, topology, nthreads, in_flight, batches=None, seed=1):
+    if batches:
+        rng = random.Random(seed)
+        rows = [rng.choice(samples) for i in range(batches)]
+    else:
+        rows = samples
+    source, paths, groups = buildTopology(topology, operators, nthreads)
+
+    events = []
+    sequence = [0]
+    start = [0.0] * len(rows)
+    latencies = []
+    state = {'now': 0.0, 'next_batch': 0, 'in_flight': 0}
+
+    def service(station, batch):
+        return sum(rows[batch][c] for c in station.columns)
+
+    def schedule(station, batch):
+        station.busy += 1
+        time = service(station, batch)
+        station.busy_time += time
+        sequence[0] += 1
+        heapq.heappush(events, (state['now'] + time, sequence[0], station, batch))
+
+    def startSource():
+        if source.busy == 0 and state['next_batch'] < len(rows) and state['in_flight'] < in_flight:
+            batch = state['next_batch']
+            state['next_batch'] += 1
+            state['in_flight'] += 1
+            start[batch] = state['now']
+            schedule(source, batch)
+
+    def startStation(station):
+        while station.busy < station.servers and station.ready():
+            schedule(station, station.pop())
+
+    startSource()
+    while events:
+        now, seq, station, batch = heapq.heappop(events)
+        state['now'] = now
+        station.busy -= 1
+        path = paths[batch % len(paths)]
+        position = path.index(station)
+        if position + 1 < len(path):
+            next_station = path[position + 1]
+            next_station.push(batch)
+            startStation(next_station)
+        else:
+            latencies.append(now - start[batch])
+            state['in_flight'] -= 1
+        if station is source:
+            startSource()
+        else:
+            startStation(station)
+            if position + 1 == len(path):
+                startSource()
+
+    makespan = state['now']
+    result = {}
+    result['batches'] = len(latencies)
+    result['throughput'] = len(latencies) / (makespan / 1000.0) if makespan > 0 else 0.0
+    result['latency'] = sum(latencies) / len(latencies) if latencies else 0.0
+    result['p99_latency'] = percentile(latencies, 99)
+    result['utilization'] = []
+    for group in groups:
+        busy = sum(station.busy_time for station in group)
+        servers = sum(station.servers for station in group)
+        result['utilization'].append((group[0].name.strip(), busy / (servers * makespan) if makespan > 0 else 0.0))
+    return result
+
+# Operational bound: the throughput (batches/s) of the slowest group of stations
+def throughputBound(samples, operators, topology, nthreads):
+    source, paths, groups = buildTopology(topology, operators, nthreads)
+    bounds = []
+    for group in groups:
+        mean = sum(sum(row[c] for c in group[0].columns) for row in samples) / len(samples)
+        servers = sum(station.servers for station in group)
+        bounds.append((servers * 1000.0 / mean if mean > 0 else float('inf'), group[0].name.strip()))
+    return min(bounds)
+
+# Read the latency log written by the benchmarks with -L (-latency-monitor)
+def readLatencyLog(file_name):
+    with open(file_name) as log_file:
+        operators = log_file.readline().split()
+        samples = []
+        for line in log_file:
+            values = line.split()
+            if len(values) == len(operators):
+                samples.append([float(value) for value in values])
+    return operators, samples
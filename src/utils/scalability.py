@@ -0,0 +1,126 @@
+##
+ ##############################################################################
+ #  File  : scalability.py
+ #
+ #  Title : SPBench scalability models (Amdahl and USL)
+ #
+ #  Author: Adriano Marques Garcia <adriano1mg@gmail.com>
+ #
+ #  Date  : July 06, 2021
+ #
+ #  Copyright (C) 2021 Adriano M. Garcia
+ #
+ #  This program is free software: you can redistribute it and/or modify
+ #  it under the terms of the GNU General Public License as published by
+ #  the Free Software Foundation, either version 3 of the License, or
+ #  (at your option) any later version.
+ #
+ #  This program is distributed in the hope that it will be useful,
+ #  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ #  GNU General Public License for more details.
+ #
+ #  You should have received a copy of the GNU General Public License
+ #  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ #
+ ##############################################################################
+##
+
+import math
+
+##
+# Universal Scalability Law (Gunther):
+#
+#   X(N) = lambda * N / (1 + sigma * (N - 1) + kappa * N * (N - 1))
+#
+# where lambda is the throughput of one thread, sigma the contention and
+# kappa the coherency (crosstalk) coefficient. Amdahl's law is the USL with
+# kappa = 0, where sigma is the serial fraction.
+#
+# For a given lambda, N / C(N) - 1 = sigma * (N - 1) + kappa * N * (N - 1),
+# with C(N) = X(N) / lambda, is linear in sigma and kappa and is solved by
+# least squares. If one thread was not measured, lambda is searched to
+# minimize the relative error of the throughput.
+##
+
+def uslThroughput(model, n):
+    return model['lambda'] * n / (1 + model['sigma'] * (n - 1) + model['kappa'] * n * (n - 1))
+
+# least squares of y = sigma * x + kappa * (x + 1) * x, with x = N - 1 and sigma, kappa >= 0
+def fitCoefficients(points, lam, amdahl):
+    sxx = sxz = szz = sxy = szy = 0.0
+    for n, thr in points:
+        x = n - 1.0
+        z = n * (n - 1.0)
+        y = n * lam / thr - 1.0
+        sxx += x*x
+        sxz += x*z
+        szz += z*z
+        sxy += x*y
+        szy += z*y
+
+    sigma = 0.0
+    kappa = 0.0
+    det = sxx*szz - sxz*sxz
+    if not amdahl and det > 0:
+        sigma = (sxy*szz - szy*sxz) / det
+        kappa = (szy*sxx - sxy*sxz) / det
+    if amdahl or kappa < 0 or det <= 0:
+        # contention only
+        kappa = 0.0
+        sigma = sxy / sxx if sxx > 0 else 0.0
+    if sigma < 0:
+        # coherency only
+        sigma = 0.0
+        kappa = max(0.0, szy / szz) if (szz > 0 and not amdahl) else 0.0
+    return sigma, kappa
+
+def relativeError(model, points):
+    return sum(((uslThroughput(model, n) - thr) / thr) ** 2 for n, thr in points)
+
+def fitModel(points, amdahl=False):
+    """Fit the USL (or Amdahl's law) to a list of (nthreads, throughput) points.
+    Returns a dict with lambda, sigma, kappa and the relative RMS error, or None."""
+    points = sorted([(float(n), float(thr)) for n, thr in points if n >= 1 and thr > 0])
+    if len(points) < 3 or points[0][0] == points[-1][0]:
+        return None
+
+    def fit(lam):
+        sigma, kappa = fitCoefficients(points, lam, amdahl)
+        return {'lambda': lam, 'sigma': sigma, 'kappa': kappa}
+
+    if points[0][0] == 1:
+        model = fit(points[0][1])
+    else:
+        # golden-section search of lambda
+        per_thread = max(thr / n for n, thr in points)
+        low, high = per_thread * 0.5, per_thread * 4.0
+        ratio = (math.sqrt(5) - 1) / 2
+        for i in range(0, 100):
+            a = high - ratio * (high - low)
+            b = low + ratio * (high - low)
+            if relativeError(fit(a), points) < relativeError(fit(b), points):
+                high = b
+            else:
+                low = a
+        model = fit((low + high) / 2)
+
+    model['rms'] = math.sqrt(relativeError(model, points) / len(points))
+    return model
+
+def peakConcurrency(model):
+    """Number of threads of maximum throughput, or None if the model never peaks"""
+    if model['kappa'] <= 0:
+        return None
+    return math.sqrt((1 - model['sigma']) / model['kappa'])
+
+def deviatingPoints(model, points, threshold=0.1):
+    """Points whose throughput deviates from the model more than threshold (relative)
+    and more than twice the RMS relative error of the fit"""
+    deviating = []
+    for n, thr in points:
+        predicted = uslThroughput(model, n)
+        deviation = (thr - predicted) / predicted
+        if abs(deviation) > max(threshold, 2 * model['rms']):
+            deviating.append((n, thr, predicted, deviation))
+    return deviating
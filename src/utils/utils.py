@@ -55,6 +55,13 @@ reserved_words = {'all', 'bzip2', 'ferret', 'lane_detection', 'person_recognitio
 def isNotBlank (my_string):
     return bool(my_string and my_string.strip())
 
+# check if string is a number higher than or equal to zero
+def isPositiveFloat(my_string):
+	try:
+		return float(my_string) >= 0
+	except ValueError:
+		return False
+
 def variance(data, ddof=0):
 	n = len(data)
 	mean = sum(data) / n
@@ -64,3 +71,46 @@ def stdev(data):
 	var = variance(data)
 	std_dev = math.sqrt(var)
 	return std_dev
+
+def median(data):
+	values = sorted(data)
+	n = len(values)
+	if n % 2:
+		return values[n//2]
+	return (values[n//2 - 1] + values[n//2]) / 2.0
+
+# two-sided 95% Student's t critical values for 1 to 30 degrees of freedom
+t_critical_95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+def tCritical95(dof):
+	if dof < 1:
+		return float('inf')
+	if dof <= len(t_critical_95):
+		return t_critical_95[dof - 1]
+	return 1.96
+
+# half-width of the 95% confidence interval of the mean (sample std. dev.)
+def confidenceInterval95(data):
+	n = len(data)
+	if n < 2:
+		return float('inf')
+	return tCritical95(n - 1) * math.sqrt(variance(data, 1)) / math.sqrt(n)
+
+# Iglewicz and Hoaglin's rule: x is an outlier when its modified z-score,
+# 0.6745 * |x - median| / MAD, is higher than 3.5.
+# Returns the (low, high) bounds of the values kept
+def outlierBounds(data, threshold=3.5):
+	if len(data) < 3:
+		return (float('-inf'), float('inf'))
+	med = median(data)
+	mad = median([abs(x - med) for x in data])
+	if mad == 0:
+		return (float('-inf'), float('inf'))
+	width = threshold * mad / 0.6745
+	return (med - width, med + width)
+
+def discardOutliers(data):
+	low, high = outlierBounds(data)
+	return [x for x in data if low <= x <= high]
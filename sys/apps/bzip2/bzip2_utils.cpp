@@ -137,6 +137,8 @@ static char BWTblockSizeChar = '9';
 
 bool stream_end = false;
 
+ItemPool<Item> item_pool;
+
 void mySignalCatcher(int);
 char* memstr(char*, int, char*, int);
 
@@ -171,6 +173,8 @@ unsigned int global_decomp = 0; //0 for compress and 1 for decompress
 
 bool optimized_memory = false;
 
+bool deferred_read = false;
+
 std::vector <data> MemData;
 
 char* MemReadData;
@@ -179,7 +183,13 @@ unsigned int outFileSize = 0;
 
 void set_operators_name() {
 	if (Metrics::latency_is_enabled()) {
-		if (global_decomp == 1) {
+		if (deferred_read) {
+			SPBench::addOperatorName("Split     ");
+			SPBench::addOperatorName("Read      ");
+			SPBench::addOperatorName((global_decomp == 1) ? "Decompress" : "Compress  ");
+			SPBench::addOperatorName("Write     ");
+		}
+		else if (global_decomp == 1) {
 			SPBench::addOperatorName("Read      ");
 			SPBench::addOperatorName("Decompress");
 			SPBench::addOperatorName("Write     ");
@@ -195,6 +205,8 @@ void set_operators_name() {
 long Source::source_item_timestamp = current_time_usecs();
 
 bool Source::op(Item &item){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	//if last batch included the last item, ends computation
 	if(stream_end == true){
@@ -204,11 +216,15 @@ bool Source::op(Item &item){
 	// frequency control mechanism
 	SPBench::item_frequency_control(source_item_timestamp);
 
-	item.timestamp = source_item_timestamp = current_time_usecs();
+	// the clock is read only if the timestamps of the batch are used
+	if(SPBench::source_timing_is_enabled())
+		source_item_timestamp = current_time_usecs();
 	unsigned long batch_elapsed_time = source_item_timestamp;
 	
+	// the batch carries the sampling decision to the operators
+	item.sampled = SPBench::batch_sampling();
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = source_item_timestamp;
 	}
 
@@ -256,6 +272,15 @@ bool Source::op(Item &item){
 			}
 			bytesLeft -= item_data.buffSize;
 		}
+		else if (deferred_read) {
+			// only split the input, the block is loaded by read_block()
+			if (bytesLeft == 0) {
+				stream_end = true;
+				break;
+			}
+			item_data.offset = fileSize - bytesLeft;
+			bytesLeft -= item_data.buffSize;
+		}
 		else {
 			item_data.FileData = new char[item_data.buffSize];
 			// read file data from disk
@@ -288,7 +313,20 @@ bool Source::op(Item &item){
 		return false;
 	}
 
-	if (Metrics::latency_is_enabled()) {
+	// only emitted batches take an in-flight slot and count in the open-loop schedule
+	unsigned long emission_time = source_item_timestamp;
+	if (SPBench::tuning_is_enabled()) {
+		// the tuned limit grows up to the largest capacity asked by the runtime
+		if (Metrics::batch_counter == 0)
+			item_pool.reserve(SPBench::getTuningMaxLimit() + 1);
+		SPBench::in_flight_control();
+		// the wait for a slot is not part of the latency of the batch
+		emission_time = current_time_usecs();
+	}
+	// in open-loop mode the latency counts from the scheduled arrival time
+	item.timestamp = SPBench::item_arrival_time(emission_time);
+
+	if (Metrics::operator_latency_is_enabled(item)) {
 		item.latency_op.push_back(current_time_usecs() - latency_op);
 	}
 
@@ -298,9 +336,11 @@ bool Source::op(Item &item){
 }
 
 void Sink::op(Item& item) {
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 
 	unsigned long latency_op;
-	if (Metrics::latency_is_enabled()) {
+	if (Metrics::operator_latency_is_enabled(item)) {
 		latency_op = current_time_usecs();
 	}
 
@@ -356,11 +396,14 @@ void Sink::op(Item& item) {
 		Metrics::items_at_sink_counter++;
 	}
 
+	SPBench::in_flight_release(item.timestamp, item.batch_size);
 	Metrics::batches_at_sink_counter++;
 
 	if(Metrics::latency_is_enabled()){
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		Metrics::global_latency_acc += total_item_latency; // to compute real time average latency
@@ -513,6 +556,181 @@ int direct_compress(char* OutFilename)
 	return 0;
 }
 
+/**
+ * Read block
+ *
+ * Loads a block listed by a source running with deferred_read.
+ * It uses pread(), so several blocks can be read at the same time.
+ * Blocks already in memory (-I) are left untouched.
+ *
+ * @param item block to be loaded.
+ * @return nothing.
+ */
+void read_block(item_data &item) {
+	if (item.FileData != NULL)
+		return;
+
+	item.FileData = new char[item.buffSize];
+	OFF_T bytesRead = 0;
+	while (bytesRead < item.buffSize) {
+		ssize_t ret = pread(hInfile, item.FileData + bytesRead, item.buffSize - bytesRead, item.offset + bytesRead);
+		if (ret <= 0) {
+			fprintf(stderr, "Bzip2: *ERROR: Could not read from file!  Skipping...\n");
+			exit(-1);
+		}
+		bytesRead += ret;
+	}
+}
+
+/*
+*********************************************************
+*/
+
+FILE * capture_file = NULL;
+static const char capture_magic[] = "SPBCAP01";
+
+// function-local, so operators can register from static initializers
+std::map<std::string, replay_operator_t> &replay_operators(){
+	static std::map<std::string, replay_operator_t> operators;
+	return operators;
+}
+
+bool register_replay_operator(const std::string &name, replay_operator_t op){
+	replay_operators()[name] = op;
+	return true;
+}
+
+/**
+ * Capture batch
+ *
+ * Writes a batch entering an operator to the capture file.
+ * Batches are written in the order they enter the operator, which may differ
+ * from the stream order in the parallel versions.
+ * Format: magic, operator name, then for each batch its size and, for each
+ * item, index, offset, buffSize and the input data (FileData).
+ *
+ * @param operator_name operator receiving the batch
+ * @param item batch to be written
+ * @return nothing.
+ */
+void capture_batch(const std::string &operator_name, const Item &item){
+	// parallel versions capture from several replicas at a time
+	static std::mutex capture_mutex;
+	std::lock_guard<std::mutex> lock(capture_mutex);
+	static bool header = false;
+	if(!header){
+		unsigned int name_size = operator_name.size();
+		fwrite(capture_magic, 1, sizeof(capture_magic), capture_file);
+		fwrite(&name_size, sizeof(name_size), 1, capture_file);
+		fwrite(operator_name.c_str(), 1, name_size, capture_file);
+		header = true;
+	}
+	int batch_size = item.batch_size;
+	fwrite(&batch_size, sizeof(batch_size), 1, capture_file);
+	for(int i = 0; i < batch_size; i++){
+		const item_data &data = item.item_batch[i];
+		int64_t offset = data.offset;
+		int64_t size = data.buffSize;
+		fwrite(&data.index, sizeof(data.index), 1, capture_file);
+		fwrite(&offset, sizeof(offset), 1, capture_file);
+		fwrite(&size, sizeof(size), 1, capture_file);
+		fwrite(data.FileData, 1, size, capture_file);
+	}
+}
+
+/**
+ * Replay
+ *
+ * Loads the batches of a capture file and replays them through the captured
+ * operator alone, with 1, 2, 4, ... up to nthreads independent threads.
+ *
+ * @param file_name capture file
+ * @param rounds times each thread replays all the batches
+ * @return 0 on success.
+ */
+int replay_main(const char * file_name, unsigned int rounds){
+	FILE * file = fopen(file_name, "rb");
+	if(file == NULL){
+		fprintf(stderr, "Bzip2: *ERROR: Could not open capture file [%s]!  Aborting...\n", file_name);
+		return 1;
+	}
+
+	char magic[sizeof(capture_magic)];
+	unsigned int name_size = 0;
+	if(fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, capture_magic, sizeof(magic)) != 0
+		|| fread(&name_size, sizeof(name_size), 1, file) != 1 || name_size > 256){
+		fprintf(stderr, "Bzip2: *ERROR: [%s] is not a capture file!  Aborting...\n", file_name);
+		fclose(file);
+		return 1;
+	}
+	std::string operator_name(name_size, ' ');
+	if(fread(&operator_name[0], 1, name_size, file) != name_size){
+		fprintf(stderr, "Bzip2: *ERROR: [%s] is not a capture file!  Aborting...\n", file_name);
+		fclose(file);
+		return 1;
+	}
+	if(replay_operators().count(operator_name) == 0){
+		fprintf(stderr, "Bzip2: *ERROR: Operator %s cannot be replayed by this benchmark!  Aborting...\n", operator_name.c_str());
+		fclose(file);
+		return 1;
+	}
+	replay_operator_t op = replay_operators()[operator_name];
+
+	// load the captured batches
+	std::vector<Item> batches;
+	double bytes = 0.0;
+	int batch_size;
+	while(fread(&batch_size, sizeof(batch_size), 1, file) == 1){
+		Item item;
+		item.batch_size = batch_size;
+		for(int i = 0; i < batch_size; i++){
+			item_data data;
+			int64_t offset, size;
+			if(fread(&data.index, sizeof(data.index), 1, file) != 1 || fread(&offset, sizeof(offset), 1, file) != 1 || fread(&size, sizeof(size), 1, file) != 1){
+				fprintf(stderr, "Bzip2: *ERROR: Truncated capture file [%s]!  Aborting...\n", file_name);
+				exit(-1);
+			}
+			data.offset = offset;
+			data.buffSize = size;
+			data.FileData = new char[size];
+			if(fread(data.FileData, 1, size, file) != (size_t)size){
+				fprintf(stderr, "Bzip2: *ERROR: Truncated capture file [%s]!  Aborting...\n", file_name);
+				exit(-1);
+			}
+			bytes += size;
+			item.item_batch.push_back(data);
+		}
+		batches.push_back(item);
+	}
+	fclose(file);
+
+	// the operators only read FileData, so the threads share it
+	auto prepare = [](const Item &batch){
+		Item item;
+		item.batch_size = batch.batch_size;
+		item.item_batch = batch.item_batch;
+		return item;
+	};
+	auto release = [](Item &item){
+		for(unsigned int i = 0; i < item.item_batch.size(); i++)
+			delete [] item.item_batch[i].CompDecompData;
+	};
+
+	std::vector<replay_result_t> results;
+	std::vector<unsigned int> thread_counts = replay_thread_counts(nthreads);
+	for(unsigned int i = 0; i < thread_counts.size(); i++){
+		replay_result_t result = replay_operator(batches, thread_counts[i], rounds, prepare, op, release);
+		result.bytes = bytes * rounds * thread_counts[i];
+		results.push_back(result);
+	}
+	print_replay(operator_name, results);
+
+	for(unsigned int b = 0; b < batches.size(); b++)
+		for(unsigned int i = 0; i < batches[b].item_batch.size(); i++)
+			delete [] batches[b].item_batch[i].FileData;
+	return 0;
+}
+
 /*
 *********************************************************
 */
@@ -520,6 +738,8 @@ int direct_compress(char* OutFilename)
 long Source_d::source_item_timestamp = current_time_usecs();
 
 bool Source_d::op(Item &item){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	//if last batch included the last item, ends computation
 	if(stream_end == true){
@@ -529,11 +749,15 @@ bool Source_d::op(Item &item){
 	// frequency control mechanism
 	SPBench::item_frequency_control(source_item_timestamp);
 
-	item.timestamp = source_item_timestamp = current_time_usecs();
+	// the clock is read only if the timestamps of the batch are used
+	if(SPBench::source_timing_is_enabled())
+		source_item_timestamp = current_time_usecs();
 	unsigned long batch_elapsed_time = source_item_timestamp;
 	
+	// the batch carries the sampling decision to the operators
+	item.sampled = SPBench::batch_sampling();
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = source_item_timestamp;
 	}
 
@@ -553,6 +777,21 @@ bool Source_d::op(Item &item){
 
 		item_data item_data;
 
+		if (deferred_read && !SPBench::memory_source_is_enabled()) {
+			// only list the block, it is loaded by read_block()
+			if (Metrics::items_counter >= bz2NumBlocks) {
+				stream_end = true;
+				break;
+			}
+			item_data.offset = bz2BlockList[Metrics::items_counter].dataStart;
+			item_data.buffSize = bz2BlockList[Metrics::items_counter].dataSize;
+			item.item_batch.resize(item.batch_size + 1);
+			item.item_batch[item.batch_size] = item_data;
+			item.batch_size++;
+			Metrics::items_counter++;
+			continue;
+		}
+
 		// go to start of block position in file
 #ifndef WIN32
 		int ret = lseek(hInfile, bz2BlockList[Metrics::items_counter].dataStart, SEEK_SET);
@@ -653,7 +892,20 @@ bool Source_d::op(Item &item){
 		return false;
 	}
 
-	if (Metrics::latency_is_enabled()) {
+	// only emitted batches take an in-flight slot and count in the open-loop schedule
+	unsigned long emission_time = source_item_timestamp;
+	if (SPBench::tuning_is_enabled()) {
+		// the tuned limit grows up to the largest capacity asked by the runtime
+		if (Metrics::batch_counter == 0)
+			item_pool.reserve(SPBench::getTuningMaxLimit() + 1);
+		SPBench::in_flight_control();
+		// the wait for a slot is not part of the latency of the batch
+		emission_time = current_time_usecs();
+	}
+	// in open-loop mode the latency counts from the scheduled arrival time
+	item.timestamp = SPBench::item_arrival_time(emission_time);
+
+	if (Metrics::operator_latency_is_enabled(item)) {
 		item.latency_op.push_back(current_time_usecs() - latency_op);
 	}
 
@@ -663,9 +915,11 @@ bool Source_d::op(Item &item){
 }
 
 void Sink_d::op(Item& item) {
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 
 	unsigned long latency_op;
-	if (Metrics::latency_is_enabled()) {
+	if (Metrics::operator_latency_is_enabled(item)) {
 		latency_op = current_time_usecs();
 	}
 	unsigned int num_item = 0;
@@ -716,11 +970,14 @@ void Sink_d::op(Item& item) {
 		num_item++;
 		Metrics::items_at_sink_counter++;
 	}
+	SPBench::in_flight_release(item.timestamp, item.batch_size);
 	Metrics::batches_at_sink_counter++;
 
 	if(Metrics::latency_is_enabled()){
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		Metrics::global_latency_acc += total_item_latency; // to compute real time average latency
@@ -1347,7 +1604,16 @@ void usage(char* progname, const char* reason)
 	fprintf(stderr, " -L       : store individual latency values into a file\n");
 	fprintf(stderr, " -T       : print average throughput results\n");
 	fprintf(stderr, " -r       : print memory consumption results generated by UPL library\n");
+	fprintf(stderr, " -S#      : where # is the number of in-flight tokens / queue capacity used by the parallel runtime\n");
+	fprintf(stderr, " -A#      : where # is the latency constraint in milliseconds. It searches the number of in-flight batches online (0: no latency constraint)\n");
+	fprintf(stderr, " -O       : open loop, with -f/-F the latency is measured from the scheduled arrival time of each batch\n");
+	fprintf(stderr, " -s#      : where # is n or a rate. Per-operator latency of one batch every n batches, or of each batch with probability rate (0-1)\n");
+	fprintf(stderr, " -U       : unordered mode, ignored since the compressed blocks must be written in order\n");
 	fprintf(stderr, " -X       : overwrite existing output file\n");
+	fprintf(stderr, " --runtime=<opt,...> : parallel runtime options: blocking|spinning, ordered|unordered, ondemand[=n]|roundrobin, mapping=<core:core:...>|nomapping (FastFlow versions)\n");
+	fprintf(stderr, " --capture=<file> : write the batches entering the operator to <file>\n");
+	fprintf(stderr, " --replay=<file>  : replay the batches of a capture file through the operator alone, with 1 to -t# threads\n");
+	fprintf(stderr, " --rounds=#       : where # is the number of times each thread replays the captured batches (default 1)\n");
 	fprintf(stderr, " -h       : print this help message\n");
 	//fprintf(stderr, " -k       : keep input file, don't delete\n");
 	//#ifndef PBZIP_NO_LOADAVG
@@ -1424,6 +1690,8 @@ int bzip2_main(int argc, char* argv[])
 	int force = 0;
 	int ret = 0;
 	int fileLoop;
+	char* replayFilename = NULL;
+	unsigned int replayRounds = 1;
 	int i, j, k;
 
 	// get current time for benchmark reference
@@ -1521,6 +1789,38 @@ int bzip2_main(int argc, char* argv[])
 				{
 					keep = 1;
 				}
+				else if (strncmp(argv[i], "--capture=", 10) == 0)
+				{
+					capture_file = fopen(argv[i] + 10, "wb");
+					if (capture_file == NULL)
+					{
+						fprintf(stderr, "Bzip2: *ERROR: Could not create capture file [%s]!  Aborting...\n", argv[i] + 10);
+						return 1;
+					}
+				}
+				else if (strncmp(argv[i], "--replay=", 9) == 0)
+				{
+					replayFilename = argv[i] + 9;
+				}
+				else if (strncmp(argv[i], "--runtime=", 10) == 0)
+				{
+					try {
+						SPBench::setRuntimeOptions(argv[i] + 10);
+					} catch (const std::invalid_argument &error) {
+						fprintf(stderr, "%s", error.what());
+						return 1;
+					}
+				}
+				else if (strcmp(argv[i], "--unordered") == 0)
+				{
+					SPBench::setOrdered(false);
+				}
+				else if (strncmp(argv[i], "--rounds=", 9) == 0)
+				{
+					replayRounds = atoi(argv[i] + 9);
+					if (replayRounds < 1)
+						usage(argv[0], "Cannot parse --rounds argument");
+				}
 				else if (strcmp(argv[i], "--license") == 0)
 				{
 					usage(argv[0], "HELP");
@@ -1776,6 +2076,60 @@ int bzip2_main(int argc, char* argv[])
 					fprintf(stderr, "-t%d\n", monitoring_time_interval);
 #endif
 					break;
+				case 'S': k = j + 1; cmdLineTempCount = 0; strcpy(cmdLineTemp, "2");
+					while (argv[i][k] != '\0' && k < sizeof(cmdLineTemp))
+					{
+						// no more numbers, finish
+						if ((argv[i][k] < '0') || (argv[i][k] > '9'))
+							break;
+						k++;
+						cmdLineTempCount++;
+					}
+					if (cmdLineTempCount == 0)
+						usage(argv[0], "Cannot parse -S argument");
+					if (atoi(argv[i] + j + 1) < 1)
+					{
+						fprintf(stderr, "Bzip2: *ERROR: Minimum queue capacity is 1!  Aborting...\n");
+						return 1;
+					}
+					SPBench::setQueueCapacity(atoi(argv[i] + j + 1));
+					j += cmdLineTempCount;
+					break;
+				case 'A': k = j + 1; cmdLineTempCount = 0; strcpy(cmdLineTemp, "2");
+					while (argv[i][k] != '\0' && k < sizeof(cmdLineTemp))
+					{
+						// no more numbers, finish
+						if (((argv[i][k] < '0') || (argv[i][k] > '9')) && argv[i][k] != '.')
+							break;
+						k++;
+						cmdLineTempCount++;
+					}
+					if (cmdLineTempCount == 0)
+						usage(argv[0], "Cannot parse -A argument");
+					SPBench::enable_tuning(atof(argv[i] + j + 1));
+					j += cmdLineTempCount;
+					break;
+					// per-operator latency sampling
+				case 's': k = j + 1; cmdLineTempCount = 0; strcpy(cmdLineTemp, "2");
+					while (argv[i][k] != '\0' && k < sizeof(cmdLineTemp))
+					{
+						// no more numbers, finish
+						if (((argv[i][k] < '0') || (argv[i][k] > '9')) && argv[i][k] != '.')
+							break;
+						k++;
+						cmdLineTempCount++;
+					}
+					if (cmdLineTempCount == 0)
+						usage(argv[0], "Cannot parse -s argument");
+					try {
+						SPBench::setSampling(atof(argv[i] + j + 1));
+					}
+					catch (const std::invalid_argument& e) {
+						std::cerr << "exception: " << e.what() << std::endl;
+						exit(1);
+					}
+					j += cmdLineTempCount;
+					break;
 				case 'u': k = j + 1; cmdLineTempCount = 0; strcpy(cmdLineTemp, "2");
 					while (argv[i][k] != '\0' && k < sizeof(cmdLineTemp))
 					{
@@ -1795,6 +2149,8 @@ int bzip2_main(int argc, char* argv[])
 				case 'l': Metrics::enable_print_latency(); break;
 				case 'L': Metrics::enable_latency_to_file(); break;
 				case 'T': Metrics::enable_throughput(); break;
+				case 'O': SPBench::enable_open_loop(); break;
+				case 'U': SPBench::setOrdered(false); break;
 				case 'r': Metrics::enable_upl(); break;
 				case 'c': OutputStdOut = 1; break;
 				case 'X': force = 1; ForceOverwrite = 1; break;
@@ -1832,8 +2188,22 @@ int bzip2_main(int argc, char* argv[])
 		}
 	} /* for */
 
+	// the blocks of the output file must be written in the input order
+	if (!SPBench::isOrdered(true))
+	{
+		fprintf(stderr, "Bzip2: the output must be ordered, ignoring the unordered mode (-U)\n");
+		SPBench::setOrdered(true);
+	}
+
+	global_decomp = decompress; // operator names depend on it
 	set_operators_name();
 	Metrics::enable_latency();
+	// one item per batch in flight, Source::op grows it for the tuned limit
+	item_pool.reserve(SPBench::getQueueCapacity() > 0 ? SPBench::getQueueCapacity() : nthreads*10);
+
+	// replay a captured operator in isolation, no input files involved
+	if (replayFilename != NULL)
+		return replay_main(replayFilename, replayRounds);
 
 	if (FileListCount == 0)
 	{
@@ -2388,6 +2758,15 @@ int bzip2_main(int argc, char* argv[])
 	if (QuietMode != 1)
 		fprintf(stderr, "\n     Wall Clock: %f seconds\n", timeCalc);
 
+	item_pool.print_stats();
+
+	if (capture_file != NULL)
+	{
+		if (ftell(capture_file) == 0)
+			fprintf(stderr, "Bzip2: *WARNING: No batches captured by this benchmark.\n");
+		fclose(capture_file);
+	}
+
 	return errLevel;
 }
 
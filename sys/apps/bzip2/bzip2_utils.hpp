@@ -116,6 +116,7 @@
 #define BZIP2_U
 
 #include <vector>
+#include <map>
 #include <string>
 #include <sys/stat.h>
 #include <errno.h>
@@ -234,18 +235,27 @@ struct data{
 
 struct item_data{
 	int index;
+	OFF_T offset; // position of the block in the input file, used by read_block()
 	OFF_T buffSize;
 	char *FileData;
 	char *CompDecompData;
 
 	item_data():
 		index(0),
+		offset(0),
 		buffSize(0),
 		FileData(NULL),
 		CompDecompData(NULL)
 	{}
 };
 
+/* Benchmarks with a separate Read stage set it before bzip2_main().
+ * The sources then only split the input into blocks and
+ * read_block() loads each one, so reads can run in parallel.
+ */
+extern bool deferred_read;
+void read_block(item_data &item);
+
 class Item : public Batch{
 public:
 	std::vector<item_data> item_batch;
@@ -253,8 +263,25 @@ public:
 	Item():Batch(NUMBER_OF_OPERATORS){};
 
 	~Item(){}
+
+	void recycle(){
+		Batch::recycle();
+		item_batch.clear();
+	}
 };
 
+extern ItemPool<Item> item_pool;
+
+/* Operator isolation harness (--capture=<file> and --replay=<file>).
+ * Operators register themselves to be replayed and write the batches
+ * entering them to the capture file (see templates/operators/include).
+ * The n-source versions (bzip2_utils_ns) do not support them.
+ */
+typedef void (*replay_operator_t)(Item &item);
+bool register_replay_operator(const std::string &name, replay_operator_t op);
+extern FILE * capture_file;
+void capture_batch(const std::string &operator_name, const Item &item);
+
 class Source{
 public:
 	static long source_item_timestamp;
@@ -198,6 +198,9 @@ void Source::printStatus(){
 	else
 		std::cout << "    Input frequency: " << sourceFrequency << " items per second" << std::endl;
 
+	if(sourceFreqPatt.pattern != "none")
+		std::cout << "  Frequency pattern: " << sourceFreqPatt.pattern << std::endl;
+
 	if(SPBench::memory_source_is_enabled())
 		std::cout << "In-memory execution: enabled" << std::endl;
 	std::cout << "\n###############################################" << std::endl;
@@ -219,6 +222,8 @@ void end_bench(){
 }
 
 bool Source::source_comp(){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	IO_data_vec[sourceId].hOutfile = 1;  // default to stdout
 
@@ -295,14 +300,15 @@ bool Source::source_comp(){
 		}
 
 		// frequency control mechanism
-		item_frequency_control(source_item_timestamp, sourceFrequency);
+		frequencyControl(source_item_timestamp);
 
 		item.timestamp = source_item_timestamp = current_time_usecs();
 		unsigned long batch_elapsed_time = source_item_timestamp;
 
 		volatile unsigned long latency_op;
 		item.timestamp = current_time_usecs();
-		if(Metrics::latency_is_enabled()){
+		item.sampled = sample_batch(sourceSampling);
+		if(Metrics::operator_latency_is_enabled(item)){
 			latency_op = current_time_usecs();
 		}
 
@@ -380,7 +386,7 @@ bool Source::source_comp(){
 			break;
 		}
 
-		if(Metrics::latency_is_enabled()){
+		if(Metrics::operator_latency_is_enabled(item)){
 			item.latency_op.push_back(current_time_usecs() - latency_op);
 		}
 
@@ -398,12 +404,14 @@ bool Source::source_comp(){
 }
 
 void Sink::sink_c(Item &item){
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 
 	if(item.empty())
 		return;
 
 	volatile unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}
 
@@ -446,7 +454,9 @@ void Sink::sink_c(Item &item){
 	if(Metrics::latency_is_enabled()){
 
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		volatile unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		metrics_vec[item.sourceId].global_latency_acc += total_item_latency; // to compute real time average latency
@@ -460,6 +470,9 @@ void Sink::sink_c(Item &item){
 		metrics_vec[item.sourceId].stop_throughput_clock = current_time_sink;
 		item.latency_op.clear();
 	}
+	else if(Metrics::throughput_is_enabled()){
+		metrics_vec[item.sourceId].stop_throughput_clock = current_time_usecs();
+	}
 }
 
 int direct_compress()
@@ -474,6 +487,8 @@ int direct_compress()
 
 
 void Source::source_decomp(){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	char bz2Header[] = {"BZh91AY&SY"};  // for 900k BWT block size
 	blockNum = 0;
@@ -678,14 +693,15 @@ void Source::source_decomp(){
 		}
 
 		// frequency control mechanism
-		item_frequency_control(source_item_timestamp, sourceFrequency);
+		frequencyControl(source_item_timestamp);
 
 		item.timestamp = source_item_timestamp = current_time_usecs();
 		unsigned long batch_elapsed_time = source_item_timestamp;
 		
 		volatile unsigned long latency_op;
 		item.timestamp = current_time_usecs();
-		if(Metrics::latency_is_enabled()){
+		item.sampled = sample_batch(sourceSampling);
+		if(Metrics::operator_latency_is_enabled(item)){
 			latency_op = current_time_usecs();
 		}
 
@@ -804,9 +820,9 @@ void Source::source_decomp(){
 		}
 
 		// frequency control mechanism
-		item_frequency_control(item.timestamp, sourceFrequency);
+		frequencyControl(item.timestamp);
 
-		if(Metrics::latency_is_enabled()){
+		if(Metrics::operator_latency_is_enabled(item)){
 			item.latency_op.push_back(current_time_usecs() - latency_op);
 		}
 		
@@ -826,12 +842,14 @@ void Source::source_decomp(){
 }
 
 void Sink::sink_d(Item &item){
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 
 	if(item.empty())
 		return;
 
 	volatile unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}
 	unsigned int num_item = 0;
@@ -875,7 +893,9 @@ void Sink::sink_d(Item &item){
 	if(Metrics::latency_is_enabled()){
 
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		volatile unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		metrics_vec[item.sourceId].global_latency_acc += total_item_latency; // to compute real time average latency
@@ -889,6 +909,9 @@ void Sink::sink_d(Item &item){
 		metrics_vec[item.sourceId].stop_throughput_clock = current_time_sink;
 		item.latency_op.clear();
 	}
+	else if(Metrics::throughput_is_enabled()){
+		metrics_vec[item.sourceId].stop_throughput_clock = current_time_usecs();
+	}
 }
 
 int direct_decompress()
@@ -1273,6 +1296,7 @@ void usage(char* progname, const char *reason)
 	fprintf(stderr, " -l       : print average latency results\n");
 	fprintf(stderr, " -L       : store individual latency values into a file\n");
 	fprintf(stderr, " -T       : print average throughput results\n");
+	fprintf(stderr, " -s#      : where # is n or a rate. Per-operator latency of one batch every n batches, or of each batch with probability rate (0-1)\n");
 	fprintf(stderr, " -u       : print memory consumption results generated by UPL library\n");
 	fprintf(stderr, " -X       : overwrite existing output file\n");
 	fprintf(stderr, " -h       : print this help message\n");
@@ -1631,6 +1655,28 @@ int bzip2_main(int argc, char* argv[])
 						j += cmdLineTempCount;
 						break;
 
+					// per-operator latency sampling
+					case 's': k = j + 1; cmdLineTempCount = 0; strcpy(cmdLineTemp, "2");
+						while (argv[i][k] != '\0' && k < sizeof(cmdLineTemp))
+						{
+							// no more numbers, finish
+							if (((argv[i][k] < '0') || (argv[i][k] > '9')) && argv[i][k] != '.')
+								break;
+							k++;
+							cmdLineTempCount++;
+						}
+						if (cmdLineTempCount == 0)
+							usage(argv[0], "Cannot parse -s argument");
+						try {
+							SPBench::setSampling(atof(argv[i] + j + 1));
+						}
+						catch (const std::invalid_argument& e) {
+							std::cerr << "exception: " << e.what() << std::endl;
+							exit(1);
+						}
+						j += cmdLineTempCount;
+						break;
+
 					//block size
 					case 'Q': k = j+1; cmdLineTempCount = 0; strcpy(cmdLineTemp, "9"); blockSize = 900000;
 						  while (argv[i][k] != '\0' && k < sizeof(cmdLineTemp))
@@ -1692,6 +1738,11 @@ int bzip2_main(int argc, char* argv[])
 						  SPBench::setArg(cmdLineTemp);
 						  j += cmdLineTempCount;
 						  break;
+					// each source has its own stream, there is no shared in-flight limit or queue to set
+					case 'A':
+					case 'S':
+						fprintf(stderr,"Bzip2: *ERROR: -%c is not available in the multi-source versions!  Aborting...\n", argv[i][j]);
+						return 1;
 					case 'h': usage(argv[0], "HELP"); break;
 					case 'd': decompress = 1; break;
 					case 'I': SPBench::enable_memory_source(); break; // optimized_memory = true;
@@ -32,6 +32,7 @@
 **/
 
 #include <ferret_utils.hpp>
+#include <map>
 
 namespace spb{
 void input_parser(char * argv);
@@ -66,21 +67,472 @@ int vecset_dist_id = 0;
 std::vector<item_data*> ret_in_memory_vector;
 int ret_cass;
 
-struct item_data *file_helper (const char *);
+struct item_data *file_helper (const char *, batch_arena *);
 void push_dir(const char *);
 void scan(const char *);
 
 bool stream_end = false;
 
-struct item_data *file_helper (const char *file)
+ItemPool<Item> item_pool;
+
+/* Binary result sink (-o, --binary-output).
+ * The sink appends one record per query to a large buffer:
+ *   uint32 name size | name | uint32 entries | entries x cass_list_entry_t
+ * and a writer thread writes full buffers to the file, so the serial sink
+ * only copies memory. end_bench() formats the records into the usual text
+ * output (format_binary_output) after the measurements.
+ */
+class BinaryResultWriter{
+public:
+	static const size_t buffer_capacity = 4 << 20;
+
+	void open(const std::string &file_name){
+		file = fopen(file_name.c_str(), "wb");
+		assert(file != NULL);
+		active.reserve(buffer_capacity);
+		done = false;
+		writer = std::thread(&BinaryResultWriter::writer_loop, this);
+	}
+
+	void append(const void *data, size_t size){
+		const char *bytes = (const char *) data;
+		active.insert(active.end(), bytes, bytes + size);
+		if(active.size() >= buffer_capacity) flush();
+	}
+
+	void close(){
+		flush();
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done = true;
+			cond.notify_all();
+		}
+		writer.join();
+		fclose(file);
+	}
+
+private:
+	FILE *file;
+	std::vector<char> active;
+	std::vector<char> pending;
+	bool done;
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::thread writer;
+
+	// hands the active buffer to the writer, waiting only while it still writes the previous one
+	void flush(){
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this]{ return pending.empty(); });
+		pending.swap(active);
+		cond.notify_all();
+	}
+
+	void writer_loop(){
+		std::unique_lock<std::mutex> lock(mutex);
+		while(1){
+			cond.wait(lock, [this]{ return !pending.empty() || done; });
+			if(pending.empty()) break;
+			lock.unlock();
+			fwrite(pending.data(), 1, pending.size(), file);
+			lock.lock();
+			pending.clear();
+			cond.notify_all();
+		}
+	}
+};
+
+bool binary_output = false;
+std::string binary_output_file;
+BinaryResultWriter result_writer;
+
+void write_binary_result(struct item_data *ret){
+	// query name without its path, as in the text output
+	const char *name = strrchr(ret->first.rank.name, '/');
+	name = (name != NULL) ? name + 1 : ret->first.rank.name;
+	uint32_t name_size = strlen(name);
+	uint32_t entries = ret->first.rank.result.u.list.len;
+	result_writer.append(&name_size, sizeof(name_size));
+	result_writer.append(name, name_size);
+	result_writer.append(&entries, sizeof(entries));
+	result_writer.append(ret->first.rank.result.u.list.data, entries * sizeof(cass_list_entry_t));
+}
+
+/**
+ * Format binary output
+ *
+ * Writes the records of a binary result file as the text output of the sink
+ * (the same content, so it can be checked with md5).
+ *
+ * @param file_name binary result file
+ * @param out text output
+ * @return nothing.
+ */
+void format_binary_output(const std::string &file_name, FILE *out){
+	FILE *in = fopen(file_name.c_str(), "rb");
+	assert(in != NULL);
+	uint32_t name_size, entries;
+	std::vector<char> name;
+	std::vector<cass_list_entry_t> list;
+	while(fread(&name_size, sizeof(name_size), 1, in) == 1){
+		name.resize(name_size + 1);
+		if(fread(name.data(), 1, name_size, in) != name_size || fread(&entries, sizeof(entries), 1, in) != 1) break;
+		name[name_size] = 0;
+		list.resize(entries);
+		if(fread(list.data(), sizeof(cass_list_entry_t), entries, in) != entries) break;
+
+		fprintf(out, "queries/%s", name.data());
+		for(uint32_t i = 0; i < entries; i++){
+			char *obj = NULL;
+			if (list[i].dist == DBL_MAX) continue;
+			cass_map_id_to_dataobj(query_table->map, list[i].id, &obj);
+			assert(obj != NULL);
+			fprintf(out, "\t%s:%g", obj, list[i].dist);
+		}
+		fprintf(out, "\n");
+	}
+	fclose(in);
+}
+
+// blocks of the batch arenas, large enough for the result lists of an image
+unsigned long arena_block_size = 1 << 16;
+
+void *arena_alloc(batch_arena *arena, size_t size){
+	std::lock_guard<std::mutex> lock(arena->mutex);
+	void *data = memarenamalloc(arena->arena, size);
+	assert(data != NULL);
+	return data;
+}
+
+void arena_list_init(batch_arena *arena, cass_list_t &list, cass_size_t size){
+	list.inc = ARRAY_DEFAULT_INC;
+	list.size = size;
+	list.len = 0;
+	list.data = (cass_list_entry_t *) arena_alloc(arena, size * sizeof(cass_list_entry_t));
+}
+
+/**
+ * Result alloc list
+ *
+ * Same as cass_result_alloc_list(), but the lists of items with a batch
+ * arena come from it. Query with CASS_RESULT_USERMEM to keep them.
+ *
+ * @param item item owning the result
+ * @return 0.
+ */
+int result_alloc_list(item_data &item, cass_result_t *result, cass_size_t num_regions, cass_size_t topk){
+	if(item.arena == NULL)
+		return cass_result_alloc_list(result, num_regions, topk);
+
+	memset(result, 0, sizeof *result);
+	if(num_regions == 0){
+		result->flags |= CASS_RESULT_LIST;
+		arena_list_init(item.arena, result->u.list, topk);
+	} else {
+		result->flags |= CASS_RESULT_LISTS;
+		result->u.lists.inc = ARRAY_DEFAULT_INC;
+		result->u.lists.size = result->u.lists.len = num_regions;
+		result->u.lists.data = (cass_list_t *) arena_alloc(item.arena, num_regions * sizeof(cass_list_t));
+		for(cass_size_t i = 0; i < num_regions; i++)
+			arena_list_init(item.arena, result->u.lists.data[i], topk);
+	}
+	return 0;
+}
+
+// results allocated from a batch arena are released with it
+void result_free(item_data &item, cass_result_t *result){
+	if(item.arena == NULL)
+		cass_result_free(result);
+}
+
+/* Candidates of the rank queries, for the report at the end:
+ * evaluated -- entries of the candidate lists (EMD distances computed)
+ * fetched   -- distinct candidates of each batch (vector sets fetched) */
+std::atomic<unsigned long> rank_queries(0);
+std::atomic<unsigned long> rank_candidates_evaluated(0);
+std::atomic<unsigned long> rank_candidates_fetched(0);
+
+/**
+ * Rank batch query
+ *
+ * Runs the rank queries prepared by rank_op() for items[0..n) with a single
+ * cass_table_batch_query(), so a candidate shared by several queries of the
+ * batch is fetched once from the database and its distances to all of them
+ * are computed together. Then releases the candidate lists and the query
+ * datasets of the items.
+ *
+ * @param items items of the batch
+ * @param n number of items
+ */
+void rank_batch_query(item_data **items, unsigned int n){
+	std::vector<cass_query_t *> queries(n);
+	std::vector<cass_result_t *> results(n);
+	std::vector<cass_vecset_id_t> ids;
+
+	for(unsigned int i = 0; i < n; i++){
+		queries[i] = &items[i]->first.rank.query;
+		results[i] = &items[i]->first.rank.result;
+		ARRAY_BEGIN_FOREACH(queries[i]->candidate->u.list, cass_list_entry_t cand){
+			if(cand.id != CASS_ID_MAX) ids.push_back(cand.id);
+		} ARRAY_END_FOREACH;
+	}
+	rank_queries += n;
+	rank_candidates_evaluated += ids.size();
+	std::sort(ids.begin(), ids.end());
+	rank_candidates_fetched += std::unique(ids.begin(), ids.end()) - ids.begin();
+
+	cass_table_batch_query(query_table, n, queries.data(), results.data());
+
+	for(unsigned int i = 0; i < n; i++){
+		cass_result_free(queries[i]->candidate);
+		free(queries[i]->candidate);
+		cass_dataset_release(queries[i]->dataset);
+	}
+}
+
+FILE * capture_file = NULL;
+static const char capture_magic[] = "SPBCAP01";
+
+// function-local, so operators can register from static initializers
+std::map<std::string, replay_operator_t> &replay_operators(){
+	static std::map<std::string, replay_operator_t> operators;
+	return operators;
+}
+
+bool register_replay_operator(const std::string &name, replay_operator_t op){
+	replay_operators()[name] = op;
+	return true;
+}
+
+/**
+ * Capture batch
+ *
+ * Writes a batch entering an operator to the capture file.
+ * Batches are written in the order they enter the operator, which may differ
+ * from the stream order in the parallel versions.
+ * Format: magic, operator name, then for each batch its size and, for each
+ * item, index, name, the query dataset (header, vector sets and vectors)
+ * and the candidate lists of the vectorization, which is what Rank reads.
+ *
+ * @param operator_name operator receiving the batch
+ * @param item batch to be written
+ * @return nothing.
+ */
+void capture_batch(const std::string &operator_name, const Item &item){
+	// parallel versions capture from several replicas at a time
+	static std::mutex capture_mutex;
+	std::lock_guard<std::mutex> lock(capture_mutex);
+	static bool header = false;
+	if(!header){
+		unsigned int name_size = operator_name.size();
+		fwrite(capture_magic, 1, sizeof(capture_magic), capture_file);
+		fwrite(&name_size, sizeof(name_size), 1, capture_file);
+		fwrite(operator_name.c_str(), 1, name_size, capture_file);
+		header = true;
+	}
+	int batch_size = item.batch_size;
+	fwrite(&batch_size, sizeof(batch_size), 1, capture_file);
+	for(int i = 0; i < batch_size; i++){
+		const item_data &data = *item.item_batch[i];
+		const cass_dataset_t &ds = *data.second.vec.ds;
+		const cass_result_t &result = data.second.vec.result;
+		unsigned int name_size = strlen(data.second.vec.name);
+		fwrite(&data.index, sizeof(data.index), 1, capture_file);
+		fwrite(&name_size, sizeof(name_size), 1, capture_file);
+		fwrite(data.second.vec.name, 1, name_size, capture_file);
+		fwrite(&ds.flags, sizeof(ds.flags), 1, capture_file);
+		fwrite(&ds.vec_size, sizeof(ds.vec_size), 1, capture_file);
+		fwrite(&ds.vec_dim, sizeof(ds.vec_dim), 1, capture_file);
+		fwrite(&ds.num_vecset, sizeof(ds.num_vecset), 1, capture_file);
+		fwrite(&ds.num_vec, sizeof(ds.num_vec), 1, capture_file);
+		fwrite(ds.vecset, sizeof(cass_vecset_t), ds.num_vecset, capture_file);
+		fwrite(ds.vec, ds.vec_size, ds.num_vec, capture_file);
+		fwrite(&result.u.lists.len, sizeof(result.u.lists.len), 1, capture_file);
+		for(cass_size_t l = 0; l < result.u.lists.len; l++){
+			const cass_list_t &list = result.u.lists.data[l];
+			fwrite(&list.len, sizeof(list.len), 1, capture_file);
+			fwrite(list.data, sizeof(cass_list_entry_t), list.len, capture_file);
+		}
+	}
+}
+
+/* Private copy of a captured query: Rank releases the dataset and the
+ * candidate lists it receives */
+static item_data *copy_query(const item_data &from){
+	const cass_dataset_t &ds = from.extract.ds;
+	const cass_result_t &result = from.second.vec.result;
+
+	item_data *data = new item_data();
+	data->index = from.index;
+	data->extract.name = data->second.vec.name = from.second.vec.name; // only read
+	cass_dataset_init(&data->extract.ds, ds.vec_size, ds.vec_dim, ds.flags);
+	cass_dataset_grow(&data->extract.ds, ds.num_vecset, ds.num_vec);
+	if(ds.num_vecset > 0)
+		memcpy(data->extract.ds.vecset, ds.vecset, ds.num_vecset * sizeof(cass_vecset_t));
+	if(ds.num_vec > 0)
+		memcpy(data->extract.ds.vec, ds.vec, ds.num_vec * ds.vec_size);
+	data->extract.ds.num_vecset = ds.num_vecset;
+	data->extract.ds.num_vec = ds.num_vec;
+	data->extract.ds.loaded = ds.loaded;
+	data->second.vec.ds = &data->extract.ds;
+
+	cass_size_t topk = 0;
+	for(cass_size_t l = 0; l < result.u.lists.len; l++)
+		topk = std::max(topk, result.u.lists.data[l].len);
+	cass_result_alloc_list(&data->second.vec.result, result.u.lists.len, topk);
+	for(cass_size_t l = 0; l < result.u.lists.len; l++){
+		cass_list_t &list = data->second.vec.result.u.lists.data[l];
+		list.len = result.u.lists.data[l].len;
+		if(list.len > 0)
+			memcpy(list.data, result.u.lists.data[l].data, list.len * sizeof(cass_list_entry_t));
+	}
+	return data;
+}
+
+/**
+ * Replay
+ *
+ * Loads the batches of a capture file and replays them through the captured
+ * operator alone, with 1, 2, 4, ... up to nthreads independent threads.
+ * Rank reads the database, so it has to be opened with the -i of the capture.
+ *
+ * @param file_name capture file
+ * @param rounds times each thread replays all the batches
+ * @return 0 on success.
+ */
+int replay_main(const char * file_name, unsigned int rounds){
+	FILE * file = fopen(file_name, "rb");
+	if(file == NULL){
+		std::cerr << " Error: could not open capture file " << file_name << std::endl;
+		return 1;
+	}
+
+	char magic[sizeof(capture_magic)];
+	unsigned int name_size = 0;
+	if(fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, capture_magic, sizeof(magic)) != 0
+		|| fread(&name_size, sizeof(name_size), 1, file) != 1 || name_size > 256){
+		std::cerr << " Error: " << file_name << " is not a capture file" << std::endl;
+		fclose(file);
+		return 1;
+	}
+	std::string operator_name(name_size, ' ');
+	if(fread(&operator_name[0], 1, name_size, file) != name_size){
+		std::cerr << " Error: " << file_name << " is not a capture file" << std::endl;
+		fclose(file);
+		return 1;
+	}
+	if(replay_operators().count(operator_name) == 0){
+		std::cerr << " Error: operator " << operator_name << " cannot be replayed by this benchmark" << std::endl;
+		fclose(file);
+		return 1;
+	}
+	replay_operator_t op = replay_operators()[operator_name];
+
+	// load the captured batches
+	std::vector<Item> batches;
+	int batch_size;
+	while(fread(&batch_size, sizeof(batch_size), 1, file) == 1){
+		Item item;
+		item.batch_size = batch_size;
+		for(int i = 0; i < batch_size; i++){
+			item_data *data = new item_data();
+			cass_dataset_t &ds = data->extract.ds;
+			cass_result_t &result = data->second.vec.result;
+			cass_size_t lists = 0;
+			bool ok = fread(&data->index, sizeof(data->index), 1, file) == 1 && fread(&name_size, sizeof(name_size), 1, file) == 1;
+			if(ok){
+				data->extract.name = (char *) calloc(name_size + 1, 1);
+				ok = fread(data->extract.name, 1, name_size, file) == name_size;
+			}
+			if(ok){
+				uint32_t flags;
+				cass_size_t vec_size, vec_dim, num_vecset, num_vec;
+				ok = fread(&flags, sizeof(flags), 1, file) == 1 && fread(&vec_size, sizeof(vec_size), 1, file) == 1
+					&& fread(&vec_dim, sizeof(vec_dim), 1, file) == 1 && fread(&num_vecset, sizeof(num_vecset), 1, file) == 1
+					&& fread(&num_vec, sizeof(num_vec), 1, file) == 1;
+				if(ok){
+					cass_dataset_init(&ds, vec_size, vec_dim, flags);
+					cass_dataset_grow(&ds, num_vecset, num_vec);
+					ds.num_vecset = num_vecset;
+					ds.num_vec = num_vec;
+					ok = fread(ds.vecset, sizeof(cass_vecset_t), num_vecset, file) == num_vecset
+						&& fread(ds.vec, vec_size, num_vec, file) == num_vec
+						&& fread(&lists, sizeof(lists), 1, file) == 1;
+				}
+			}
+			if(ok){
+				cass_result_alloc_list(&result, lists, 0);
+				for(cass_size_t l = 0; l < lists && ok; l++){
+					cass_list_t &list = result.u.lists.data[l];
+					cass_size_t len;
+					ok = fread(&len, sizeof(len), 1, file) == 1;
+					if(ok){
+						list.data = (cass_list_entry_t *) realloc(list.data, len * sizeof(cass_list_entry_t));
+						list.size = list.len = len;
+						ok = fread(list.data, sizeof(cass_list_entry_t), len, file) == len;
+					}
+				}
+			}
+			if(!ok){
+				std::cerr << " Error: truncated capture file " << file_name << std::endl;
+				exit(-1);
+			}
+			data->second.vec.name = data->extract.name;
+			data->second.vec.ds = &ds;
+			item.item_batch.push_back(data);
+		}
+		batches.push_back(item);
+	}
+	fclose(file);
+
+	// each replay ranks private copies of the queries
+	auto prepare = [](const Item &batch){
+		Item item;
+		item.batch_size = batch.batch_size;
+		for(unsigned int i = 0; i < batch.item_batch.size(); i++)
+			item.item_batch.push_back(copy_query(*batch.item_batch[i]));
+		return item;
+	};
+	auto release = [](Item &item){
+		for(unsigned int i = 0; i < item.item_batch.size(); i++){
+			cass_result_free(&item.item_batch[i]->first.rank.result);
+			delete item.item_batch[i];
+		}
+	};
+
+	std::vector<replay_result_t> results;
+	std::vector<unsigned int> thread_counts = replay_thread_counts(nthreads);
+	for(unsigned int i = 0; i < thread_counts.size(); i++)
+		results.push_back(replay_operator(batches, thread_counts[i], rounds, prepare, op, release));
+	print_replay(operator_name, results);
+
+	for(unsigned int b = 0; b < batches.size(); b++){
+		for(unsigned int i = 0; i < batches[b].item_batch.size(); i++){
+			item_data *data = batches[b].item_batch[i];
+			cass_result_free(&data->second.vec.result);
+			cass_dataset_release(&data->extract.ds);
+			free(data->extract.name);
+			delete data;
+		}
+	}
+	return 0;
+}
+
+struct item_data *file_helper (const char *file, batch_arena *arena)
 {
 	int r;
 	struct item_data *data;
 
-	data = (struct item_data *)malloc(sizeof(struct item_data));
-	assert(data != NULL);
-
-	data->first.load.name = strdup(file);
+	if(arena != NULL){
+		data = (struct item_data *)arena_alloc(arena, sizeof(struct item_data));
+		data->first.load.name = (char *)arena_alloc(arena, strlen(file) + 1);
+		strcpy(data->first.load.name, file);
+	} else {
+		data = (struct item_data *)malloc(sizeof(struct item_data));
+		assert(data != NULL);
+		data->first.load.name = strdup(file);
+	}
+	data->arena = arena;
 
 	r = image_read_rgb_hsv(file,
 			&data->first.load.width,
@@ -141,9 +593,16 @@ void set_operators_name(){
 	SPBench::addOperatorName("Sink         ");
 }
 
+/* Long options of the operator isolation harness, out of the range of the short ones */
+enum { OPT_CAPTURE = 256, OPT_REPLAY, OPT_ROUNDS };
+
 void usage(std::string name){
 	fprintf(stderr, "Usage: %s\n", name.c_str());
 	fprintf(stderr, "  -i, --input            \"<db_dir> <table_name> <query_dir> <top_K> <id (optional)>\" (mandatory)\n");
+	fprintf(stderr, "  -o, --binary-output    the sink writes binary records, formatted into the text output at the end\n");
+	fprintf(stderr, "      --capture          <file> write the batches entering the Rank operator to <file>\n");
+	fprintf(stderr, "      --replay           <file> replay the batches of a capture file through the operator alone, with 1 to -t threads (same -i as the capture)\n");
+	fprintf(stderr, "      --rounds           <n> times each thread replays the captured batches (default 1)\n");
 	printGeneralUsage();
 	exit(-1);
 }
@@ -166,13 +625,23 @@ void init_bench(int argc, char *argv[]){
 	}
 	*/
 	SPBench::bench_path = argv[0];
+	std::string replay_file;
+	unsigned int replay_rounds = 1;
 	int opt = 0;
 	int opt_index = 0;
 
 	if(argc < 2) usage(argv[0]);
+
+	// SPBench options plus the ones of ferret
+	std::vector<struct option> ferret_long_opts(long_opts, long_opts + sizeof(long_opts)/sizeof(long_opts[0]) - 1);
+	ferret_long_opts.push_back({"binary-output", NONE, 0, 'o'});
+	ferret_long_opts.push_back({"capture", REQUIRED, 0, OPT_CAPTURE});
+	ferret_long_opts.push_back({"replay", REQUIRED, 0, OPT_REPLAY});
+	ferret_long_opts.push_back({"rounds", REQUIRED, 0, OPT_ROUNDS});
+	ferret_long_opts.push_back({0, 0, 0, 0});
 	
 	try {
-		while ((opt = getopt_long(argc, argv, "i:t:b:B:m:M:f:F:IlLTru:h", long_opts, &opt_index)) != -1) {
+		while ((opt = getopt_long(argc, argv, "i:t:b:B:m:M:f:F:IlLTru:q:A:Os:R:Uoh", ferret_long_opts.data(), &opt_index)) != -1) {
 			switch(opt){
 				case 'i':
 					if(split_string(optarg, ' ').size() < 4) 
@@ -226,9 +695,47 @@ void init_bench(int argc, char *argv[]){
 				case 'r':
 					Metrics::enable_upl();
 					break;
+				case 'q':
+					if (atoi(optarg) <= 0)
+						throw std::invalid_argument("\n ARGUMENT ERROR (-q <queue_capacity>) --> Queue capacity must be an integer value higher than zero!\n");
+					SPBench::setQueueCapacity(atoi(optarg));
+					break;
+				case 'A':
+					if (atof(optarg) < 0.0)
+						throw std::invalid_argument("\n ARGUMENT ERROR (-A <max_latency_ms>) --> Latency constraint can not be negative!\n");
+					SPBench::enable_tuning(atof(optarg));
+					break;
+				case 'O':
+					SPBench::enable_open_loop();
+					break;
+				case 's':
+					SPBench::setSampling(atof(optarg));
+					break;
+				case 'R':
+					SPBench::setRuntimeOptions(optarg);
+					break;
+				case 'U':
+					SPBench::setOrdered(false);
+					break;
 				case 'u':
 					SPBench::setArg(optarg);
 					break;
+				case 'o':
+					binary_output = true;
+					break;
+				case OPT_CAPTURE:
+					capture_file = fopen(optarg, "wb");
+					if (capture_file == NULL)
+						throw std::invalid_argument("\n ERROR in --capture --> Could not create capture file: " + std::string(optarg) + "\n");
+					break;
+				case OPT_REPLAY:
+					replay_file = optarg;
+					break;
+				case OPT_ROUNDS:
+					if (atoi(optarg) < 1)
+						throw std::invalid_argument("\n ARGUMENT ERROR (--rounds <n>) --> Rounds must be an integer value higher than zero!\n");
+					replay_rounds = atoi(optarg);
+					break;
 				case 'h':
 					usage(argv[0]);
 					break;
@@ -258,6 +765,11 @@ void init_bench(int argc, char *argv[]){
 	fout = fopen((prepareOutFileAt("outputs") + "_" + input_id + ".out").c_str(), "w");
 	assert(fout != NULL);
 
+	if(binary_output){
+		binary_output_file = prepareOutFileAt("outputs") + "_" + input_id + ".bin";
+		result_writer.open(binary_output_file);
+	}
+
 	cass_init();
 	ret_cass = cass_env_open(&env, db_dir, 0);
 	if (ret_cass != 0) {
@@ -288,6 +800,17 @@ void init_bench(int argc, char *argv[]){
 
 	image_init(argv[0]);
 
+	// replay a captured operator in isolation, only the database is needed
+	if(!replay_file.empty()){
+		int ret = replay_main(replay_file.c_str(), replay_rounds);
+		cass_env_close(env, 0);
+		exit(ret);
+	}
+
+	// the vectorization result lists are the largest arena allocations
+	while(arena_block_size < MAXR * 2 * top_K * sizeof(cass_list_entry_t) && arena_block_size < (1 << 24))
+		arena_block_size <<= 1;
+
 	scan(query_dir);
 
 	if(SPBench::memory_source_is_enabled()){
@@ -297,7 +820,7 @@ void init_bench(int argc, char *argv[]){
 			bool input_found = false;
 
 			if(m_single_file) {
-				ret = file_helper(m_single_file);
+				ret = file_helper(m_single_file, NULL);
 				m_single_file = NULL;
 				input_found = true;
 			}
@@ -337,7 +860,7 @@ void init_bench(int argc, char *argv[]){
 					break;
 				}
 				if (S_ISREG(st.st_mode)) {
-					ret = file_helper(m_path);
+					ret = file_helper(m_path, NULL);
 					m_path[path_len]=0;
 					input_found = true;
 				} else if (S_ISDIR(st.st_mode)) {
@@ -356,6 +879,8 @@ void init_bench(int argc, char *argv[]){
 
 	set_operators_name();
 	Metrics::enable_latency();
+	// one item per batch in flight, Source::op grows it for the tuned limit
+	item_pool.reserve(SPBench::getQueueCapacity() > 0 ? SPBench::getQueueCapacity() : nthreads*10);
 	
 	if(Metrics::monitoring_thread_is_enabled()){
 		Metrics::start_monitoring();
@@ -402,6 +927,27 @@ void end_bench(){
 			ret_in_memory_vector.erase(ret_in_memory_vector.begin(), ret_in_memory_vector.end());
 	}
 
+	// deferred formatting of the binary results, out of the measured run
+	if(binary_output){
+		result_writer.close();
+		format_binary_output(binary_output_file, fout);
+	}
+
+	if(rank_queries > 0 && SPBench::getBatchSize() > 1){
+		printf("--------------- RANK CANDIDATES ---------------\n\n");
+		printf("\tCandidates evaluated per query = %f\n", (double) rank_candidates_evaluated / rank_queries);
+		printf("\tCandidates fetched per query = %f\n", (double) rank_candidates_fetched / rank_queries);
+		printf("\tShared candidates = %.2f%%\n", rank_candidates_evaluated ? 100.0 * (rank_candidates_evaluated - rank_candidates_fetched) / rank_candidates_evaluated : 0.0);
+		printf("\n-----------------------------------------------\n");
+	}
+
+	item_pool.print_stats();
+
+	if(capture_file != NULL){
+		if(ftell(capture_file) == 0)
+			fprintf(stderr, " Warning: no batches captured by this benchmark.\n");
+		fclose(capture_file);
+	}
 
 	ret_cass = cass_env_close(env, 0);
 	if (ret_cass != 0) {
@@ -419,6 +965,8 @@ void end_bench(){
 long Source::source_item_timestamp = current_time_usecs();
 
 bool Source::op(Item &item){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	//if last batch included the last item, ends computation
 	if(stream_end == true){
@@ -428,11 +976,15 @@ bool Source::op(Item &item){
 	// frequency control mechanism
 	SPBench::item_frequency_control(source_item_timestamp);
 
-	item.timestamp = source_item_timestamp = current_time_usecs();
+	// the clock is read only if the timestamps of the batch are used
+	if(SPBench::source_timing_is_enabled())
+		source_item_timestamp = current_time_usecs();
 	unsigned long batch_elapsed_time = source_item_timestamp;
 	
+	// the batch carries the sampling decision to the operators
+	item.sampled = SPBench::batch_sampling();
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = source_item_timestamp;
 	}
 
@@ -461,12 +1013,14 @@ bool Source::op(Item &item){
 				break;
 			}
 		} else {
+			if(!item.arena)
+				item.arena = std::make_shared<batch_arena>(arena_block_size);
 
 			struct item_data* ret;
 			bool input_found = false;
 
 			if(m_single_file) {
-				ret = file_helper(m_single_file);
+				ret = file_helper(m_single_file, item.arena.get());
 				m_single_file = NULL;
 				input_found = true;
 			}
@@ -507,7 +1061,7 @@ bool Source::op(Item &item){
 					break;
 				}
 				if (S_ISREG(st.st_mode)) {
-					ret = file_helper(m_path);
+					ret = file_helper(m_path, item.arena.get());
 					m_path[path_len]=0;
 					input_found = true;
 				} else if (S_ISDIR(st.st_mode)) {
@@ -532,8 +1086,21 @@ bool Source::op(Item &item){
 		return false;
 	}
 
+	// only emitted batches take an in-flight slot and count in the open-loop schedule
+	unsigned long emission_time = source_item_timestamp;
+	if(SPBench::tuning_is_enabled()){
+		// the tuned limit grows up to the largest capacity asked by the runtime
+		if(Metrics::batch_counter == 0)
+			item_pool.reserve(SPBench::getTuningMaxLimit() + 1);
+		SPBench::in_flight_control();
+		// the wait for a slot is not part of the latency of the batch
+		emission_time = current_time_usecs();
+	}
+	// in open-loop mode the latency counts from the scheduled arrival time
+	item.timestamp = SPBench::item_arrival_time(emission_time);
+
 	//metrics computation
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		item.latency_op.push_back(current_time_usecs() - latency_op);
 	}
 
@@ -543,9 +1110,11 @@ bool Source::op(Item &item){
 }
 
 void Sink::op(Item &item){	
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 	//metrics computation
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}
 
@@ -555,6 +1124,17 @@ void Sink::op(Item &item){
 
 			struct item_data* ret;
 			ret = item.item_batch[num_item];
+
+			if(binary_output){
+				write_binary_result(ret);
+				if(ret->arena == NULL){
+					cass_result_free(&ret->first.rank.result);
+					free(ret->first.rank.name);
+				}
+				num_item++;
+				Metrics::items_at_sink_counter++;
+				continue;
+			}
 			
 			// Removing the full path of each query image from the output file
 			// Removing the varying path allows to run correctness testing using md5 hash
@@ -578,8 +1158,11 @@ void Sink::op(Item &item){
 
 			fprintf(fout, "\n");
 
-			cass_result_free(&ret->first.rank.result);
-			free(ret->first.rank.name);
+			// items of a batch arena are released with the batch
+			if(ret->arena == NULL){
+				cass_result_free(&ret->first.rank.result);
+				free(ret->first.rank.name);
+			}
 			//free(ret);
 		
 			num_item++;
@@ -589,11 +1172,14 @@ void Sink::op(Item &item){
 		Metrics::items_at_sink_counter += item.batch_size;
 	}
 
+	SPBench::in_flight_release(item.timestamp, item.batch_size);
 	Metrics::batches_at_sink_counter++;
 
 	if(Metrics::latency_is_enabled()){
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		Metrics::global_latency_acc += total_item_latency; // to compute inst. average latency
@@ -42,9 +42,12 @@
 #include <stack>
 #include "include/cass.h"
 #include "include/cass_timer.h"
+#include "include/arena.h"
 #include "image/image.h"
 
 #include <spbench.hpp>
+#include <memory>
+#include <algorithm>
 
 #ifdef ENABLE_PARSEC_HOOKS
 #include <hooks.h>
@@ -67,6 +70,7 @@ struct extract_data;
 struct vec_query_data;
 struct rank_data;
 struct item_data;
+struct batch_arena;
 
 void init_bench(int argc, char* argv[]);
 void end_bench();
@@ -128,23 +132,71 @@ struct item_data {
 	} second;
 	struct extract_data extract;
 	unsigned int index;
+	struct batch_arena *arena; // arena of the batch (NULL for in-memory items)
 
 	item_data():
-		index(0)
+		index(0),
+		arena(NULL)
 	{};
 
 	~item_data(){};
 };
 
+/* Items, query names and result lists of a batch are allocated from
+ * the batch arena and released at once when the last copy of the batch is
+ * destroyed (after the Sink), instead of being freed one by one.
+ */
+struct batch_arena {
+	MemArena *arena;
+	std::mutex mutex; // the items of a batch may be processed in parallel (taskloop)
+
+	batch_arena(unsigned long block_size):
+		arena(mkmemarena(NULL, NULL, NULL, block_size))
+	{
+		assert(arena != NULL);
+	};
+
+	~batch_arena(){
+		freememarena(arena);
+	};
+};
+
 class Item : public Batch{
 public:
 	std::vector<item_data*> item_batch;
+	std::shared_ptr<batch_arena> arena;
 
 	Item():Batch(NUMBER_OF_OPERATORS){};
 
 	~Item(){}
+
+	// the blocks of an arena no other copy of the batch holds are reused
+	void recycle(){
+		Batch::recycle();
+		item_batch.clear();
+		if(arena.use_count() == 1)
+			resetmemarena(arena->arena);
+		else
+			arena.reset();
+	}
 };
 
+extern ItemPool<Item> item_pool;
+
+/* Operator isolation harness (--capture=<file> and --replay=<file>).
+ * Operators register themselves to be replayed and write the batches
+ * entering them to the capture file (see templates/operators/include).
+ * The n-source versions (ferret_utils_ns) do not support them.
+ */
+typedef void (*replay_operator_t)(Item &item);
+bool register_replay_operator(const std::string &name, replay_operator_t op);
+extern FILE * capture_file;
+void capture_batch(const std::string &operator_name, const Item &item);
+
+int result_alloc_list(item_data &item, cass_result_t *result, cass_size_t num_regions, cass_size_t topk);
+void result_free(item_data &item, cass_result_t *result);
+void rank_batch_query(item_data **items, unsigned int n);
+
 
 class Source{
 public:
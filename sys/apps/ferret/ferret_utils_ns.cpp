@@ -44,9 +44,13 @@ std::vector<input_data> input_data_vec;
 
 char *extra_params = "-L 8 - T 20";
 
+int decode_workers = DEFAULT_DECODE_WORKERS;
+unsigned int decode_lookahead = 0; // 0: DECODE_LOOKAHEAD images per worker
+
 struct item_data *file_helper (const char *);
 void push_dir(const char *);
 void scan(const char *);
+bool next_file(path_data &, std::string &);
 
 struct item_data *file_helper (const char *file)
 {
@@ -108,6 +112,149 @@ void scan(const char * dir, path_data &path) {
 	}
 }
 
+/* Next regular file of the query directory, depth first. Returns false at the end of the input. */
+bool next_file(path_data &path, std::string &file) {
+	if (path.m_single_file) {
+		file = path.m_single_file;
+		path.m_single_file = NULL;
+		return true;
+	}
+	while (!path.m_dir_stack.empty()) {
+		DIR *pd = path.m_dir_stack.top();
+		struct dirent *ent = NULL;
+		struct stat st;
+		int path_len = strlen(path.m_path);
+
+		ent = readdir(pd);
+		if (ent == NULL) {
+			closedir(pd);
+			path.m_path[path.m_path_stack.top()] = 0;
+			path.m_path_stack.pop();
+			path.m_dir_stack.pop();
+			continue;
+		}
+
+		if((ent->d_name[0] == '.') && ((ent->d_name[1] == 0) || ((ent->d_name[1] == '.') && (ent->d_name[2] == 0)) ) )
+			continue;
+
+		strcat(path.m_path, ent->d_name);
+		if (stat(path.m_path, &st) != 0) {
+			perror("Error:");
+			path.m_path[path_len] = 0;
+			return false;
+		}
+		if (S_ISREG(st.st_mode)) {
+			file = path.m_path;
+			path.m_path[path_len] = 0;
+			return true;
+		} else if (S_ISDIR(st.st_mode)) {
+			path.m_path[path_len] = 0;
+			push_dir(ent->d_name, path);
+		} else
+			path.m_path[path_len] = 0;
+	}
+	return false;
+}
+
+DecodeGroup::DecodeGroup(path_data &path, int nworkers, unsigned int lookahead):
+	path(path),
+	lookahead(lookahead ? lookahead : DECODE_LOOKAHEAD * nworkers),
+	end_of_input(false),
+	stopped(false),
+	images(0),
+	decode_time(0),
+	wait_time(0)
+{
+	for(int i = 0; i < nworkers; i++)
+		workers.push_back(std::thread(&DecodeGroup::worker, this));
+}
+
+struct item_data *DecodeGroup::decode(const std::string &file){
+	unsigned long start = current_time_usecs();
+	struct item_data *data = file_helper(file.c_str());
+	decode_time += current_time_usecs() - start;
+	images++;
+	return data;
+}
+
+void DecodeGroup::worker(){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
+	std::unique_lock<std::mutex> lock(window_mutex);
+	while(1){
+		slot_free.wait(lock, [this]{ return stopped || end_of_input || window.size() < lookahead; });
+		if(stopped || end_of_input)
+			break;
+
+		// the slot keeps the directory order while the images are decoded in parallel
+		std::string file;
+		if(!next_file(path, file)){
+			end_of_input = true;
+			slot_ready.notify_all();
+			slot_free.notify_all();
+			break;
+		}
+		window.push_back({NULL, false});
+		slot &decoded = window.back(); // deque ends never move the other elements
+
+		lock.unlock();
+		struct item_data *data = decode(file);
+		lock.lock();
+
+		decoded.data = data;
+		decoded.ready = true;
+		slot_ready.notify_all();
+	}
+}
+
+/* Next decoded image in directory order, NULL at the end of the input */
+struct item_data *DecodeGroup::next(){
+	unsigned long start = current_time_usecs();
+	if(workers.empty()){
+		std::string file;
+		return (next_file(path, file) ? decode(file) : NULL);
+	}
+
+	std::unique_lock<std::mutex> lock(window_mutex);
+	slot_ready.wait(lock, [this]{ return (!window.empty() && window.front().ready) || (window.empty() && end_of_input); });
+	wait_time += current_time_usecs() - start;
+	if(window.empty())
+		return NULL;
+
+	struct item_data *data = window.front().data;
+	window.pop_front();
+	slot_free.notify_one();
+	return data;
+}
+
+void DecodeGroup::stop(){
+	{
+		std::lock_guard<std::mutex> lock(window_mutex);
+		stopped = true;
+	}
+	slot_free.notify_all();
+	for(auto & t : workers)
+		if(t.joinable()) t.join();
+
+	// images decoded ahead of an early stop
+	for(auto & decoded : window){
+		if(decoded.data == NULL) continue;
+		free(decoded.data->first.load.name);
+		free(decoded.data->first.load.RGB);
+		free(decoded.data->first.load.HSV);
+		free(decoded.data);
+	}
+	window.clear();
+}
+
+decode_stats DecodeGroup::stats(){
+	decode_stats decode;
+	decode.workers = workers.size();
+	decode.images = images;
+	decode.decode_time = decode_time;
+	decode.wait_time = wait_time;
+	return decode;
+}
 
 void set_operators_name(){
 	SPBench::addOperatorName("Source       ");
@@ -131,6 +278,9 @@ inline void usage(std::string name){
 	fprintf(stderr, "\t-m\t: monitors latency, throughput, and CPU and memory usage.\n");
 	fprintf(stderr, "\t-T\t: print average throughput results\n");
 	fprintf(stderr, "\t-r\t: print memory consumption results generated by UPL library\n");
+	fprintf(stderr, "\t-s\t: <n|rate> per-operator latency of one batch every n batches, or of each batch with probability rate (0-1)\n");
+	fprintf(stderr, "\t-D\t: <number_of_decode_workers> per source (default %d, 0: the source decodes the images itself)\n", DEFAULT_DECODE_WORKERS);
+	fprintf(stderr, "\t-W\t: <look_ahead> decoded images kept ahead of each source (default %d per decode worker)\n", DECODE_LOOKAHEAD);
 	fprintf(stderr, "\t-u\t: send a custom argument to be used inside your programm\n");
 	fprintf(stderr, "\t-h\t: print this help message\n");
 	exit(-1);
@@ -157,7 +307,7 @@ void init_bench(int argc, char *argv[]){
 	SPBench::bench_path = argv[0];
 
 	int opt;
-	while ((opt = getopt(argc,argv,"i:t:b:m:B:f:u:IlLTrh")) != EOF){
+	while ((opt = getopt(argc,argv,"i:t:b:m:B:f:u:D:W:IlLTrs:h")) != EOF){
 		switch(opt){
 			case 'i':
 				input_parser(optarg);
@@ -198,6 +348,19 @@ void init_bench(int argc, char *argv[]){
 			case 'r':
 				Metrics::enable_upl();
 				break;
+			case 's':
+				SPBench::setSampling(atof(optarg));
+				break;
+			case 'D':
+				if (atoi(optarg) < 0)
+					throw std::invalid_argument("\n ARGUMENT ERROR (-D <decode_workers>) --> The number of decode workers must be zero or higher!\n");
+				decode_workers = atoi(optarg);
+				break;
+			case 'W':
+				if (atoi(optarg) <= 0)
+					throw std::invalid_argument("\n ARGUMENT ERROR (-W <look_ahead>) --> The look-ahead must be an integer value higher than zero!\n");
+				decode_lookahead = atoi(optarg);
+				break;
 			case 'u':
 				SPBench::setArg(optarg);
 				break;
@@ -239,8 +402,15 @@ void Source::printStatus(){
 	else
 		std::cout << "    Input frequency: " << sourceFrequency << " items per second" << std::endl;
 
+	if(sourceFreqPatt.pattern != "none")
+		std::cout << "  Frequency pattern: " << sourceFreqPatt.pattern << std::endl;
+
 	if(SPBench::memory_source_is_enabled())
 		std::cout << "In-memory execution: enabled" << std::endl;
+	if(decode_workers == 0)
+		std::cout << "     Decode workers: 0 (decoding in the source)" << std::endl;
+	else
+		std::cout << "     Decode workers: " << decode_workers << " (look-ahead of " << (decode_lookahead ? decode_lookahead : DECODE_LOOKAHEAD * decode_workers) << " images)" << std::endl;
 	std::cout << "\n###############################################" << std::endl;
 }
 
@@ -290,12 +460,29 @@ void end_bench(){
 		image_cleanup();
 		fclose(element.outFileData.fout);
 	}
+
+	// decoding runs beside the pipeline, so it is reported apart from the operators
+	printf("--------------- SOURCE DECODING ---------------\n\n");
+	for (auto & element : IO_data_vec){
+		decode_stats &decode = element.decode;
+		printf("  %s (%d decode worker(s))\n", element.inputData.inputId.c_str(), decode.workers);
+		printf("\tDecoded images = %lu\n", decode.images);
+		printf("\tDecode time per image (ms) = %f\n", decode.images ? decode.decode_time / 1000.0 / decode.images : 0.0);
+		printf("\tTotal decode time (s) = %f\n", decode.decode_time / 1000000.0);
+		if(decode.workers > 0)
+			printf("\tSource wait for decoding (s) = %f\n\n", decode.wait_time / 1000000.0);
+		else
+			printf("\n");
+	}
+	printf("-----------------------------------------------\n");
 	compute_metrics();
 }
 
 std::mutex source_init_mutex;
 
 void Source::source_op(){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	int rett;
 	path_data pathInfo;
@@ -345,71 +532,16 @@ void Source::source_op(){
 
 	IO_data_vec[sourceId].outFileData.fout = fout;
 
+	// decode workers of this source, reading the query images ahead of it
+	DecodeGroup decoder(pathInfo, decode_workers, decode_lookahead);
+
 	bool end_of_input = false;
 
 	// load data to the memory if in-memory is enabled
 	if(SPBench::memory_source_is_enabled()){
-		while(1){
-
-			struct item_data* ret;
-			bool input_found = false;
-
-			if(pathInfo.m_single_file) {
-				ret = file_helper(pathInfo.m_single_file);
-				pathInfo.m_single_file = NULL;
-				input_found = true;
-			}
-
-			if(pathInfo.m_dir_stack.empty()) {
-				end_of_input = true;
-				break;
-			}
-
-			while(input_found!=true) {
-				DIR *pd = pathInfo.m_dir_stack.top();
-				struct dirent *ent = NULL;
-				int res = 0;
-				struct stat st;
-				int path_len = strlen(pathInfo.m_path);
-
-				ent = readdir(pd);
-				if (ent == NULL) {
-					closedir(pd);
-					pathInfo.m_path[pathInfo.m_path_stack.top()] = 0;
-					pathInfo.m_path_stack.pop();
-					pathInfo.m_dir_stack.pop();
-					if(pathInfo.m_dir_stack.empty()) {
-						end_of_input = true;
-						break;
-					}
-				}
-
-				if((ent->d_name[0] == '.') && ((ent->d_name[1] == 0) || ((ent->d_name[1] == '.') && (ent->d_name[2] == 0)) ) )
-					continue;
-
-				strcat(pathInfo.m_path, ent->d_name);
-				res = stat(pathInfo.m_path, &st);
-				if (res != 0) {
-					perror("Error:");
-					end_of_input = true;
-					break;
-				}
-				if (S_ISREG(st.st_mode)) {
-					ret = file_helper(pathInfo.m_path);
-					pathInfo.m_path[path_len]=0;
-					input_found = true;
-				} else if (S_ISDIR(st.st_mode)) {
-					pathInfo.m_path[path_len]=0;
-					push_dir(ent->d_name, pathInfo);
-				} else
-					pathInfo.m_path[path_len]=0;
-			}
-		
-			if(end_of_input == true) break;
-
+		struct item_data* ret;
+		while((ret = decoder.next()) != NULL)
 			IO_data_vec[sourceId].mem_data_vec.push_back(ret);
-		}
-		end_of_input = false;
 	}
 
 	// generate items
@@ -429,14 +561,15 @@ void Source::source_op(){
 		}
 
 		// frequency control mechanism
-		item_frequency_control(source_item_timestamp, sourceFrequency);
+		frequencyControl(source_item_timestamp);
 
 		item.timestamp = source_item_timestamp = current_time_usecs();
 		unsigned long batch_elapsed_time = source_item_timestamp;
 		
 		unsigned long latency_op;
 		item.timestamp = current_time_usecs();
-		if(Metrics::latency_is_enabled()){
+		item.sampled = sample_batch(sourceSampling);
+		if(Metrics::operator_latency_is_enabled(item)){
 			latency_op = current_time_usecs();
 		}
 
@@ -463,65 +596,12 @@ void Source::source_op(){
 				}
 			} else {
 
-				struct item_data* ret;
-
-				bool input_found = false;
-
-				if(pathInfo.m_single_file) {
-					ret = file_helper(pathInfo.m_single_file);
-					pathInfo.m_single_file = NULL;
-					input_found = true;
-				}
-
-				if(pathInfo.m_dir_stack.empty()) {
+				struct item_data* ret = decoder.next();
+				if(ret == NULL){
 					end_of_input = true;
 					break;
 				}
 
-				while(input_found!=true) {
-					DIR *pd = pathInfo.m_dir_stack.top();
-					struct dirent *ent = NULL;
-					int res = 0;
-					struct stat st;
-					int path_len = strlen(pathInfo.m_path);
-
-					ent = readdir(pd);
-					if (ent == NULL) {
-						closedir(pd);
-						pathInfo.m_path[pathInfo.m_path_stack.top()] = 0;
-						pathInfo.m_path_stack.pop();
-						pathInfo.m_dir_stack.pop();
-						if(pathInfo.m_dir_stack.empty()) {
-							end_of_input = true;
-							break;
-						}
-					}
-
-					if((ent->d_name[0] == '.') && ((ent->d_name[1] == 0) || ((ent->d_name[1] == '.') && (ent->d_name[2] == 0)) ) )
-						continue;
-
-					strcat(pathInfo.m_path, ent->d_name);
-					res = stat(pathInfo.m_path, &st);
-					if (res != 0) {
-						perror("Error:");
-						end_of_input = true;
-						break;
-					}
-					if (S_ISREG(st.st_mode)) {
-						ret = file_helper(pathInfo.m_path);
-						pathInfo.m_path[path_len]=0;
-						input_found = true;
-					} else if (S_ISDIR(st.st_mode)) {
-						pathInfo.m_path[path_len]=0;
-						push_dir(ent->d_name, pathInfo);
-					} else
-						pathInfo.m_path[path_len]=0;
-				}
-
-				if(end_of_input == true){
-					break;
-				}
-
 				ret->sourceId = getSourceId();
 				item.item_batch.push_back(ret);
 			}		
@@ -537,7 +617,7 @@ void Source::source_op(){
 			break;
 		}
 		
-		if(Metrics::latency_is_enabled()){
+		if(Metrics::operator_latency_is_enabled(item)){
 			item.latency_op.push_back(current_time_usecs() - latency_op);
 		}
 
@@ -551,18 +631,22 @@ void Source::source_op(){
 		metrics_vec[sourceId].global_item_counter = sourceItemCounter;
 	}
 
+	decoder.stop();
+	IO_data_vec[sourceId].decode = decoder.stats();
 	return;
 }
 
 
 void Sink::op(Item &item){
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 
 	if(item.empty())
 		return;
 
 	//metrics computation
 	volatile unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}
 
@@ -615,7 +699,9 @@ void Sink::op(Item &item){
 	if(Metrics::latency_is_enabled()){
 
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 		
 		volatile unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		metrics_vec[item.sourceId].global_latency_acc += total_item_latency; // to compute real time average latency
@@ -629,6 +715,9 @@ void Sink::op(Item &item){
 		metrics_vec[item.sourceId].stop_throughput_clock = current_time_sink;
 		item.latency_op.clear();
 	}
+	else if(Metrics::throughput_is_enabled()){
+		metrics_vec[item.sourceId].stop_throughput_clock = current_time_usecs();
+	}
 }
 
 } //end of namespace spb
\ No newline at end of file
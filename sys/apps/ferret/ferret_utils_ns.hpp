@@ -47,6 +47,12 @@
 #include "image/image.h"
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 #include <sys/time.h>
 
@@ -62,6 +68,9 @@
 
 #define NUMBER_OF_OPERATORS 6
 
+#define DEFAULT_DECODE_WORKERS  2
+#define DECODE_LOOKAHEAD        4 // decoded images kept ahead of the source, per decode worker
+
 namespace spb{
 class Item;
 class Source;
@@ -94,6 +103,9 @@ extern cass_table_t *query_table;
 extern int vec_dist_id;
 extern int vecset_dist_id;
 
+extern int decode_workers;
+extern unsigned int decode_lookahead;
+
 struct path_data{
 	char m_path[BUFSIZ];
 	const char *m_single_file;
@@ -187,10 +199,62 @@ struct input_data{
 	{}
 };
 
+struct decode_stats {
+	int workers;
+	unsigned long images;
+	unsigned long decode_time; // usecs spent decoding, summed over the workers
+	unsigned long wait_time; // usecs the source waited for decoded images
+	decode_stats():
+		workers(0),
+		images(0),
+		decode_time(0),
+		wait_time(0)
+	{}
+};
+
 struct IO_data_struct {
 	input_data inputData;
 	output_data outFileData;
 	std::vector<item_data*> mem_data_vec;	
+	decode_stats decode;
+};
+
+/* Decode workers of a source. Each worker takes the next image of the query
+ * directory, decodes it and leaves it in its slot of a look-ahead window of
+ * bounded size, which the source consumes in directory order. With no
+ * workers the source decodes the images itself.
+ */
+class DecodeGroup{
+	private:
+		struct slot{
+			struct item_data *data;
+			bool ready;
+		};
+
+		path_data &path;
+		std::deque<slot> window;
+		unsigned int lookahead;
+		bool end_of_input;
+		bool stopped;
+		std::mutex window_mutex;
+		std::condition_variable slot_ready;
+		std::condition_variable slot_free;
+		std::vector<std::thread> workers;
+
+		std::atomic<unsigned long> images;
+		std::atomic<unsigned long> decode_time;
+		unsigned long wait_time;
+
+		struct item_data *decode(const std::string &file);
+		void worker();
+
+	public:
+		DecodeGroup(path_data &path, int nworkers, unsigned int lookahead);
+		~DecodeGroup(){ stop(); }
+
+		struct item_data *next();
+		void stop();
+		decode_stats stats();
 };
 
 class Item : public Batch, public NsItem{
@@ -8,6 +8,7 @@ typedef struct MemArena MemArena;
 
 MemArena	*mkmemarena(void *(*)(size_t), void *(*)(void*, size_t), void (*)(void*), unsigned long);
 void		freememarena(MemArena*);
+void		resetmemarena(MemArena*);
 void		memarenastats(MemArena*);
 void		*memarenamalloc(MemArena*, unsigned long);
 #if defined(__cplusplus)
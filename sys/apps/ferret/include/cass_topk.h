@@ -143,6 +143,23 @@ void prefix##_qsort(type* numbers, cass_size_t array_size) {				\
 		 { stmt; }				\
 	 } while(0)
 
+/* Insert into a top-k array kept in descending order (the largest key at [0],
+   as TOPK_INSERT_MIN_UNIQ does) an element the caller knows is not in the
+   array yet.  After the early reject the position is counted without branches,
+   which suits the small k of the LSH queries. */
+#define TOPK_INSERT_MIN_SORTED_DO(array, key, k, el, stmt) \
+	 do {						\
+	 	int iiii, jjjj;				\
+	 	if ((el).key > (array)[0].key) break;	\
+	 	iiii = 0;				\
+	 	for (jjjj = 0; jjjj < (k); jjjj++)	\
+	 		iiii += ((array)[jjjj].key >= (el).key); \
+		for (jjjj = 0; jjjj < iiii-1; jjjj++)	\
+			(array)[jjjj] = (array)[jjjj+1];\
+		(array)[jjjj] = el;			\
+		 { stmt; }				\
+	 } while(0)
+
 #define TOPK_SORT_MIN(array, type, key, k)		\
 	do {						\
  		int __last = k;				\
@@ -169,6 +186,85 @@ void prefix##_qsort(type* numbers, cass_size_t array_size) {				\
 	 } while (0)
 
 
+/* Typed selection over an array of structures ordered by the field 'key'.
+   TOPK_SELECT_GENERATE(prefix, type, key) defines
+	prefix_sort(array, n):		sort ascending (quicksort, insertion sort
+					for short ranges);
+	prefix_select(array, n, k):	move the k smallest elements to
+					array[0..k), partial quickselect;
+	prefix_topk(array, n, k):	select, then sort array[0..k).
+   The comparisons are inlined, which matters when selecting from the
+   thousands of candidates of a query. */
+#define TOPK_SELECT_CUTOFF	16
+
+#define TOPK_SELECT_GENERATE(prefix, type, key)					\
+static inline void prefix##_isort(type *a, cass_size_t n)			\
+{										\
+	cass_size_t i, j;							\
+	type t;									\
+	for (i = 1; i < n; i++) {						\
+		t = a[i];							\
+		for (j = i; j > 0 && t.key < a[j-1].key; j--) a[j] = a[j-1];	\
+		a[j] = t;							\
+	}									\
+}										\
+										\
+/* Hoare partition around the median of three, n >= 3.  Returns p with	\
+   a[0..p) <= a[p..n), both sides non-empty. */					\
+static inline cass_size_t prefix##_partition(type *a, cass_size_t n)		\
+{										\
+	cass_size_t i, j, m = n / 2;						\
+	type t, pivot;								\
+	if (a[m].key < a[0].key) { t = a[m]; a[m] = a[0]; a[0] = t; }		\
+	if (a[n-1].key < a[0].key) { t = a[n-1]; a[n-1] = a[0]; a[0] = t; }	\
+	if (a[n-1].key < a[m].key) { t = a[n-1]; a[n-1] = a[m]; a[m] = t; }	\
+	pivot = a[m];								\
+	i = 0; j = n - 1;							\
+	for (;;) {								\
+		while (a[i].key < pivot.key) i++;				\
+		while (pivot.key < a[j].key) j--;				\
+		if (i >= j) return j + 1;					\
+		t = a[i]; a[i] = a[j]; a[j] = t;				\
+		i++; j--;							\
+	}									\
+}										\
+										\
+static inline void prefix##_sort(type *a, cass_size_t n)			\
+{										\
+	cass_size_t p;								\
+	while (n > TOPK_SELECT_CUTOFF) {					\
+		p = prefix##_partition(a, n);					\
+		if (p < n - p) {						\
+			prefix##_sort(a, p);					\
+			a += p; n -= p;						\
+		}								\
+		else {								\
+			prefix##_sort(a + p, n - p);				\
+			n = p;							\
+		}								\
+	}									\
+	prefix##_isort(a, n);							\
+}										\
+										\
+static inline void prefix##_select(type *a, cass_size_t n, cass_size_t k)	\
+{										\
+	cass_size_t lo = 0, hi = n, p;						\
+	if (k >= n) return;							\
+	while (hi - lo > TOPK_SELECT_CUTOFF) {					\
+		p = lo + prefix##_partition(a + lo, hi - lo);			\
+		if (p == k) return;						\
+		if (p > k) hi = p; else lo = p;					\
+	}									\
+	prefix##_isort(a + lo, hi - lo);					\
+}										\
+										\
+static inline void prefix##_topk(type *a, cass_size_t n, cass_size_t k)	\
+{										\
+	if (k > n) k = n;							\
+	prefix##_select(a, n, k);						\
+	prefix##_sort(a, k);							\
+}
+
 QUICKSORT_PROTOTYPE(ftopk, ftopk_t);
 
 QUICKSORT_PROTOTYPE(ftopk_rev, ftopk_t);
@@ -67,6 +67,7 @@ struct MemArena {
 
 	uint	nblks;
 	uint	nblkalloc;
+	uint	curidx;			/* next block of blktab to reuse */
 	uchar	**blktab;
 };
 
@@ -99,6 +100,7 @@ mkmemarena(void *(*memalloc)(size_t), void *(*memrealloc)(void*, size_t), void (
 	a->free = memfree;
 	a->minallocb = ~0;		/* count down */
 	a->nblks = 0;
+	a->curidx = 0;
 	a->nblkalloc = 1<<3;
 	a->blktab = a->alloc(a->nblkalloc*sizeof(a->blktab[0]));
 	return a;
@@ -120,6 +122,19 @@ freememarena(MemArena *a)
 	return;
 }
 
+/* release every allocation at once, keeping the blocks for reuse */
+void
+resetmemarena(MemArena *a)
+{
+	if(a == NULL)
+		return;
+
+	a->curblk = NULL;
+	a->curend = NULL;
+	a->curidx = 0;
+	return;
+}
+
 void
 memarenastats(MemArena *a)
 {
@@ -162,16 +177,23 @@ memarenamalloc(MemArena *a, unsigned long n)
 			a->totfragb += p - b;
 		if(n > a->blksize)
 			goto Fail;
-		if(a->nblks == a->nblkalloc){
-			a->nblkalloc += 64;
-			tab = a->realloc(a->blktab, a->nblkalloc*sizeof(tab[0]));
-			if(tab == NULL)
+		if(a->curidx < a->nblks){
+			/* a block kept by resetmemarena() */
+			b = a->blktab[a->curidx++];
+		}else{
+			if(a->nblks == a->nblkalloc){
+				a->nblkalloc += 64;
+				tab = a->realloc(a->blktab, a->nblkalloc*sizeof(tab[0]));
+				if(tab == NULL)
+					goto Fail;
+				a->blktab = tab;
+			}
+			b = a->alloc(a->blksize);
+			if(b == NULL)
 				goto Fail;
-			a->blktab = tab;
+			a->blktab[a->nblks++] = b;
+			a->curidx = a->nblks;
 		}
-		b = a->alloc(a->blksize);
-		if(b == NULL)
-			goto Fail;
 		p = b+a->blksize;
 		a->curblk = b;
 		a->curend = p;
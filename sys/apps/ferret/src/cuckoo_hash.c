@@ -40,11 +40,8 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <stdint.h>
 #include <string.h>
-#include <time.h>
-#include <math.h>
-#include <limits.h>
 
 #include <cass.h>
 #include "cuckoo_hash.h"
@@ -53,32 +50,38 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #define __FUNCTION__  "__FUNCTION__"
 #endif
 
-#define MALLOC( type, n ) ( type * )malloc( ( n ) * sizeof( type ) )
 #define MALLOC_ERROR( str1, str2 ) fprintf( stderr, "MALLOC ERROR: In function `%s': could not allocate memory for `%s'\n", str1, str2 ), exit( EXIT_FAILURE )
-#define FATAL_ERROR( str1, str2 ) fprintf( stderr, "FATAL ERROR: In function `%s': %s\n", str1, str2 ), exit( EXIT_FAILURE )
 
 #define TRUE 1
 #define FALSE !TRUE
-#define MAX_FUNCTION_SIZE 256
 #define keycmp( s1, s2 ) strcmp( ( const char * )s1, ( const char * )s2 )
 
-typedef struct {             /* hash table cell type */
-    cass_vecset_id_t vid;
-    char *key;
-    int value;
-} CKHash_Cell;
+/*
+** Bucketized cuckoo hashing with partial-key displacement.
+**
+** Each key (a data object name of the map vtable) hashes to two buckets of
+** CKH_SLOTS slots. A slot keeps the id of the key and a 32-bit tag taken
+** from its hash, so lookups compare tags and only read the key string of a
+** matching tag. The second bucket is derived from the first one and the
+** tag, so moving a key to its other bucket never rehashes the string.
+** A bucket is 32 bytes, two buckets per cache line.
+*/
+
+#define CKH_SLOTS       4
+#define CKH_MAX_KICKS   500
+#define CKH_MAX_LOAD    0.9
+
+typedef struct {
+    uint32_t tag[CKH_SLOTS];          /*  0 = empty slot */
+    cass_id_t vid[CKH_SLOTS];
+} CKHash_Bucket;
 
 struct CKHash_Table_ {
     int size;                         /*  current size */
-    int shift;                        /*  value used for hash function */
-    int table_size;                   /*  size of hash tables */
-    int min_size, mean_size;          /*  rehash trigger sizes */
-    int max_chain;                    /*  max. iterations in insert */
-    CKHash_Cell *T1;                  /*  point to hash table 1 */
-    CKHash_Cell *T2;                  /*  point to hash table 2 */
-    int function_size;                /*  size of hash function */
-    int *a1;                          /*  hash function 1 */
-    int *a2;                          /*  hash function 2 */
+    int table_size;                   /*  number of buckets (power of two) */
+    uint32_t mask;                    /*  table_size - 1 */
+    uint32_t victim;                  /*  rotating slot evicted on collisions */
+    CKHash_Bucket *buckets;
     vtable_t *vtable;
 };
 
@@ -92,252 +95,222 @@ static inline int ckh_get_table_size( CKHash_Table *D )
     return( D->table_size );
 }
 
-static inline void ckh_init( int a[], int function_size )
+/* FNV-1a over the key with a final avalanche (MurmurHash3 fmix64) */
+static inline uint64_t ckh_hash( const char *key )
 {
-    int i;
+    uint64_t h = 14695981039346656037ULL;
 
-    for( i = 0; i < function_size; i++ )
-        a[i] = ( ( int )(rand() * rand()) << 1 ) + 1;
+    for( ; *key; key++ )
+    {
+        h ^= ( unsigned char )*key;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return( h );
 }
 
-static inline void ckh_hash( unsigned long *h, int a[], int function_size, int table_size, int shift, char *key )
+static inline uint32_t ckh_tag( uint64_t h )
 {
-    int i;
+    uint32_t tag = ( uint32_t )( h >> 32 );
+    return( tag ? tag : 1 );
+}
 
-    *h = 0;
-    for( i = 0; key[i]; i++ )
-        *h ^= ( unsigned int )( a[( i % function_size )]* ( unsigned char )key[i] );
-    *h = ( ( unsigned int )*h >> shift ) % table_size;
+static inline uint32_t ckh_alt_bucket( CKHash_Table *D, uint32_t bucket, uint32_t tag )
+{
+    return( ( bucket ^ ( tag * 0x5bd1e995U ) ) & D->mask );
+}
+
+static CKHash_Bucket *ckh_alloc_buckets( int n )
+{
+    void *buckets;
+
+    if( posix_memalign( &buckets, 64, n * sizeof( CKHash_Bucket ) ) != 0 )
+        MALLOC_ERROR( __FUNCTION__, "buckets" );
+    memset( buckets, 0, n * sizeof( CKHash_Bucket ) );
+    return( ( CKHash_Bucket * )buckets );
 }
 
+/* table_size is the expected number of keys */
 CKHash_Table *ckh_alloc_table( int table_size, vtable_t *_vt )
 {
     CKHash_Table *D;
+    int n = 2;
 
-    if( ( D = MALLOC( CKHash_Table, 1 ) ) == NULL )
+    if( ( D = ( CKHash_Table * )malloc( sizeof( CKHash_Table ) ) ) == NULL )
         MALLOC_ERROR( __FUNCTION__, "D" );
-    D->vtable = _vt;
-    D->size = 0;
-    D->table_size = table_size;
-    D->mean_size = 5 * ( 2 * table_size ) / 12;
-    D->min_size = ( 2 * table_size ) / 5;
-    D->shift = 32 - ( int )( log( table_size ) / log( 2 ) + 0.5 );
-    D->max_chain = 4 + ( int )( 4 * log( table_size ) / log( 2 ) + 0.5 );
-
-    if( ( D->T1 = MALLOC( CKHash_Cell, D->table_size ) ) == NULL )
-        MALLOC_ERROR( __FUNCTION__, "D->T1" );
-    if( ( D->T2 = MALLOC( CKHash_Cell, D->table_size ) ) == NULL )
-        MALLOC_ERROR( __FUNCTION__, "D->T2" );
-
-    D->function_size = MAX_FUNCTION_SIZE;
-    if( ( D->a1 = MALLOC( int, D->function_size ) ) == NULL )
-        MALLOC_ERROR( __FUNCTION__, "D->a1" );
-    if( ( D->a2 = MALLOC( int, D->function_size ) ) == NULL )
-        MALLOC_ERROR( __FUNCTION__, "D->a2" );
-
-    ckh_init( D->a1, D->function_size );
-    ckh_init( D->a2, D->function_size );
 
-    int j;
-    for( j = 0; j < D->table_size; j++ )
-    {
-         D->T1[j].vid = D->T2[j].vid = CASS_ID_INV;
-    }
+    while( n * CKH_SLOTS * CKH_MAX_LOAD < table_size )
+        n *= 2;
 
+    D->vtable = _vt;
+    D->size = 0;
+    D->table_size = n;
+    D->mask = n - 1;
+    D->victim = 0;
+    D->buckets = ckh_alloc_buckets( n );
     return( D );
 }
 
-int ckh_rehash_insert( CKHash_Table *D, cass_vecset_id_t vid)
+static inline int ckh_bucket_put( CKHash_Bucket *b, uint32_t tag, cass_id_t vid )
 {
-    unsigned long hkey;
-    int j;
-    CKHash_Cell x, temp;
-    char *vkey;
-    
-    x.vid = vid;
+    int i;
 
-    for( j = 0; j < D->max_chain; j++ ) 
-    {
-	vkey = ARRAY_GET(*(D->vtable), x.vid);	
-        ckh_hash( &hkey, D->a1, D->function_size, D->table_size, D->shift, vkey );
-        temp = D->T1[hkey];
-        D->T1[hkey] = x;
-        if( temp.vid == CASS_ID_INV )
+    for( i = 0; i < CKH_SLOTS; i++ )
+        if( b->tag[i] == 0 )
+        {
+            b->tag[i] = tag;
+            b->vid[i] = vid;
             return( TRUE );
+        }
+    return( FALSE );
+}
 
-        x = temp;
-	vkey = ARRAY_GET(*(D->vtable), x.vid);	
-        ckh_hash( &hkey, D->a2, D->function_size, D->table_size, D->shift, vkey );
-        temp = D->T2[hkey];
-        D->T2[hkey] = x;
-        if( temp.vid == CASS_ID_INV ) 
-            return( TRUE );
+/*
+** Places an id that is not in the table. On failure the table is unchanged
+** except for the id left in *vid / *tag / *bucket, which must be reinserted.
+*/
+static int ckh_place( CKHash_Table *D, uint32_t *bucket, uint32_t *tag, cass_id_t *vid )
+{
+    uint32_t b1 = *bucket, b2 = ckh_alt_bucket( D, b1, *tag );
+    int j;
 
-        x = temp;
-    }
+    if( ckh_bucket_put( &D->buckets[b1], *tag, *vid ) || ckh_bucket_put( &D->buckets[b2], *tag, *vid ) )
+        return( TRUE );
 
-    for( j = 0; j < D->table_size; j++ )
+    /* evict a slot and move its key to its other bucket */
+    for( j = 0; j < CKH_MAX_KICKS; j++ )
     {
-         D->T1[j].vid = D->T2[j].vid = CASS_ID_INV;
+        CKHash_Bucket *b = &D->buckets[b1];
+        int slot = D->victim++ % CKH_SLOTS;
+        uint32_t t = b->tag[slot];
+        cass_id_t v = b->vid[slot];
+
+        b->tag[slot] = *tag;
+        b->vid[slot] = *vid;
+        *tag = t;
+        *vid = v;
+        b1 = ckh_alt_bucket( D, b1, t );
+        *bucket = b1;
+        if( ckh_bucket_put( &D->buckets[b1], *tag, *vid ) )
+            return( TRUE );
     }
-
-    ckh_init( D->a1, D->function_size );
-    ckh_init( D->a2, D->function_size );
-
     return( FALSE );
 }
 
-void ckh_rehash( CKHash_Table *D, int new_size )
+static inline uint32_t ckh_first_bucket( CKHash_Table *D, uint64_t h )
 {
-    CKHash_Table *D_new;
-    int k;
+    return( ( uint32_t )h & D->mask );
+}
 
-    //debug("rehash: %d\n", new_size);
-    D_new = ckh_alloc_table( new_size, D->vtable );
+/* Doubles the table. The keys are rehashed from the vtable, as the tags do
+** not keep the bits of the larger bucket index. */
+static void ckh_grow( CKHash_Table *D )
+{
+    CKHash_Bucket *old = D->buckets;
+    int old_size = D->table_size;
+    int k, i;
 
-    for( k = 0; k < D->table_size; k++ ) 
+    for( ;; )
     {
-        if( ( D->T1[k].vid != CASS_ID_INV ) && ( !ckh_rehash_insert( D_new, D->T1[k].vid ) ) )
-        {
-	    //debug("restart at %d\n", k);
-            k = -1;
-            continue;
-        }
-        if( ( D->T2[k].vid != CASS_ID_INV ) && ( !ckh_rehash_insert( D_new, D->T2[k].vid ) ) ) {
-	    //debug("restart at %d\n", k);
-            k = -1;
-	}
+        int ok = TRUE;
+
+        D->table_size *= 2;
+        D->mask = D->table_size - 1;
+        D->buckets = ckh_alloc_buckets( D->table_size );
+
+        for( k = 0; k < old_size && ok; k++ )
+            for( i = 0; i < CKH_SLOTS && ok; i++ )
+                if( old[k].tag[i] != 0 )
+                {
+                    cass_id_t vid = old[k].vid[i];
+                    uint64_t h = ckh_hash( ARRAY_GET( *( D->vtable ), vid ) );
+                    uint32_t tag = ckh_tag( h ), bucket = ckh_first_bucket( D, h );
+                    ok = ckh_place( D, &bucket, &tag, &vid );
+                }
+        if( ok )
+            break;
+        free( D->buckets );
     }
-
-    free( D->T1 );
-    free( D->T2 );
-    free( D->a1 );
-    free( D->a2 );
-
-    D_new->size = D->size;
-    *D = *D_new;
-    free( D_new );
+    free( old );
 }
 
 int ckh_insert( CKHash_Table *D, cass_id_t vid )
 {
-    unsigned long h1, h2; 
-    int j;
-    CKHash_Cell x, temp;
+    char *vkey = ARRAY_GET( *( D->vtable ), vid );
+    uint64_t h = ckh_hash( vkey );
+    uint32_t tag = ckh_tag( h );
+    uint32_t bucket = ckh_first_bucket( D, h );
+    uint32_t b[2];
+    int i, k;
 
-    char *vkey = ARRAY_GET(*(D->vtable), vid);
     /*
     ** If the element is already in D, return
     */
-    ckh_hash( &h1, D->a1, D->function_size, D->table_size, D->shift, vkey );
-    if( D->T1[h1].vid != CASS_ID_INV )
-        if ( D->T1[h1].vid == vid )
-	    return( FALSE );
-
-    ckh_hash( &h2, D->a2, D->function_size, D->table_size, D->shift, vkey );
-    if( D->T2[h2].vid != CASS_ID_INV )
-        if ( D->T2[h2].vid == vid )
-	    return( FALSE );
-
-    /*
-    ** If not, insert the new element in D.
-    */
-
-    x.vid = vid;
-    for( j = 0; j < D->max_chain; j++ ) 
+    b[0] = bucket;
+    b[1] = ckh_alt_bucket( D, bucket, tag );
+    for( k = 0; k < 2; k++ )
+        for( i = 0; i < CKH_SLOTS; i++ )
+            if( D->buckets[b[k]].tag[i] == tag && D->buckets[b[k]].vid[i] == vid )
+                return( FALSE );
+
+    if( D->size + 1 > D->table_size * CKH_SLOTS * CKH_MAX_LOAD )
     {
-        temp = D->T1[h1];
-        D->T1[h1] = x;
-        if( temp.vid == CASS_ID_INV ) 
-        {
-            D->size++;
-            if( D->table_size < D->size ) 
-                ckh_rehash( D, 2*D->table_size );
-            return( TRUE );
-        }
-
-        x = temp;
-	vkey = ARRAY_GET(*(D->vtable), x.vid);
-        ckh_hash( &h2, D->a2, D->function_size, D->table_size, D->shift, vkey );
-        temp = D->T2[h2];
-        D->T2[h2] = x;
-        if( temp.vid == CASS_ID_INV ) 
-        {
-            D->size++;
-            if( D->table_size < D->size ) 
-                ckh_rehash( D, 2*D->table_size );
-            return( TRUE );
-        }
-
-        x = temp;
-	vkey = ARRAY_GET(*(D->vtable), x.vid);
-        ckh_hash( &h1, D->a1, D->function_size, D->table_size, D->shift, vkey );
+        ckh_grow( D );
+        bucket = ckh_first_bucket( D, h );
     }
 
-    //debug("forced rehashing %s\n", vkey);
-    
     /*
-    ** Forced rehash.
+    ** If not, insert the new element in D. A failed insertion leaves another
+    ** key out, which is rehashed into a larger table.
     */
-    if( D->size < D->mean_size )
-        ckh_rehash( D, D->table_size );
-    else
-        ckh_rehash( D, 2*D->table_size );
-
-    ckh_insert( D, x.vid );
+    while( !ckh_place( D, &bucket, &tag, &vid ) )
+    {
+        uint64_t hv;
 
+        ckh_grow( D );
+        hv = ckh_hash( ARRAY_GET( *( D->vtable ), vid ) );
+        bucket = ckh_first_bucket( D, hv );
+        tag = ckh_tag( hv );
+    }
+    D->size++;
     return( TRUE );
 }
 
-int ckh_lookup( CKHash_Table *D, char *key )
+cass_id_t ckh_get( CKHash_Table *D, char *key )
 {
-    unsigned long hkey;
-    char *vkey;
+    uint64_t h = ckh_hash( key );
+    uint32_t tag = ckh_tag( h );
+    uint32_t b1 = ckh_first_bucket( D, h );
+    uint32_t b2 = ckh_alt_bucket( D, b1, tag );
+    CKHash_Bucket *b;
+    int i;
 
-    ckh_hash( &hkey, D->a1, D->function_size, D->table_size, D->shift, key );
-    if( D->T1[hkey].vid != CASS_ID_INV )
-	vkey = ARRAY_GET(*(D->vtable), D->T1[hkey].vid);
-        if( !keycmp( vkey, key ) )
-            return( TRUE );
+    b = &D->buckets[b1];
+    for( i = 0; i < CKH_SLOTS; i++ )
+        if( b->tag[i] == tag && !keycmp( ARRAY_GET( *( D->vtable ), b->vid[i] ), key ) )
+            return( b->vid[i] );
 
-    ckh_hash( &hkey, D->a2, D->function_size, D->table_size, D->shift, key );
-    if( D->T2[hkey].vid != CASS_ID_INV )
-	vkey = ARRAY_GET(*(D->vtable), D->T2[hkey].vid);
-        if( !keycmp( vkey, key ) )
-             return( TRUE );
+    b = &D->buckets[b2];
+    for( i = 0; i < CKH_SLOTS; i++ )
+        if( b->tag[i] == tag && !keycmp( ARRAY_GET( *( D->vtable ), b->vid[i] ), key ) )
+            return( b->vid[i] );
 
-    return( FALSE );
+    return( CASS_ID_INV );
 }
 
-cass_id_t ckh_get( CKHash_Table *D, char *key ) 
+int ckh_lookup( CKHash_Table *D, char *key )
 {
-    unsigned long hkey;
-    char *vkey;
-    ckh_hash( &hkey, D->a1, D->function_size, D->table_size, D->shift, key );
-    if( D->T1[hkey].vid != CASS_ID_INV ) {
-	vkey = ARRAY_GET(*(D->vtable), D->T1[hkey].vid);
-        if( !keycmp( vkey, key ) )
-            return( D->T1[hkey].vid );
-    }
-
-    ckh_hash( &hkey, D->a2, D->function_size, D->table_size, D->shift, key );
-    if( D->T2[hkey].vid != CASS_ID_INV ) {
-	vkey = ARRAY_GET(*(D->vtable), D->T2[hkey].vid);
-        if( !keycmp( vkey, key ) )
-             return( D->T2[hkey].vid );
-    }
-
-    return( CASS_ID_INV );
+    return( ckh_get( D, key ) != CASS_ID_INV );
 }
 
 CKHash_Table *ckh_destruct_table( CKHash_Table *D )
 {
-    free( D->T1 );
-    free( D->T2 );
-    free( D->a1 );
-    free( D->a2 );
+    free( D->buckets );
     free( D );
 
     return( NULL );
 }
-
@@ -254,7 +254,7 @@ static void LSH_query_bootstrap (LSH_query_t *query, const float *point)
 				entry.dist = dist_L2_float(D, vec->u.float_data, point);
 				C[i]++;
 				query->CC++;
-				TOPK_INSERT_MIN_UNIQ_DO(_topk[i], dist, id, K, entry, H[i]++);
+				TOPK_INSERT_MIN_SORTED_DO(_topk[i], dist, K, entry, H[i]++);
 			}
 		}
 		ARRAY_END_FOREACH;
@@ -313,7 +313,7 @@ static void LSH_query_probe (LSH_query_t *query, const float *point, int l, int
 			query->CC++;
 			entry.id = id;
 			entry.dist = dist_L2_float(D, vec->u.float_data, point);
-			TOPK_INSERT_MIN_UNIQ_DO(topk, dist, id, K, entry, H[l]++);
+			TOPK_INSERT_MIN_SORTED_DO(topk, dist, K, entry, H[l]++);
 		}
 	}
 	ARRAY_END_FOREACH;
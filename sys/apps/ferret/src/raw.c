@@ -110,24 +110,12 @@ static int raw_batch_insert(cass_table_t *table, cass_dataset_t * parent, cass_v
 }
 
 #define MAX_PROB	100
-static int raw_query(cass_table_t *table, cass_query_t *query, cass_result_t *result)
-{
-	struct raw_private *priv = (struct raw_private *)table->__private;
-	cass_dataset_t *ds = &priv->dataset;
-	cass_vec_dist_t *vec_dist;
-	cass_vecset_dist_t *vecset_dist;
-	int r_threshold = param_get_int(query->extra_params, "-R", MAX_PROB);
 
+/* Prepares the result list of a query, returns the size of the user
+ * allocated list (0 if allocated here). */
+static cass_size_t raw_result_init(cass_query_t *query, cass_result_t *result)
+{
 	cass_size_t orig_size;
-	cass_id_t i;
-
-	assert((query->flags & CASS_RESULT_BITMAPS) == 0);
-	assert((query->flags & CASS_RESULT_LISTS) == 0);
-
-	vec_dist = cass_reg_get(&table->env->vec_dist, query->vec_dist_id);
-	assert(vec_dist != NULL);
-	vecset_dist = cass_reg_get(&table->env->vecset_dist, query->vecset_dist_id);
-	assert(vecset_dist != NULL);
 
 	result->flags = CASS_RESULT_LIST | CASS_RESULT_DIST;
 
@@ -153,6 +141,29 @@ static int raw_query(cass_table_t *table, cass_query_t *query, cass_result_t *re
 			ARRAY_INIT(result->u.list);
 		}
 	}
+	return orig_size;
+}
+
+static int raw_query(cass_table_t *table, cass_query_t *query, cass_result_t *result)
+{
+	struct raw_private *priv = (struct raw_private *)table->__private;
+	cass_dataset_t *ds = &priv->dataset;
+	cass_vec_dist_t *vec_dist;
+	cass_vecset_dist_t *vecset_dist;
+	int r_threshold = param_get_int(query->extra_params, "-R", MAX_PROB);
+
+	cass_size_t orig_size;
+	cass_id_t i;
+
+	assert((query->flags & CASS_RESULT_BITMAPS) == 0);
+	assert((query->flags & CASS_RESULT_LISTS) == 0);
+
+	vec_dist = cass_reg_get(&table->env->vec_dist, query->vec_dist_id);
+	assert(vec_dist != NULL);
+	vecset_dist = cass_reg_get(&table->env->vecset_dist, query->vecset_dist_id);
+	assert(vecset_dist != NULL);
+
+	orig_size = raw_result_init(query, result);
 
 
 	if (query->topk > 0)
@@ -265,6 +276,126 @@ static int raw_query(cass_table_t *table, cass_query_t *query, cass_result_t *re
 	return 0;
 }
 
+/* A candidate of a query of the batch: the id of the candidate, the query
+ * and the position in the candidate list of the query. */
+struct raw_batch_entry {
+	cass_vecset_id_t id;
+	uint32_t qry;
+	uint32_t pos;
+};
+
+TOPK_SELECT_GENERATE(raw_batch_entry, struct raw_batch_entry, id)
+
+/* Top-k queries over candidate lists (the rank stage of ferret) share
+ * their candidates: the candidates of all the queries are grouped by id,
+ * so the vectors of a candidate found by several queries are fetched once
+ * and its distances to all of them are computed while they are in cache.
+ * Each query then takes its candidates in its own order, the results are
+ * the same as those of raw_query.  Other queries run one by one. */
+static int raw_batch_query(cass_table_t *table, uint32_t count, cass_query_t **queries, cass_result_t **results)
+{
+	struct raw_private *priv = (struct raw_private *)table->__private;
+	cass_dataset_t *ds = &priv->dataset;
+	cass_vec_dist_t **vec_dist;
+	cass_vecset_dist_t **vecset_dist;
+	struct raw_batch_entry *entries;
+	cass_dist_t *dist;
+	cass_size_t *offset;
+	cass_size_t orig_size, n, i;
+	uint32_t q;
+
+	for (q = 0; q < count; q++)
+	{
+		cass_query_t *query = queries[q];
+		if (query->topk == 0 || query->candidate == NULL ||
+		    (query->candidate->flags & CASS_RESULT_LIST) == 0) break;
+	}
+	if (count < 2 || q < count)
+	{
+		for (q = 0; q < count; q++)
+		{
+			int ret = raw_query(table, queries[q], results[q]);
+			if (ret != 0) return ret;
+		}
+		return 0;
+	}
+
+	vec_dist = type_calloc(cass_vec_dist_t *, count);
+	vecset_dist = type_calloc(cass_vecset_dist_t *, count);
+	offset = type_calloc(cass_size_t, count + 1);
+	n = 0;
+	for (q = 0; q < count; q++)
+	{
+		assert((queries[q]->flags & CASS_RESULT_BITMAPS) == 0);
+		assert((queries[q]->flags & CASS_RESULT_LISTS) == 0);
+		vec_dist[q] = cass_reg_get(&table->env->vec_dist, queries[q]->vec_dist_id);
+		assert(vec_dist[q] != NULL);
+		vecset_dist[q] = cass_reg_get(&table->env->vecset_dist, queries[q]->vecset_dist_id);
+		assert(vecset_dist[q] != NULL);
+		offset[q] = n;
+		n += queries[q]->candidate->u.list.len;
+	}
+	offset[count] = n;
+
+	entries = type_calloc(struct raw_batch_entry, n);
+	dist = type_calloc(cass_dist_t, n);
+
+	/* group the candidates of the batch by id */
+	n = 0;
+	for (q = 0; q < count; q++)
+	{
+		ARRAY_BEGIN_FOREACH(queries[q]->candidate->u.list, cass_list_entry_t cand)
+		{
+			if (cand.id == CASS_ID_MAX) continue;
+			entries[n].id = cand.id;
+			entries[n].qry = q;
+			entries[n].pos = __array_foreach_index;
+			n++;
+		} ARRAY_END_FOREACH;
+	}
+	raw_batch_entry_sort(entries, n);
+
+	for (i = 0; i < n; i++)
+	{
+		cass_query_t *query = queries[entries[i].qry];
+		dist[offset[entries[i].qry] + entries[i].pos] = vecset_dist[entries[i].qry]->__class->dist(ds, entries[i].id, query->dataset, query->vecset_id, vec_dist[entries[i].qry], vecset_dist[entries[i].qry]);
+	}
+
+	for (q = 0; q < count; q++)
+	{
+		cass_query_t *query = queries[q];
+		cass_result_t *result = results[q];
+
+		orig_size = raw_result_init(query, result);
+		assert(result->u.list.size >= query->topk);
+		result->u.list.len = query->topk;
+		TOPK_INIT(result->u.list.data, dist, query->topk, CASS_DIST_MAX);
+		ARRAY_BEGIN_FOREACH(query->candidate->u.list, cass_list_entry_t cand)
+		{
+			cass_list_entry_t entry;
+			if (cand.id == CASS_ID_MAX) continue;
+			entry.id = cand.id;
+			entry.dist = dist[offset[q] + __array_foreach_index];
+			TOPK_INSERT_MIN(result->u.list.data, dist, query->topk, entry);
+		} ARRAY_END_FOREACH;
+		if (query->flags & CASS_RESULT_SORT)
+		{
+			TOPK_SORT_MIN(result->u.list.data, cass_list_entry_t, dist, query->topk);
+			result->flags |= CASS_RESULT_SORT;
+		}
+
+		if (orig_size == 0) result->flags |= CASS_RESULT_MALLOC;
+		else if (result->u.list.size > orig_size) result->flags |= CASS_RESULT_REALLOC;
+	}
+
+	free(dist);
+	free(entries);
+	free(offset);
+	free(vecset_dist);
+	free(vec_dist);
+	return 0;
+}
+
 /* this function is used for multiple oprs, and is thus not static */
 /*
 int raw_drop(cass_table_t *table)
@@ -301,7 +432,7 @@ cass_table_opr_t opr_raw = {
 	.init_private = raw_init_private,
 	.batch_insert = raw_batch_insert,
 	.query = raw_query,
-	.batch_query = NULL,
+	.batch_query = raw_batch_query,
 	.load = raw_load,
 	.release = raw_release,
 	.checkpoint_private = raw_checkpoint_private,
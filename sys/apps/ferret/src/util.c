@@ -241,11 +241,15 @@ static inline int __cass_list_entry_rev_ge (cass_list_entry_t a, cass_list_entry
 
 QUICKSORT_GENERATE(__cass_list_entry, cass_list_entry_t);
 
+TOPK_SELECT_GENERATE(__cass_list_entry_id, cass_list_entry_t, id)
+
 cass_result_t *
 cass_result_merge_lists (cass_result_t *src, cass_dataset_t *ds, int32_t topk)
 {
     cass_result_t *merged_result;
-    int merged_topk;
+    cass_list_entry_t *data;
+    cass_list_entry_t entry;
+    int merged_topk, n, u, i;
 
     assert((src->flags & CASS_RESULT_BITMAPS) == 0);
     assert((src->flags & CASS_RESULT_BITMAP) == 0);
@@ -264,12 +268,16 @@ cass_result_merge_lists (cass_result_t *src, cass_dataset_t *ds, int32_t topk)
 
 //    ARRAY_INIT_SIZE(merged_result->u.list, merged_topk);
     merged_result->u.list.len = merged_topk;
-    TOPK_INIT(merged_result->u.list.data, id, merged_topk, CASS_ID_MAX);
+    data = merged_result->u.list.data;
+
+    /* Gather the parents of all the candidate regions, then sort and
+     * deduplicate them at once instead of a unique top-k insertion per
+     * candidate, which is quadratic in the number of candidates. */
+    n = 0;
     ARRAY_BEGIN_FOREACH(src->u.lists, cass_list_t p)
     {
 	ARRAY_BEGIN_FOREACH(p, cass_list_entry_t p2){
 	    cass_vec_t *vec;
-	    cass_list_entry_t entry;
 
 //	    assert(p2.id >= 0 && p2.id <= ds->max_vec);
 	    if (p2.id < 0 || p2.id > ds->max_vec)
@@ -278,13 +286,30 @@ cass_result_merge_lists (cass_result_t *src, cass_dataset_t *ds, int32_t topk)
 		    continue;
 	    }
 	    vec = (void *)ds->vec + ds->vec_size * p2.id;
-	    entry.id = vec->parent;
-	    entry.dist = 0;
-	    //ARRAY_APPEND(merged_result->u.list, entry);
-	    TOPK_INSERT_MIN_UNIQ(merged_result->u.list.data, id, id, merged_topk, entry);
-	    //TOPK_INSERT_MIN(merged_result->u.list.data, id, merged_topk, entry);
+	    data[n].id = vec->parent;
+	    data[n].dist = 0;
+	    n++;
 	}ARRAY_END_FOREACH;
     }ARRAY_END_FOREACH;
+
+    __cass_list_entry_id_sort(data, n);
+    u = 0;
+    for (i = 0; i < n; i++)
+    {
+	if (u > 0 && data[u-1].id == data[i].id) continue;
+	data[u++] = data[i];
+    }
+
+    /* Same layout as the top-k array: the unique ids in descending order
+     * at the end, CASS_ID_MAX in the unused slots in front. */
+    for (i = 0; i < u / 2; i++)
+    {
+	entry = data[i];
+	data[i] = data[u-1-i];
+	data[u-1-i] = entry;
+    }
+    memmove(data + merged_topk - u, data, u * sizeof(*data));
+    TOPK_INIT(data, id, merged_topk - u, CASS_ID_MAX);
     merged_result->flags |= CASS_RESULT_MALLOC;
     return merged_result;
 }
@@ -0,0 +1,107 @@
+/* AUTORIGHTS
+Copyright (C) 2007 Princeton University
+
+This file is part of Ferret Toolkit.
+
+Ferret Toolkit is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2, or (at your option)
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include <cass.h>
+#include <time.h>
+
+/* Microbenchmark of the data object map (cuckoo hash): loading n names,
+ * name -> id lookups (hits and misses) and id -> name translation. */
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void make_name (char *buf, uint32_t i, int miss)
+{
+	/* names shaped like the image paths of a ferret database */
+	snprintf(buf, BUFSIZ, "%s/%08x/img_%u.jpg", miss ? "missing" : "corel", i * 2654435761U, i);
+}
+
+int main (int argc, char *argv[])
+{
+	cass_map_t *map;
+	cass_vecset_id_t id;
+	char buf[BUFSIZ];
+	char *name;
+	uint32_t n, lookups, i, found;
+	double start, elapsed;
+	int ret;
+
+	if (argc < 2)
+	{
+		printf("Benchmark the data object map of cass.\n"
+				"usage:\n\t%s <n> [lookups]\n"
+				"\t<n> -- number of data objects.\n"
+				"\t[lookups] -- number of lookups of each kind (default n).\n", argv[0]);
+		return 0;
+	}
+	n = atoi(argv[1]);
+	lookups = (argc > 2) ? atoi(argv[2]) : n;
+	if (n == 0) return 0;
+
+	ret = cass_map_create(&map, NULL, "bench", 0);
+	if (ret != 0) { printf("ERROR: %s\n", cass_strerror(ret)); return 0; }
+
+	start = now();
+	for (i = 0; i < n; i++)
+	{
+		make_name(buf, i, 0);
+		cass_map_insert(map, &id, buf);
+		assert(id == i);
+	}
+	elapsed = now() - start;
+	printf("insert      %10u  %8.1f ns/op\n", n, elapsed * 1e9 / n);
+
+	found = 0;
+	start = now();
+	for (i = 0; i < lookups; i++)
+	{
+		make_name(buf, (i * 7919U) % n, 0);
+		if (cass_map_dataobj_to_id(map, buf, &id) == 0) found++;
+	}
+	elapsed = now() - start;
+	printf("lookup hit  %10u  %8.1f ns/op  (%u found)\n", lookups, elapsed * 1e9 / lookups, found);
+	assert(found == lookups);
+
+	found = 0;
+	start = now();
+	for (i = 0; i < lookups; i++)
+	{
+		make_name(buf, i, 1);
+		if (cass_map_dataobj_to_id(map, buf, &id) == 0) found++;
+	}
+	elapsed = now() - start;
+	printf("lookup miss %10u  %8.1f ns/op  (%u found)\n", lookups, elapsed * 1e9 / lookups, found);
+
+	start = now();
+	for (i = 0; i < lookups; i++)
+	{
+		cass_map_id_to_dataobj(map, (i * 7919U) % n, &name);
+		assert(name != NULL);
+	}
+	elapsed = now() - start;
+	printf("id to name  %10u  %8.1f ns/op\n", lookups, elapsed * 1e9 / lookups);
+
+	map->dirty = 0;
+	cass_map_release(map);
+	return 0;
+}
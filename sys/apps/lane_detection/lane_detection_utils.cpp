@@ -55,9 +55,12 @@
  */
 
 #include <lane_detection_utils.hpp>
+#include <map>
 
 namespace spb{
 bool stream_end = false;
+
+ItemPool<Item> item_pool;
 std::vector<cv::Mat> MemData; //vector to store data in-memory
 
 cv::VideoWriter oVideoWriter;
@@ -78,9 +81,169 @@ void set_operators_name(){
 	//return operator_name_list;
 }
 
+/* Long options of the operator isolation harness, out of the range of the short ones */
+enum { OPT_CAPTURE = 256, OPT_REPLAY, OPT_ROUNDS };
+
+FILE * capture_file = NULL;
+static const char capture_magic[] = "SPBCAP01";
+
+// function-local, so operators can register from static initializers
+std::map<std::string, replay_operator_t> &replay_operators(){
+	static std::map<std::string, replay_operator_t> operators;
+	return operators;
+}
+
+bool register_replay_operator(const std::string &name, replay_operator_t op){
+	replay_operators()[name] = op;
+	return true;
+}
+
+/* Matrices are written row by row, an ROI is not continuous */
+static void write_mat(const cv::Mat &mat, FILE * file){
+	int header[3] = {mat.rows, mat.cols, mat.type()};
+	size_t row_size = mat.cols * mat.elemSize();
+	fwrite(header, sizeof(int), 3, file);
+	for(int r = 0; r < mat.rows; r++)
+		fwrite(mat.ptr(r), 1, row_size, file);
+}
+
+static bool read_mat(cv::Mat &mat, FILE * file){
+	int header[3];
+	if(fread(header, sizeof(int), 3, file) != 3 || header[0] < 0 || header[1] < 0)
+		return false;
+	mat.create(header[0], header[1], header[2]);
+	size_t row_size = mat.cols * mat.elemSize();
+	for(int r = 0; r < mat.rows; r++)
+		if(fread(mat.ptr(r), 1, row_size, file) != row_size)
+			return false;
+	return true;
+}
+
+/**
+ * Capture batch
+ *
+ * Writes a batch entering an operator to the capture file.
+ * Batches are written in the order they enter the operator, which may differ
+ * from the stream order in the parallel versions.
+ * Format: magic, operator name, then for each batch its size and, for each
+ * item, index, the imgROI and contours matrices and the lines found so far,
+ * which is what HoughT reads.
+ *
+ * @param operator_name operator receiving the batch
+ * @param item batch to be written
+ * @return nothing.
+ */
+void capture_batch(const std::string &operator_name, const Item &item){
+	// parallel versions capture from several replicas at a time
+	static std::mutex capture_mutex;
+	std::lock_guard<std::mutex> lock(capture_mutex);
+	static bool header = false;
+	if(!header){
+		unsigned int name_size = operator_name.size();
+		fwrite(capture_magic, 1, sizeof(capture_magic), capture_file);
+		fwrite(&name_size, sizeof(name_size), 1, capture_file);
+		fwrite(operator_name.c_str(), 1, name_size, capture_file);
+		header = true;
+	}
+	int batch_size = item.batch_size;
+	fwrite(&batch_size, sizeof(batch_size), 1, capture_file);
+	for(int i = 0; i < batch_size; i++){
+		const item_data &data = item.item_batch[i];
+		unsigned int lines = data.lines.size();
+		fwrite(&data.index, sizeof(data.index), 1, capture_file);
+		write_mat(data.imgROI, capture_file);
+		write_mat(data.contours, capture_file);
+		fwrite(&lines, sizeof(lines), 1, capture_file);
+		fwrite(data.lines.data(), sizeof(cv::Vec2f), lines, capture_file);
+	}
+}
+
+/**
+ * Replay
+ *
+ * Loads the batches of a capture file and replays them through the captured
+ * operator alone, with 1, 2, 4, ... up to nthreads independent threads.
+ *
+ * @param file_name capture file
+ * @param rounds times each thread replays all the batches
+ * @return 0 on success.
+ */
+int replay_main(const char * file_name, unsigned int rounds){
+	FILE * file = fopen(file_name, "rb");
+	if(file == NULL){
+		std::cerr << " Error: could not open capture file " << file_name << std::endl;
+		return 1;
+	}
+
+	char magic[sizeof(capture_magic)];
+	unsigned int name_size = 0;
+	if(fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, capture_magic, sizeof(magic)) != 0
+		|| fread(&name_size, sizeof(name_size), 1, file) != 1 || name_size > 256){
+		std::cerr << " Error: " << file_name << " is not a capture file" << std::endl;
+		fclose(file);
+		return 1;
+	}
+	std::string operator_name(name_size, ' ');
+	if(fread(&operator_name[0], 1, name_size, file) != name_size){
+		std::cerr << " Error: " << file_name << " is not a capture file" << std::endl;
+		fclose(file);
+		return 1;
+	}
+	if(replay_operators().count(operator_name) == 0){
+		std::cerr << " Error: operator " << operator_name << " cannot be replayed by this benchmark" << std::endl;
+		fclose(file);
+		return 1;
+	}
+	replay_operator_t op = replay_operators()[operator_name];
+
+	// load the captured batches
+	std::vector<Item> batches;
+	int batch_size;
+	while(fread(&batch_size, sizeof(batch_size), 1, file) == 1){
+		Item item;
+		item.batch_size = batch_size;
+		for(int i = 0; i < batch_size; i++){
+			item_data data;
+			unsigned int lines = 0;
+			if(fread(&data.index, sizeof(data.index), 1, file) != 1 || !read_mat(data.imgROI, file) || !read_mat(data.contours, file)
+				|| fread(&lines, sizeof(lines), 1, file) != 1){
+				std::cerr << " Error: truncated capture file " << file_name << std::endl;
+				exit(-1);
+			}
+			data.lines.resize(lines);
+			if(fread(data.lines.data(), sizeof(cv::Vec2f), lines, file) != lines){
+				std::cerr << " Error: truncated capture file " << file_name << std::endl;
+				exit(-1);
+			}
+			item.item_batch.push_back(data);
+		}
+		batches.push_back(item);
+	}
+	fclose(file);
+
+	// the operators only read the matrices, which the copies share
+	auto prepare = [](const Item &batch){
+		Item item;
+		item.batch_size = batch.batch_size;
+		item.item_batch = batch.item_batch;
+		return item;
+	};
+	auto release = [](Item &item){};
+
+	std::vector<replay_result_t> results;
+	std::vector<unsigned int> thread_counts = replay_thread_counts(nthreads);
+	for(unsigned int i = 0; i < thread_counts.size(); i++)
+		results.push_back(replay_operator(batches, thread_counts[i], rounds, prepare, op, release));
+	print_replay(operator_name, results);
+	return 0;
+}
+
 void usage(std::string name){
 	fprintf(stderr, "Usage: %s\n", name.c_str());
 	fprintf(stderr, "  -i, --input            <input_video> (mandatory)\n");
+	fprintf(stderr, "      --capture          <file> write the batches entering the HoughT operator to <file>\n");
+	fprintf(stderr, "      --replay           <file> replay the batches of a capture file through the operator alone, with 1 to -t threads\n");
+	fprintf(stderr, "      --rounds           <n> times each thread replays the captured batches (default 1)\n");
 	printGeneralUsage();
 	exit(-1);
 }
@@ -88,14 +251,23 @@ void usage(std::string name){
 void init_bench(int argc, char* argv[]){
 
 	std::string input;
+	std::string replay_file;
+	unsigned int replay_rounds = 1;
 	int opt = 0;
 	int opt_index = 0;
 
 	if(argc < 2) usage(argv[0]);
 
+	// SPBench options plus the ones of the operator isolation harness
+	std::vector<struct option> lane_long_opts(long_opts, long_opts + sizeof(long_opts)/sizeof(long_opts[0]) - 1);
+	lane_long_opts.push_back({"capture", REQUIRED, 0, OPT_CAPTURE});
+	lane_long_opts.push_back({"replay", REQUIRED, 0, OPT_REPLAY});
+	lane_long_opts.push_back({"rounds", REQUIRED, 0, OPT_ROUNDS});
+	lane_long_opts.push_back({0, 0, 0, 0});
+
 	try {
 		//while ((opt = getopt(argc,argv,"i:t:b:B:m:M:F:u:p:klfxrh")) != EOF){
-			while ((opt = getopt_long(argc, argv, "i:t:b:B:m:M:f:F:IlLTru:h", long_opts, &opt_index)) != -1) {
+			while ((opt = getopt_long(argc, argv, "i:t:b:B:m:M:f:F:IlLTru:q:A:Os:R:Uh", lane_long_opts.data(), &opt_index)) != -1) {
 			switch(opt){
 				case 'i':
 					input = optarg;
@@ -148,9 +320,44 @@ void init_bench(int argc, char* argv[]){
 				case 'r':
 					Metrics::enable_upl();
 					break;
+				case 'q':
+					if (atoi(optarg) <= 0)
+						throw std::invalid_argument("\n ARGUMENT ERROR (-q <queue_capacity>) --> Queue capacity must be an integer value higher than zero!\n");
+					SPBench::setQueueCapacity(atoi(optarg));
+					break;
+				case 'A':
+					if (atof(optarg) < 0.0)
+						throw std::invalid_argument("\n ARGUMENT ERROR (-A <max_latency_ms>) --> Latency constraint can not be negative!\n");
+					SPBench::enable_tuning(atof(optarg));
+					break;
+				case 'O':
+					SPBench::enable_open_loop();
+					break;
+				case 's':
+					SPBench::setSampling(atof(optarg));
+					break;
+				case 'R':
+					SPBench::setRuntimeOptions(optarg);
+					break;
+				case 'U':
+					SPBench::setOrdered(false);
+					break;
 				case 'u':
 					SPBench::setArg(optarg);
 					break;
+				case OPT_CAPTURE:
+					capture_file = fopen(optarg, "wb");
+					if (capture_file == NULL)
+						throw std::invalid_argument("\n ERROR in --capture --> Could not create capture file: " + std::string(optarg) + "\n");
+					break;
+				case OPT_REPLAY:
+					replay_file = optarg;
+					break;
+				case OPT_ROUNDS:
+					if (atoi(optarg) < 1)
+						throw std::invalid_argument("\n ARGUMENT ERROR (--rounds <n>) --> Rounds must be an integer value higher than zero!\n");
+					replay_rounds = atoi(optarg);
+					break;
 				case 'h':
 					usage(argv[0]);
 					break;
@@ -174,6 +381,10 @@ void init_bench(int argc, char* argv[]){
 
 	SPBench::bench_path = argv[0];
 
+	// replay a captured operator in isolation, no input video involved
+	if(!replay_file.empty())
+		exit(replay_main(replay_file.c_str(), replay_rounds));
+
 	capture.open(input);
 
 	//if this fails, try to open as a video camera, through the use of an integer param
@@ -201,6 +412,8 @@ void init_bench(int argc, char* argv[]){
 
 	set_operators_name();
 	Metrics::enable_latency();
+	// one item per batch in flight, Source::op grows it for the tuned limit
+	item_pool.reserve(SPBench::getQueueCapacity() > 0 ? SPBench::getQueueCapacity() : nthreads*10);
 	
 	if(Metrics::monitoring_thread_is_enabled()){
 		Metrics::start_monitoring();
@@ -220,11 +433,21 @@ void end_bench(){
 		if(!MemData.empty())
 			MemData.erase(MemData.begin(), MemData.end());
 	}
+
+	item_pool.print_stats();
+
+	if(capture_file != NULL){
+		if(ftell(capture_file) == 0)
+			fprintf(stderr, " Warning: no batches captured by this benchmark.\n");
+		fclose(capture_file);
+	}
 }
 
 long Source::source_item_timestamp = current_time_usecs();
 
 bool Source::op(Item &item){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	//if last batch included the last item, ends computation
 	if(stream_end == true){
@@ -234,11 +457,15 @@ bool Source::op(Item &item){
 	// frequency control mechanism
 	SPBench::item_frequency_control(source_item_timestamp);
 
-	item.timestamp = source_item_timestamp = current_time_usecs();
+	// the clock is read only if the timestamps of the batch are used
+	if(SPBench::source_timing_is_enabled())
+		source_item_timestamp = current_time_usecs();
 	unsigned long batch_elapsed_time = source_item_timestamp;
 	
+	// the batch carries the sampling decision to the operators
+	item.sampled = SPBench::batch_sampling();
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = source_item_timestamp;
 	}
 
@@ -284,7 +511,20 @@ bool Source::op(Item &item){
 		return false;
 	}
 
-	if(Metrics::latency_is_enabled()){
+	// only emitted batches take an in-flight slot and count in the open-loop schedule
+	unsigned long emission_time = source_item_timestamp;
+	if(SPBench::tuning_is_enabled()){
+		// the tuned limit grows up to the largest capacity asked by the runtime
+		if(Metrics::batch_counter == 0)
+			item_pool.reserve(SPBench::getTuningMaxLimit() + 1);
+		SPBench::in_flight_control();
+		// the wait for a slot is not part of the latency of the batch
+		emission_time = current_time_usecs();
+	}
+	// in open-loop mode the latency counts from the scheduled arrival time
+	item.timestamp = SPBench::item_arrival_time(emission_time);
+
+	if(Metrics::operator_latency_is_enabled(item)){
 		item.latency_op.push_back(current_time_usecs() - latency_op);
 	}
 
@@ -295,9 +535,11 @@ bool Source::op(Item &item){
 }
 
 void Sink::op(Item &item){
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}
 	
@@ -315,11 +557,14 @@ void Sink::op(Item &item){
 		Metrics::items_at_sink_counter += item.batch_size;
 	}
 	
+	SPBench::in_flight_release(item.timestamp, item.batch_size);
 	Metrics::batches_at_sink_counter++;
 
 	if(Metrics::latency_is_enabled()){
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		Metrics::global_latency_acc += total_item_latency; // to compute real time average latency
@@ -113,8 +113,25 @@ public:
 	Item():Batch(NUMBER_OF_OPERATORS){};
 
 	~Item(){}
+
+	void recycle(){
+		Batch::recycle();
+		item_batch.clear();
+	}
 };
 
+extern ItemPool<Item> item_pool;
+
+/* Operator isolation harness (--capture=<file> and --replay=<file>).
+ * Operators register themselves to be replayed and write the batches
+ * entering them to the capture file (see templates/operators/include).
+ * The n-source versions (lane_detection_utils_ns) do not support them.
+ */
+typedef void (*replay_operator_t)(Item &item);
+bool register_replay_operator(const std::string &name, replay_operator_t op);
+extern FILE * capture_file;
+void capture_batch(const std::string &operator_name, const Item &item);
+
 class Source{
 public:
 	static long source_item_timestamp;
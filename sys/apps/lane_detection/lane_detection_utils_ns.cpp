@@ -92,6 +92,7 @@ void usage(std::string name){
 	fprintf(stderr, "\t-m\t: monitors latency, throughput, and CPU and memory usage.\n");
 	fprintf(stderr, "\t-T\t: print average throughput results\n");
 	fprintf(stderr, "\t-r\t: print memory consumption results generated by UPL library\n");
+	fprintf(stderr, "\t-s\t: <n|rate> per-operator latency of one batch every n batches, or of each batch with probability rate (0-1)\n");
 	fprintf(stderr, "\t-u\t: send a custom argument to be used inside your programm\n");
 	fprintf(stderr, "\t-h\t: print this help message\n");
 	exit(-1);
@@ -101,7 +102,7 @@ void init_bench(int argc, char* argv[]){
 
 	std::string input;
 	int opt;
-	while ((opt = getopt(argc,argv,"i:t:b:B:m:f:u:IlLTrh")) != EOF){
+	while ((opt = getopt(argc,argv,"i:t:b:B:m:f:u:IlLTrs:h")) != EOF){
 		switch(opt){
 			case 'i':
 				if(!file_exists(optarg)){
@@ -146,6 +147,9 @@ void init_bench(int argc, char* argv[]){
 			case 'r':
 				Metrics::enable_upl();
 				break;
+			case 's':
+				SPBench::setSampling(atof(optarg));
+				break;
 			case 'u':
 				SPBench::setArg(optarg);
 				break;
@@ -183,12 +187,17 @@ void Source::printStatus(){
 	else
 		std::cout << "    Input frequency: " << sourceFrequency << " items per second" << std::endl;
 
+	if(sourceFreqPatt.pattern != "none")
+		std::cout << "  Frequency pattern: " << sourceFreqPatt.pattern << std::endl;
+
 	if(SPBench::memory_source_is_enabled())
 		std::cout << "In-memory execution: enabled" << std::endl;
 	std::cout << "\n###############################################" << std::endl;
 }
 
 void Source::source_op(){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 	
 	if(!file_exists(IO_data_vec[sourceId].inputFile)){
 		printf("Invalid input file! Check if the file exists or run with -h for more details.\n");
@@ -242,14 +251,15 @@ void Source::source_op(){
 		}
 
 		// frequency control mechanism
-		item_frequency_control(source_item_timestamp, sourceFrequency);
+		frequencyControl(source_item_timestamp);
 
 		item.timestamp = source_item_timestamp = current_time_usecs();
 		unsigned long batch_elapsed_time = source_item_timestamp;
 		
 		unsigned long latency_op;
 		item.timestamp = current_time_usecs();
-		if(Metrics::latency_is_enabled()){
+		item.sampled = sample_batch(sourceSampling);
+		if(Metrics::operator_latency_is_enabled(item)){
 			latency_op = current_time_usecs();
 		}
 		
@@ -294,7 +304,7 @@ void Source::source_op(){
 			break;
 		}
 
-		if(Metrics::latency_is_enabled()){
+		if(Metrics::operator_latency_is_enabled(item)){
 			item.latency_op.push_back(current_time_usecs() - latency_op);
 		}
 
@@ -312,11 +322,13 @@ void Source::source_op(){
 }
 
 void Sink::op(Item &item){
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 	if(item.empty())
 		return;
 
 	volatile unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}
 
@@ -341,7 +353,9 @@ void Sink::op(Item &item){
 	}
 	if(Metrics::latency_is_enabled()){
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		volatile unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		metrics_vec[item.sourceId].global_latency_acc += total_item_latency; // to compute real time average latency
@@ -355,6 +369,9 @@ void Sink::op(Item &item){
 		metrics_vec[item.sourceId].stop_throughput_clock = current_time_sink;
 		item.latency_op.clear();
 	}
+	else if(Metrics::throughput_is_enabled()){
+		metrics_vec[item.sourceId].stop_throughput_clock = current_time_usecs();
+	}
 }
 
 void end_bench(){
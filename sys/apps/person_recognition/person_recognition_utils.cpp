@@ -27,6 +27,8 @@ workload_data input_data;
 
 bool stream_end = false;
 
+ItemPool<Item> item_pool;
+
 void set_operators_name();
 void read_training_set(const std::string &, std::vector<cv::Mat> &);
 inline void usage(std::string);
@@ -69,7 +71,7 @@ void init_bench(int argc, char* argv[]){
 
 	try {
 		//while ((opt = getopt(argc,argv,"i:t:b:B:m:M:F:u:p:klfxrh")) != EOF){
-		while ((opt = getopt_long(argc, argv, "i:t:b:B:m:M:f:F:IlLTru:h", long_opts, &opt_index)) != -1) {
+		while ((opt = getopt_long(argc, argv, "i:t:b:B:m:M:f:F:IlLTru:q:A:Os:R:Uh", long_opts, &opt_index)) != -1) {
 			switch(opt){
 				case 'i':
 					if(split_string(optarg, ' ').size() < 3) 
@@ -124,6 +126,28 @@ void init_bench(int argc, char* argv[]){
 				case 'r':
 					Metrics::enable_upl();
 					break;
+				case 'q':
+					if (atoi(optarg) <= 0)
+						throw std::invalid_argument("\n ARGUMENT ERROR (-q <queue_capacity>) --> Queue capacity must be an integer value higher than zero!\n");
+					SPBench::setQueueCapacity(atoi(optarg));
+					break;
+				case 'A':
+					if (atof(optarg) < 0.0)
+						throw std::invalid_argument("\n ARGUMENT ERROR (-A <max_latency_ms>) --> Latency constraint can not be negative!\n");
+					SPBench::enable_tuning(atof(optarg));
+					break;
+				case 'O':
+					SPBench::enable_open_loop();
+					break;
+				case 's':
+					SPBench::setSampling(atof(optarg));
+					break;
+				case 'R':
+					SPBench::setRuntimeOptions(optarg);
+					break;
+				case 'U':
+					SPBench::setOrdered(false);
+					break;
 				case 'u':
 					SPBench::setArg(optarg);
 					break;
@@ -190,6 +214,8 @@ void init_bench(int argc, char* argv[]){
 
 	set_operators_name();
 	Metrics::enable_latency();
+	// one item per batch in flight, Source::op grows it for the tuned limit
+	item_pool.reserve(SPBench::getQueueCapacity() > 0 ? SPBench::getQueueCapacity() : nthreads*10);
 
 	if(Metrics::monitoring_thread_is_enabled()){
 		Metrics::start_monitoring();
@@ -206,6 +232,8 @@ void set_operators_name(){
 long Source::source_item_timestamp = current_time_usecs();
 
 bool Source::op(Item &item){
+	static AllocOperator alloc_operator("Source");
+	AllocScope alloc_scope(alloc_operator);
 
 	//if last batch included the last item, ends computation
 	if(stream_end == true){
@@ -215,11 +243,15 @@ bool Source::op(Item &item){
 	// frequency control mechanism
 	SPBench::item_frequency_control(source_item_timestamp);
 
-	item.timestamp = source_item_timestamp = current_time_usecs();
+	// the clock is read only if the timestamps of the batch are used
+	if(SPBench::source_timing_is_enabled())
+		source_item_timestamp = current_time_usecs();
 	unsigned long batch_elapsed_time = source_item_timestamp;
 	
+	// the batch carries the sampling decision to the operators
+	item.sampled = SPBench::batch_sampling();
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = source_item_timestamp;
 	}
 
@@ -266,7 +298,20 @@ bool Source::op(Item &item){
 		return false;
 	}
 
-	if(Metrics::latency_is_enabled()){
+	// only emitted batches take an in-flight slot and count in the open-loop schedule
+	unsigned long emission_time = source_item_timestamp;
+	if(SPBench::tuning_is_enabled()){
+		// the tuned limit grows up to the largest capacity asked by the runtime
+		if(Metrics::batch_counter == 0)
+			item_pool.reserve(SPBench::getTuningMaxLimit() + 1);
+		SPBench::in_flight_control();
+		// the wait for a slot is not part of the latency of the batch
+		emission_time = current_time_usecs();
+	}
+	// in open-loop mode the latency counts from the scheduled arrival time
+	item.timestamp = SPBench::item_arrival_time(emission_time);
+
+	if(Metrics::operator_latency_is_enabled(item)){
 		//item.latency_op.push_back(current_time_usecs() - latency_op);
 		item.latency_op.push_back(current_time_usecs() - latency_op);
 	}
@@ -277,9 +322,11 @@ bool Source::op(Item &item){
 }
 
 void Sink::op(Item &item){
+	static AllocOperator alloc_operator("Sink");
+	AllocScope alloc_scope(alloc_operator);
 	
 	unsigned long latency_op;
-	if(Metrics::latency_is_enabled()){
+	if(Metrics::operator_latency_is_enabled(item)){
 		latency_op = current_time_usecs();
 	}	
 	
@@ -297,11 +344,14 @@ void Sink::op(Item &item){
 		Metrics::items_at_sink_counter += item.batch_size;
 	}
 	
+	SPBench::in_flight_release(item.timestamp, item.batch_size);
 	Metrics::batches_at_sink_counter++;
 
 	if(Metrics::latency_is_enabled()){
 		double current_time_sink = current_time_usecs();
-		item.latency_op.push_back(current_time_sink - latency_op);
+		if(Metrics::operator_latency_is_enabled(item)){
+			item.latency_op.push_back(current_time_sink - latency_op);
+		}
 
 		unsigned long total_item_latency = (current_time_sink - item.timestamp);
 		Metrics::global_latency_acc += total_item_latency; // to compute real time average latency
@@ -329,6 +379,8 @@ void end_bench(){
 		if(!MemData.empty())
 			MemData.erase(MemData.begin(), MemData.end());
 	}
+
+	item_pool.print_stats();
 }
 
 void read_training_set(const std::string &list_path, std::vector<cv::Mat> &images) {
@@ -117,8 +117,15 @@ public:
 	Item():Batch(NUMBER_OF_OPERATORS){};
 
 	~Item(){}
+
+	void recycle(){
+		Batch::recycle();
+		item_batch.clear();
+	}
 };
 
+extern ItemPool<Item> item_pool;
+
 class Source{
 public:
 	static long source_item_timestamp;
@@ -20,6 +20,9 @@ int main (int argc, char* argv[]){
 	source2.setBatchInterval(0.5); // 500 ms batch window
 	source2.setQueueMaxSize(3); // 3 slots in this source's queue
 	source2.setFrequency(30); // 30 items per second
+	// Optional: pattern owned by this source <pattern, period, min, max, spike, phase>
+	// e.g. a wave between 10 and 30 items per second, 5 seconds ahead of other sources
+	//source2.setFrequencyPattern("wave", 20, 10, 30, 10, 5);
 	
 	// You must use the init() method to run this source
 	source2.init();